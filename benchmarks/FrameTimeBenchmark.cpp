@@ -0,0 +1,321 @@
+// Project includes
+#include "VulkanRenderer/Application.h"
+
+// Vendors includes
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <fmt/format.h>
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /** The animation advances by the same time every frame, so every run renders exactly the same frames */
+    const float FIXED_TIME_STEP = 1.0f / 60.0f;
+
+    struct Options
+    {
+        uint32_t warmUpFrames = 100;
+        uint32_t measuredFrames = 1000;
+        int width = 800;
+        int height = 600;
+        uint32_t drawCount = 1;
+        uint32_t instanceCount = 1;
+        bool isParallelRecordingEnabled = true;
+        bool isGpuDriven = false;
+        bool isCpuCullingEnabled = false;
+        uint32_t framesInFlight = vr::Vulkan::DEFAULT_FRAMES_IN_FLIGHT;
+        std::string outputPath;
+    };
+
+    struct FrameTimeStatistics
+    {
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+    };
+
+    void PrintUsage()
+    {
+        spdlog::info(
+            "Usage: FrameTimeBenchmark [--warmup <frames>] [--frames <frames>] [--width <pixels>] [--height <pixels>] [--draws <count>] [--instances <count>] [--single-threaded-recording] [--gpu-driven] [--cpu-culling] [--frames-in-flight <1-4>] [--output <path.json>]\n"
+            "--draws splits the model into many draws, to measure the draw recording and submission overhead.\n"
+            "--instances draws that many copies of the model with every draw, to measure the instanced rendering throughput.\n"
+            "--gpu-driven culls the instances in a compute shader and draws the visible ones indirectly.\n"
+            "--cpu-culling culls the instances on the CPU with SIMD and draws the visible ones instanced. --gpu-driven takes precedence.\n"
+            "--frames-in-flight sets how many frames the CPU may record ahead of the GPU.\n"
+            "Renders headless, so it runs on software drivers as well (e.g. lavapipe selected with VK_ICD_FILENAMES).\n"
+            "Without an output path, the JSON report is written to the standard output");
+    }
+
+    Options ParseOptions(int argc, char** argv)
+    {
+        Options options;
+        for (int argument = 1; argument < argc; ++argument)
+        {
+            const std::string value = argv[argument];
+            const bool hasNext = argument + 1 < argc;
+
+            if (value == "--warmup" && hasNext)
+            {
+                options.warmUpFrames = static_cast<uint32_t>(std::stoul(argv[++argument]));
+            }
+            else if (value == "--frames" && hasNext)
+            {
+                options.measuredFrames = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++argument])));
+            }
+            else if (value == "--width" && hasNext)
+            {
+                options.width = std::stoi(argv[++argument]);
+            }
+            else if (value == "--height" && hasNext)
+            {
+                options.height = std::stoi(argv[++argument]);
+            }
+            else if (value == "--draws" && hasNext)
+            {
+                options.drawCount = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++argument])));
+            }
+            else if (value == "--instances" && hasNext)
+            {
+                options.instanceCount = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++argument])));
+            }
+            else if (value == "--single-threaded-recording")
+            {
+                options.isParallelRecordingEnabled = false;
+            }
+            else if (value == "--gpu-driven")
+            {
+                options.isGpuDriven = true;
+            }
+            else if (value == "--cpu-culling")
+            {
+                options.isCpuCullingEnabled = true;
+            }
+            else if (value == "--frames-in-flight" && hasNext)
+            {
+                options.framesInFlight = static_cast<uint32_t>(std::stoul(argv[++argument]));
+            }
+            else if (value == "--output" && hasNext)
+            {
+                options.outputPath = argv[++argument];
+            }
+            else if (value == "--help" || value == "-h")
+            {
+                PrintUsage();
+                std::exit(EXIT_SUCCESS);
+            }
+            else
+            {
+                throw std::invalid_argument(fmt::format("Unknown argument '{}'", value));
+            }
+        }
+
+        return options;
+    }
+
+    template<typename Function>
+    double MeasureMilliseconds(const Function& function)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        function();
+
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    /** Nearest-rank percentile of the sorted samples */
+    double GetPercentile(const std::vector<double>& sortedSamples, double percentile)
+    {
+        const auto rank = static_cast<std::size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sortedSamples.size())));
+        return sortedSamples[std::clamp<std::size_t>(rank, 1, sortedSamples.size()) - 1];
+    }
+
+    FrameTimeStatistics ComputeStatistics(std::vector<double> samples)
+    {
+        std::sort(samples.begin(), samples.end());
+
+        FrameTimeStatistics statistics;
+        statistics.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+        statistics.p50 = GetPercentile(samples, 50.0);
+        statistics.p95 = GetPercentile(samples, 95.0);
+        statistics.p99 = GetPercentile(samples, 99.0);
+        statistics.min = samples.front();
+        statistics.max = samples.back();
+
+        return statistics;
+    }
+
+    std::string EscapeJson(const std::string& value)
+    {
+        std::string escaped;
+        for (const char character : value)
+        {
+            if (character == '"' || character == '\\')
+            {
+                escaped.push_back('\\');
+            }
+            escaped.push_back(character);
+        }
+
+        return escaped;
+    }
+
+    std::string ToJson(
+        const Options& options,
+        const std::string& deviceName,
+        double startupMilliseconds,
+        double initializationMilliseconds,
+        double uploadMilliseconds,
+        const FrameTimeStatistics& frameTime,
+        double measuredMilliseconds,
+        const std::vector<vr::ProfilerScopeStatistics>& profilerStatistics)
+    {
+        std::string json = "{\n";
+        json += fmt::format("  \"device\": \"{}\",\n", EscapeJson(deviceName));
+        json += fmt::format("  \"width\": {},\n  \"height\": {},\n", options.width, options.height);
+        json += fmt::format("  \"warmUpFrames\": {},\n  \"measuredFrames\": {},\n", options.warmUpFrames, options.measuredFrames);
+        json += fmt::format("  \"draws\": {},\n  \"instances\": {},\n", options.drawCount, options.instanceCount);
+        json += fmt::format("  \"parallelRecording\": {},\n  \"gpuDriven\": {},\n", options.isParallelRecordingEnabled, options.isGpuDriven);
+        json += fmt::format("  \"cpuCulling\": {},\n  \"framesInFlight\": {},\n", options.isCpuCullingEnabled, options.framesInFlight);
+        json += fmt::format("  \"startupMilliseconds\": {:.4f},\n", startupMilliseconds);
+        json += fmt::format("  \"initializationMilliseconds\": {:.4f},\n", initializationMilliseconds);
+        json += fmt::format("  \"uploadMilliseconds\": {:.4f},\n", uploadMilliseconds);
+        json += fmt::format("  \"framesPerSecond\": {:.2f},\n", options.measuredFrames * 1000.0 / measuredMilliseconds);
+        json += fmt::format(
+            "  \"frameTimeMilliseconds\": {{ \"mean\": {:.4f}, \"p50\": {:.4f}, \"p95\": {:.4f}, \"p99\": {:.4f}, \"min\": {:.4f}, \"max\": {:.4f} }},\n",
+            frameTime.mean,
+            frameTime.p50,
+            frameTime.p95,
+            frameTime.p99,
+            frameTime.min,
+            frameTime.max);
+
+        json += "  \"profilerScopes\": [";
+        for (std::size_t i = 0; i < profilerStatistics.size(); ++i)
+        {
+            const auto& scope = profilerStatistics[i];
+            json += fmt::format(
+                "{}\n    {{ \"name\": \"{}\", \"timeline\": \"{}\", \"averageMilliseconds\": {:.4f}, \"maxMilliseconds\": {:.4f}, \"samples\": {} }}",
+                i == 0 ? "" : ",",
+                EscapeJson(scope.name),
+                scope.isGpu ? "GPU" : "CPU",
+                scope.GetAverageMilliseconds(),
+                scope.maxMilliseconds,
+                scope.sampleCount);
+        }
+        json += profilerStatistics.empty() ? "]\n" : "\n  ]\n";
+        json += "}\n";
+
+        return json;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    // The results may be written to stdout, the logs must not be mixed into them
+    spdlog::set_default_logger(spdlog::stderr_color_mt("stderr"));
+
+    try
+    {
+        const auto options = ParseOptions(argc, argv);
+
+        std::unique_ptr<vr::Application> app;
+        const double constructionMilliseconds = MeasureMilliseconds([&]() { app = std::make_unique<vr::Application>(options.width, options.height, true); });
+
+        auto& vulkan = app->GetVulkan();
+        vulkan.SetFixedTimeStep(FIXED_TIME_STEP);
+        vulkan.SetProfilerReportInterval(0);
+        vulkan.SetDrawCount(options.drawCount);
+        vulkan.SetInstanceCount(options.instanceCount);
+        vulkan.SetParallelRecordingEnabled(options.isParallelRecordingEnabled);
+        vulkan.SetGpuDrivenRenderingEnabled(options.isGpuDriven);
+        vulkan.SetCpuCullingEnabled(options.isCpuCullingEnabled);
+        vulkan.SetFramesInFlight(options.framesInFlight);
+
+        // Uploads are only submitted during the initialization, so their completion is a part of the startup
+        const double uploadsWaitMilliseconds = MeasureMilliseconds([&]() { vulkan.WaitForUploads(); });
+        const double startupMilliseconds = constructionMilliseconds + uploadsWaitMilliseconds;
+        const double uploadMilliseconds = app->GetStartupStatistics().assetsLoadingMilliseconds + uploadsWaitMilliseconds;
+
+        spdlog::info("Warming up for {} frames", options.warmUpFrames);
+        for (uint32_t frame = 0; frame < options.warmUpFrames; ++frame)
+        {
+            vulkan.DrawFrame();
+        }
+        vulkan.WaitForDevice();
+
+        // Upload timings are kept, frame timings start from scratch
+        auto& profiler = vulkan.GetProfiler();
+        std::vector<vr::ProfilerScopeStatistics> uploadStatistics;
+        for (const auto& scope : profiler.GetStatistics())
+        {
+            if (scope.name == vr::UploadBatcher::UPLOADS_SCOPE || scope.name == vr::UploadBatcher::UPLOADS_ACQUIRE_SCOPE)
+            {
+                uploadStatistics.push_back(scope);
+            }
+        }
+        profiler.ResetStatistics();
+
+        spdlog::info("Measuring {} frames", options.measuredFrames);
+        std::vector<double> frameTimes;
+        frameTimes.reserve(options.measuredFrames);
+
+        const double measuredMilliseconds = MeasureMilliseconds([&]() {
+            for (uint32_t frame = 0; frame < options.measuredFrames; ++frame)
+            {
+                frameTimes.push_back(MeasureMilliseconds([&]() { vulkan.DrawFrame(); }));
+            }
+            vulkan.WaitForDevice();
+        });
+
+        auto profilerStatistics = uploadStatistics;
+        const auto& frameStatistics = profiler.GetStatistics();
+        profilerStatistics.insert(profilerStatistics.end(), frameStatistics.begin(), frameStatistics.end());
+
+        const auto json = ToJson(
+            options,
+            vulkan.GetDeviceName(),
+            startupMilliseconds,
+            app->GetStartupStatistics().initializationMilliseconds,
+            uploadMilliseconds,
+            ComputeStatistics(frameTimes),
+            measuredMilliseconds,
+            profilerStatistics);
+
+        if (options.outputPath.empty())
+        {
+            std::cout << json;
+        }
+        else
+        {
+            std::ofstream file(options.outputPath, std::ios::binary);
+            if (!file.is_open())
+            {
+                throw std::runtime_error(fmt::format("Failed to open '{}'!", options.outputPath));
+            }
+
+            file << json;
+            spdlog::info("Results written to '{}'", options.outputPath);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("An exception occurred during benchmark runtime. Details: {}", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+// Project includes
+#include "VulkanRenderer/Culling/FrustumCuller.h"
+
+// Vendors includes
+#include <spdlog/spdlog.h>
+
+#ifndef GLM_FORCE_RADIANS
+    #define GLM_FORCE_RADIANS
+#endif
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /** Objects are scattered in a cube of this half size around the camera */
+    const float SCENE_HALF_SIZE = 500.0f;
+
+    struct Options
+    {
+        uint32_t objectCount = 1'000'000;
+        uint32_t iterations = 100;
+    };
+
+    void PrintUsage()
+    {
+        spdlog::info(
+            "Usage: FrustumCullingBenchmark [--objects <count>] [--iterations <count>]\n"
+            "Culls randomly scattered bounding spheres with every backend supported by the CPU and compares the results with the scalar one");
+    }
+
+    Options ParseOptions(int argc, char** argv)
+    {
+        Options options;
+        for (int argument = 1; argument < argc; ++argument)
+        {
+            const std::string value = argv[argument];
+            const bool hasNext = argument + 1 < argc;
+
+            if (value == "--objects" && hasNext)
+            {
+                options.objectCount = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++argument])));
+            }
+            else if (value == "--iterations" && hasNext)
+            {
+                options.iterations = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++argument])));
+            }
+            else if (value == "--help" || value == "-h")
+            {
+                PrintUsage();
+                std::exit(EXIT_SUCCESS);
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown argument '" + value + "'");
+            }
+        }
+
+        return options;
+    }
+
+    /** The same seed is used for every backend, so all of them cull exactly the same scene */
+    void FillScene(vr::FrustumCuller& culler, uint32_t objectCount)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<float> position(-SCENE_HALF_SIZE, SCENE_HALF_SIZE);
+        std::uniform_real_distribution<float> radius(0.5f, 2.0f);
+
+        culler.Reserve(objectCount);
+        for (uint32_t object = 0; object < objectCount; ++object)
+        {
+            const glm::vec3 center(position(generator), position(generator), position(generator));
+            culler.AddSphere(center, radius(generator));
+        }
+    }
+
+    /** Number of objects visible in only one of the lists. Both lists are sorted */
+    std::size_t CountDifferences(const std::vector<uint32_t>& reference, const std::vector<uint32_t>& result)
+    {
+        std::vector<uint32_t> differences;
+        std::set_symmetric_difference(reference.begin(), reference.end(), result.begin(), result.end(), std::back_inserter(differences));
+
+        return differences.size();
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const auto options = ParseOptions(argc, argv);
+
+        const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, SCENE_HALF_SIZE);
+        const auto frustum = vr::Frustum::FromViewProjection(projection * view);
+
+        spdlog::info("Culling {} objects, {} iterations per backend", options.objectCount, options.iterations);
+
+        std::vector<uint32_t> referenceVisible;
+        for (const auto backend : {vr::CullingBackend::Scalar, vr::CullingBackend::Sse, vr::CullingBackend::Avx2})
+        {
+            const auto* backendName = vr::FrustumCuller::GetBackendName(backend);
+            if (!vr::FrustumCuller::IsBackendSupported(backend))
+            {
+                spdlog::info("{}: not supported by this CPU", backendName);
+                continue;
+            }
+
+            vr::FrustumCuller culler(backend);
+            FillScene(culler, options.objectCount);
+
+            // The first run sizes the visible list, so the measured runs do not allocate
+            std::vector<uint32_t> visible;
+            culler.Cull(frustum, visible);
+
+            double bestSeconds = std::numeric_limits<double>::max();
+            for (uint32_t iteration = 0; iteration < options.iterations; ++iteration)
+            {
+                const auto start = std::chrono::high_resolution_clock::now();
+                culler.Cull(frustum, visible);
+                const auto seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+                bestSeconds = std::min(bestSeconds, seconds);
+            }
+
+            spdlog::info(
+                "{}: best {:.3f} ms, {:.2f} ns per object, {} visible",
+                backendName,
+                bestSeconds * 1000.0,
+                bestSeconds * 1e9 / options.objectCount,
+                visible.size());
+
+            if (backend == vr::CullingBackend::Scalar)
+            {
+                referenceVisible = visible;
+                continue;
+            }
+
+            // Fused multiply-adds round differently, which may only flip spheres touching a plane
+            const auto differences = CountDifferences(referenceVisible, visible);
+            if (differences != 0)
+            {
+                spdlog::warn("{}: {} objects differ from the scalar results", backendName, differences);
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("An exception occurred during benchmark runtime. Details: {}", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,259 @@
+// Project includes
+#include "VulkanRenderer/Assets/ObjLoader.h"
+
+// Vendors includes
+#include <spdlog/spdlog.h>
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    struct Options
+    {
+        std::string path;
+        size_t generateSizeMiB = 256;
+        uint32_t threadCount = 0;
+        uint32_t repetitions = 3;
+        bool skipReference = false;
+    };
+
+    void PrintUsage()
+    {
+        spdlog::info(
+            "Usage: ObjLoaderBenchmark [path/to/model.obj] [--generate <MiB>] [--threads <count>] [--repetitions <count>] [--skip-reference]\n"
+            "Without a path, a synthetic model of the given size (256 MiB by default) is generated in the working directory");
+    }
+
+    Options ParseOptions(int argc, char** argv)
+    {
+        Options options;
+        for (int argument = 1; argument < argc; ++argument)
+        {
+            const std::string value = argv[argument];
+            const bool hasNext = argument + 1 < argc;
+
+            if (value == "--generate" && hasNext)
+            {
+                options.generateSizeMiB = std::stoul(argv[++argument]);
+            }
+            else if (value == "--threads" && hasNext)
+            {
+                options.threadCount = static_cast<uint32_t>(std::stoul(argv[++argument]));
+            }
+            else if (value == "--repetitions" && hasNext)
+            {
+                options.repetitions = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++argument])));
+            }
+            else if (value == "--skip-reference")
+            {
+                options.skipReference = true;
+            }
+            else if (value == "--help" || value == "-h")
+            {
+                PrintUsage();
+                std::exit(EXIT_SUCCESS);
+            }
+            else
+            {
+                options.path = value;
+            }
+        }
+
+        return options;
+    }
+
+    /** Writes a triangulated, textured grid split into groups, which resembles exported production assets */
+    std::string GenerateModel(size_t sizeMiB)
+    {
+        const std::string path = "obj_loader_benchmark_" + std::to_string(sizeMiB) + "MiB.obj";
+        if (std::filesystem::exists(path))
+        {
+            return path;
+        }
+
+        spdlog::info("Generating '{}'", path);
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to create the benchmark model!");
+        }
+
+        // Every grid cell takes roughly 200 bytes: a position, a texcoord, a normal and two faces
+        const size_t targetSize = sizeMiB * 1024 * 1024;
+        const auto gridSize = static_cast<size_t>(std::sqrt(static_cast<double>(targetSize) / 200.0)) + 2;
+        const size_t rowsPerGroup = 64;
+
+        char line[256];
+        for (size_t y = 0; y < gridSize; ++y)
+        {
+            for (size_t x = 0; x < gridSize; ++x)
+            {
+                const float u = static_cast<float>(x) / static_cast<float>(gridSize - 1);
+                const float v = static_cast<float>(y) / static_cast<float>(gridSize - 1);
+                const float height = 0.25f * std::sin(u * 31.0f) * std::cos(v * 17.0f);
+
+                file.write(line, snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", u * 100.0f - 50.0f, height, v * 100.0f - 50.0f));
+                file.write(line, snprintf(line, sizeof(line), "vt %.6f %.6f\n", u, v));
+                file.write(line, snprintf(line, sizeof(line), "vn %.6f %.6f %.6f\n", 0.0f, 1.0f, 0.0f));
+            }
+        }
+
+        for (size_t y = 0; y + 1 < gridSize; ++y)
+        {
+            if (y % rowsPerGroup == 0)
+            {
+                file.write(line, snprintf(line, sizeof(line), "g rows_%zu\n", y / rowsPerGroup));
+            }
+
+            for (size_t x = 0; x + 1 < gridSize; ++x)
+            {
+                const size_t i0 = y * gridSize + x + 1;
+                const size_t i1 = i0 + 1;
+                const size_t i2 = i0 + gridSize;
+                const size_t i3 = i2 + 1;
+
+                file.write(line, snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", i0, i0, i0, i2, i2, i2, i1, i1, i1));
+                file.write(line, snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", i1, i1, i1, i2, i2, i2, i3, i3, i3));
+            }
+        }
+
+        return path;
+    }
+
+    template<typename Function>
+    double MeasureSeconds(const Function& function)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        function();
+
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    size_t CountFloatMismatches(const std::vector<tinyobj::real_t>& expected, const std::vector<tinyobj::real_t>& actual)
+    {
+        if (expected.size() != actual.size())
+        {
+            return std::max(expected.size(), actual.size());
+        }
+
+        // tinyobj does not round its floats correctly, so the results may differ in the last bits
+        size_t mismatches = 0;
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            const auto tolerance = 1e-6f * std::max(1.0f, std::abs(expected[i]));
+            mismatches += std::abs(expected[i] - actual[i]) > tolerance ? 1 : 0;
+        }
+
+        return mismatches;
+    }
+
+    size_t CountIndexMismatches(const std::vector<tinyobj::shape_t>& expected, const std::vector<tinyobj::shape_t>& actual)
+    {
+        if (expected.size() != actual.size())
+        {
+            return std::max(expected.size(), actual.size());
+        }
+
+        size_t mismatches = 0;
+        for (size_t shape = 0; shape < expected.size(); ++shape)
+        {
+            const auto& expectedIndices = expected[shape].mesh.indices;
+            const auto& actualIndices = actual[shape].mesh.indices;
+            if (expected[shape].name != actual[shape].name || expectedIndices.size() != actualIndices.size())
+            {
+                mismatches += std::max<size_t>(1, std::max(expectedIndices.size(), actualIndices.size()));
+                continue;
+            }
+
+            for (size_t i = 0; i < expectedIndices.size(); ++i)
+            {
+                const auto& a = expectedIndices[i];
+                const auto& b = actualIndices[i];
+                mismatches += (a.vertex_index != b.vertex_index || a.texcoord_index != b.texcoord_index || a.normal_index != b.normal_index) ? 1 : 0;
+            }
+        }
+
+        return mismatches;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const auto options = ParseOptions(argc, argv);
+        const auto path = options.path.empty() ? GenerateModel(options.generateSizeMiB) : options.path;
+        const double sizeMiB = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+
+        spdlog::info("Benchmarking '{}' ({:.1f} MiB)", path, sizeMiB);
+
+        tinyobj::attrib_t referenceAttrib;
+        std::vector<tinyobj::shape_t> referenceShapes;
+        double referenceSeconds = 0.0;
+        if (!options.skipReference)
+        {
+            std::vector<tinyobj::material_t> materials;
+            std::string warn, err;
+
+            referenceSeconds = MeasureSeconds([&]() {
+                if (!tinyobj::LoadObj(&referenceAttrib, &referenceShapes, &materials, &warn, &err, path.c_str()))
+                {
+                    throw std::runtime_error(warn + err);
+                }
+            });
+            spdlog::info("tinyobj::LoadObj: {:.3f} s ({:.1f} MiB/s)", referenceSeconds, sizeMiB / referenceSeconds);
+        }
+
+        const vr::ObjLoader loader(options.threadCount);
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+
+        double bestSeconds = std::numeric_limits<double>::max();
+        for (uint32_t repetition = 0; repetition < options.repetitions; ++repetition)
+        {
+            const double seconds = MeasureSeconds([&]() { loader.Load(path, attrib, shapes); });
+            bestSeconds = std::min(bestSeconds, seconds);
+
+            spdlog::info("vr::ObjLoader run {}: {:.3f} s ({:.1f} MiB/s)", repetition + 1, seconds, sizeMiB / seconds);
+        }
+
+        if (options.skipReference)
+        {
+            return EXIT_SUCCESS;
+        }
+
+        spdlog::info("Speedup over tinyobj::LoadObj (best run): {:.2f}x", referenceSeconds / bestSeconds);
+
+        const size_t attributeMismatches = CountFloatMismatches(referenceAttrib.vertices, attrib.vertices) +
+                                           CountFloatMismatches(referenceAttrib.texcoords, attrib.texcoords) +
+                                           CountFloatMismatches(referenceAttrib.normals, attrib.normals) +
+                                           CountFloatMismatches(referenceAttrib.colors, attrib.colors);
+        const size_t indexMismatches = CountIndexMismatches(referenceShapes, shapes);
+
+        if (attributeMismatches != 0 || indexMismatches != 0)
+        {
+            // Polygons are fanned instead of ear clipped, so models with n-gons legitimately differ in their indices
+            spdlog::warn("Results differ from tinyobj: {} attribute mismatches, {} index mismatches", attributeMismatches, indexMismatches);
+            return EXIT_FAILURE;
+        }
+
+        spdlog::info("Results match tinyobj::LoadObj");
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("An exception occurred during benchmark runtime. Details: {}", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -53,3 +53,39 @@ function(set_compiler_options IN_TARGET_NAME)
 		target_compile_options(${IN_TARGET_NAME} PRIVATE /EHsc /WX /c /experimental:external /external:anglebrackets /external:W0)
 	endif()
 endfunction(set_compiler_options)
+
+# This function compiles GLSL shaders into SPIR-V with glslc from the Vulkan SDK whenever their sources change.
+# The binaries are written next to the sources, just like `compileShaders.bat` does.
+# If glslc cannot be found, the committed binaries are used as they are.
+# @param IN_TARGET_NAME - the target which depends on the compiled shaders
+# @param IN_SHADERS_DIR - the directory containing the shader sources
+# @param ARGN - pairs of a shader source filename and the filename of its binary, e.g. "shader.vert" "vert.spv"
+function(add_shaders IN_TARGET_NAME IN_SHADERS_DIR)
+	find_program(GLSLC_EXECUTABLE NAMES glslc HINTS "$ENV{VULKAN_SDK}/Bin" "$ENV{VULKAN_SDK}/bin")
+	if(NOT GLSLC_EXECUTABLE)
+		message(WARNING "glslc not found, shaders will not be compiled. Use the committed SPIR-V binaries or run compileShaders.bat")
+		return()
+	endif()
+
+	set(SHADER_BINARIES "")
+	set(SHADER_ARGS ${ARGN})
+	list(LENGTH SHADER_ARGS SHADER_ARGS_LENGTH)
+	math(EXPR LAST_SHADER_INDEX "${SHADER_ARGS_LENGTH} - 1")
+
+	foreach(SOURCE_INDEX RANGE 0 ${LAST_SHADER_INDEX} 2)
+		math(EXPR BINARY_INDEX "${SOURCE_INDEX} + 1")
+		list(GET SHADER_ARGS ${SOURCE_INDEX} SHADER_SOURCE)
+		list(GET SHADER_ARGS ${BINARY_INDEX} SHADER_BINARY)
+
+		add_custom_command(
+			OUTPUT "${IN_SHADERS_DIR}/${SHADER_BINARY}"
+			COMMAND "${GLSLC_EXECUTABLE}" "${IN_SHADERS_DIR}/${SHADER_SOURCE}" -o "${IN_SHADERS_DIR}/${SHADER_BINARY}"
+			DEPENDS "${IN_SHADERS_DIR}/${SHADER_SOURCE}"
+			COMMENT "Compiling ${SHADER_SOURCE}"
+		)
+		list(APPEND SHADER_BINARIES "${IN_SHADERS_DIR}/${SHADER_BINARY}")
+	endforeach()
+
+	add_custom_target(${IN_TARGET_NAME}Shaders DEPENDS ${SHADER_BINARIES})
+	add_dependencies(${IN_TARGET_NAME} ${IN_TARGET_NAME}Shaders)
+endfunction(add_shaders)
@@ -1,5 +1,8 @@
 C:\VulkanSDK\1.2.154.1\Bin\glslc.exe res/Shaders/shader.vert -o res/Shaders/vert.spv
 C:\VulkanSDK\1.2.154.1\Bin\glslc.exe res/Shaders/shader.frag -o res/Shaders/frag.spv
+C:\VulkanSDK\1.2.154.1\Bin\glslc.exe res/Shaders/bindless.frag -o res/Shaders/bindless_frag.spv
+C:\VulkanSDK\1.2.154.1\Bin\glslc.exe res/Shaders/downsample.comp -o res/Shaders/downsample.spv
+C:\VulkanSDK\1.2.154.1\Bin\glslc.exe res/Shaders/cull.comp -o res/Shaders/cull.spv
 
 C:\VulkanSDK\1.2.154.1\Bin\glslc.exe res/Shaders/test/shader.vert -o res/Shaders/test/vert.spv
 C:\VulkanSDK\1.2.154.1\Bin\glslc.exe res/Shaders/test/shader.frag -o res/Shaders/test/frag.spv
\ No newline at end of file
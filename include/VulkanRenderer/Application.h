@@ -6,27 +6,43 @@
 
 namespace vr
 {
+    struct StartupStatistics
+    {
+        /** Time spent in the whole renderer initialization */
+        double initializationMilliseconds = 0.0;
+        /** Part of the initialization spent on loading the assets and recording their uploads */
+        double assetsLoadingMilliseconds = 0.0;
+    };
+
     class Application
     {
     public:
-        Application(int windowWidth, int windowHeight);
+        /** In the headless mode no window is created and frames are rendered offscreen, as fast as the device allows */
+        Application(int windowWidth, int windowHeight, bool isHeadless = false);
         ~Application();
 
-        void Run();
+        /** Renders until the window is closed, or the given number of frames if it's not 0 */
+        void Run(uint32_t frameCount = 0);
+
+        Vulkan& GetVulkan();
+        const StartupStatistics& GetStartupStatistics() const;
 
     private:
         void InitWindow();
         void InitVulkan();
 
-        void MainLoop();
+        void MainLoop(uint32_t frameCount);
         void Cleanup();
 
     private:
         VulkanInitializer m_vulkanInitializer;
         std::unique_ptr<Vulkan> m_vulkan;
-        GLFWwindow* m_window;
+        GLFWwindow* m_window = nullptr;
         
         const int WINDOW_WIDTH;
         const int WINDOW_HEIGHT;
+        const bool IS_HEADLESS;
+
+        StartupStatistics m_startupStatistics;
     };
 } // namespace vr
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include "VulkanRenderer/Assets/Ktx2Texture.h"
+
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace vr
+{
+    struct TranscodedTexture
+    {
+        std::vector<uint8_t> data;
+        /** Offsets are relative to the data */
+        std::vector<TextureLevel> levels;
+    };
+
+    /**
+     * Transcodes Basis Universal payloads of KTX2 textures to block-compressed formats sampled by the GPU.
+     * The transcoder is only available if the renderer was built with the Basis Universal sources (VR_BASIS_UNIVERSAL_DIR).
+     */
+    class BasisTranscoder
+    {
+    public:
+        static bool IsAvailable();
+        /** Whether the format is one of the BC7, ASTC 4x4 or ETC2 RGBA formats transcoding can target */
+        static bool IsTargetSupported(vk::Format format);
+
+        /** Throws if the transcoder is not available, the target is not supported or the texture cannot be transcoded */
+        static TranscodedTexture Transcode(const Ktx2Texture& texture, vk::Format target);
+    };
+} // namespace vr
@@ -0,0 +1,63 @@
+#pragma once
+#include "VulkanRenderer/Utils/MappedFile.h"
+
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vr
+{
+    /** Location of a single mip level within the data it was read from */
+    struct TextureLevel
+    {
+        size_t offset = 0;
+        size_t size = 0;
+        uint32_t width = 1;
+        uint32_t height = 1;
+    };
+
+    /**
+     * 2D texture stored in a KTX2 container (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html).
+     * The file is mapped and the levels refer to it directly, so the level data of natively stored formats
+     * (e.g. BC7, ASTC or ETC2 blocks) can be staged for the upload without any copies or decoding.
+     *
+     * Basis Universal payloads, either BasisLZ supercompressed ETC1S or UASTC, have no Vulkan format of their own
+     * and have to be transcoded to a format supported by the device first. Zstandard and zlib supercompression,
+     * texture arrays, cube maps and 3D textures are not supported.
+     */
+    class Ktx2Texture
+    {
+    public:
+        /** Throws if the file is not a valid KTX2 file, or if it uses any of the features that are not supported */
+        explicit Ktx2Texture(const std::string& path);
+
+        /** Undefined for Basis Universal payloads */
+        vk::Format GetFormat() const;
+        bool IsBasisUniversal() const;
+        /** Whether the texels are sRGB encoded, so the texture should be sampled through an sRGB format */
+        bool IsSrgb() const;
+
+        uint32_t GetWidth() const;
+        uint32_t GetHeight() const;
+
+        /** Levels, starting from the base one. Offsets are relative to GetFileData() */
+        const std::vector<TextureLevel>& GetLevels() const;
+
+        const uint8_t* GetFileData() const;
+        size_t GetFileSize() const;
+
+        const std::string& GetPath() const;
+
+    private:
+        std::string m_path;
+        MappedFile m_file;
+
+        vk::Format m_format = vk::Format::eUndefined;
+        bool m_isBasisUniversal = false;
+        bool m_isSrgb = false;
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+        std::vector<TextureLevel> m_levels;
+    };
+} // namespace vr
@@ -0,0 +1,86 @@
+#pragma once
+#include "VulkanRenderer/Utils/MappedFile.h"
+#include "VulkanRenderer/Vulkan/Vertex.h"
+
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace vr
+{
+    struct BoundingBox
+    {
+        glm::vec3 min = glm::vec3(0.0f);
+        glm::vec3 max = glm::vec3(0.0f);
+    };
+
+    struct BoundingSphere
+    {
+        glm::vec3 center = glm::vec3(0.0f);
+        float radius = 0.0f;
+    };
+
+    /**
+     * Vertex and index data ready to be copied into GPU buffers.
+     * The data is either owned by the mesh or viewed directly inside a mapped mesh cache file, which the mesh keeps alive.
+     * Vertices are packed as described by the mesh's vertex format, with positions quantized within the bounds of the mesh.
+     */
+    class Mesh
+    {
+    public:
+        Mesh() = default;
+        /**
+         * Computes the bounding volumes, packs the vertices with only the attributes that vary stored per vertex,
+         * and narrows the indices to 16 bits if every vertex can be addressed with them
+         */
+        Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+        Mesh(
+            MappedFile file,
+            size_t vertexDataOffset,
+            uint32_t vertexCount,
+            const VertexFormat& vertexFormat,
+            size_t indexDataOffset,
+            uint32_t indexCount,
+            vk::IndexType indexType,
+            const BoundingBox& bounds,
+            const BoundingSphere& boundingSphere);
+
+        Mesh(const Mesh&) = delete;
+        Mesh& operator=(const Mesh&) = delete;
+
+        Mesh(Mesh&&) noexcept = default;
+        Mesh& operator=(Mesh&&) noexcept = default;
+
+        const void* GetVertexData() const;
+        vk::DeviceSize GetVertexDataSize() const;
+        uint32_t GetVertexCount() const;
+        const VertexFormat& GetVertexFormat() const;
+
+        const void* GetIndexData() const;
+        vk::DeviceSize GetIndexDataSize() const;
+        uint32_t GetIndexCount() const;
+        vk::IndexType GetIndexType() const;
+
+        /** Packed positions are relative to the bounds, with the minimum at 0 and the maximum at 1 */
+        const BoundingBox& GetBounds() const;
+        /** Centered at the center of the bounds, with the radius reaching the farthest vertex */
+        const BoundingSphere& GetBoundingSphere() const;
+
+        static vk::DeviceSize GetIndexSize(vk::IndexType indexType);
+
+    private:
+        std::vector<uint8_t> m_ownedVertices;
+        std::vector<uint8_t> m_ownedIndices;
+        MappedFile m_file;
+
+        const void* m_vertexData = nullptr;
+        uint32_t m_vertexCount = 0;
+        VertexFormat m_vertexFormat;
+        const void* m_indexData = nullptr;
+        uint32_t m_indexCount = 0;
+        vk::IndexType m_indexType = vk::IndexType::eUint32;
+
+        BoundingBox m_bounds;
+        BoundingSphere m_boundingSphere;
+    };
+} // namespace vr
@@ -0,0 +1,35 @@
+#pragma once
+#include "VulkanRenderer/Assets/Mesh.h"
+
+#include <optional>
+#include <string>
+
+namespace vr
+{
+    /**
+     * Cooked, binary copy of a mesh stored next to its source asset as '<asset>.vrmesh'.
+     * The file holds a header followed by the vertex and index blobs in their final GPU layout, so loading it
+     * is a matter of mapping the file and copying the blobs into staging memory.
+     * The cache is keyed by a hash of the source file contents and ignored once the source changes.
+     */
+    class MeshCache
+    {
+    public:
+        /** Hashes the source asset, so the hash is computed only once for both loading and storing */
+        explicit MeshCache(const std::string& sourcePath);
+
+        /** Maps the cache file. Returns nothing if it does not exist, is corrupted or belongs to a different source */
+        std::optional<Mesh> Load() const;
+
+        /** Writes the mesh to the cache file. Failures are logged, as the cache is only an optimization */
+        void Store(const Mesh& mesh) const;
+
+        const std::string& GetCachePath() const;
+
+    private:
+        std::string m_cachePath;
+        uint64_t m_sourceHash = 0;
+
+        inline static const std::string CACHE_EXTENSION = ".vrmesh";
+    };
+} // namespace vr
@@ -0,0 +1,34 @@
+#pragma once
+#include <VulkanRenderer/Vendors/tiny_obj_loader.h>
+
+#include <string>
+#include <vector>
+
+namespace vr
+{
+    /**
+     * Wavefront OBJ geometry loader which parses the file on multiple threads.
+     * The file is memory mapped and split into line-aligned chunks, which are parsed independently and merged afterwards.
+     * The output has the same layout as tinyobj::LoadObj with triangulation and default vertex colors enabled.
+     *
+     * Only geometry is loaded: 'v', 'vt', 'vn', 'f', 'g' and 'o' statements. Materials, lines, points, tags
+     * and smoothing groups are ignored. Polygons with more than three vertices are triangulated as fans,
+     * which is exact for the convex polygons exporters produce.
+     */
+    class ObjLoader
+    {
+    public:
+        /** Zero threads means one thread per hardware thread */
+        explicit ObjLoader(uint32_t threadCount = 0);
+
+        /** Throws if the file cannot be mapped or contains malformed faces */
+        void Load(const std::string& path, tinyobj::attrib_t& attrib, std::vector<tinyobj::shape_t>& shapes) const;
+
+    private:
+        uint32_t m_threadCount;
+
+        /** Files smaller than this are parsed by fewer threads, as spawning them would cost more than it saves */
+        inline static const size_t MIN_CHUNK_SIZE = 1024 * 1024;
+        inline static const uint32_t CHUNKS_PER_THREAD = 4;
+    };
+} // namespace vr
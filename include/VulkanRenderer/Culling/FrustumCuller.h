@@ -0,0 +1,64 @@
+#pragma once
+#include "VulkanRenderer/Utils/Frustum.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace vr
+{
+    enum class CullingBackend
+    {
+        Scalar,
+        /** 4 objects per instruction */
+        Sse,
+        /** 8 objects per instruction, with fused multiply-adds */
+        Avx2
+    };
+
+    /**
+     * Culls bounding spheres against a view frustum on the CPU.
+     * Spheres are kept in a structure of arrays layout, padded to whole batches of the widest backend, so the SIMD backends
+     * test a batch of objects against a plane with a few instructions and no gathering. Padding spheres are never visible.
+     */
+    class FrustumCuller
+    {
+    public:
+        /** Number of objects tested at once by the widest backend */
+        inline static const std::size_t BATCH_SIZE = 8;
+
+        /** Uses the widest backend the CPU supports */
+        FrustumCuller();
+        /** Throws if the CPU does not support the backend */
+        explicit FrustumCuller(CullingBackend backend);
+
+        static bool IsBackendSupported(CullingBackend backend);
+        static CullingBackend GetBestSupportedBackend();
+        static const char* GetBackendName(CullingBackend backend);
+
+        CullingBackend GetBackend() const;
+
+        void Clear();
+        void Reserve(std::size_t objectCount);
+        /** Returns the index of the added object, which is what the visible list refers to it with */
+        uint32_t AddSphere(const glm::vec3& center, float radius);
+        std::size_t GetObjectCount() const;
+
+        /** Replaces the visible list with the indices of the objects intersecting the frustum, in increasing order */
+        void Cull(const Frustum& frustum, std::vector<uint32_t>& visibleIndices) const;
+
+    private:
+        std::size_t CullScalar(const Frustum& frustum, uint32_t* visibleIndices) const;
+        std::size_t CullSse(const Frustum& frustum, uint32_t* visibleIndices) const;
+        std::size_t CullAvx2(const Frustum& frustum, uint32_t* visibleIndices) const;
+
+    private:
+        CullingBackend m_backend;
+        std::size_t m_objectCount = 0;
+
+        std::vector<float> m_centersX;
+        std::vector<float> m_centersY;
+        std::vector<float> m_centersZ;
+        std::vector<float> m_radii;
+    };
+} // namespace vr
@@ -0,0 +1,21 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <array>
+
+namespace vr
+{
+    /**
+     * View frustum as six planes (left, right, bottom, top, near, far) in the space the matrix it was extracted from transforms from.
+     * Plane normals point inside and are normalized, so dot(plane.xyz, point) + plane.w is the signed distance of the point from the plane
+     */
+    struct Frustum
+    {
+        std::array<glm::vec4, 6> planes;
+
+        /** Expects a projection with the [0, 1] depth range, as used by Vulkan */
+        static Frustum FromViewProjection(const glm::mat4& viewProjection);
+
+        /** Conservative: spheres close to the frustum's corners may intersect every plane without intersecting the frustum */
+        bool IntersectsSphere(const glm::vec3& center, float radius) const;
+    };
+} // namespace vr
@@ -0,0 +1,9 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace vr
+{
+    /** 64-bit FNV-1a, consuming the input eight bytes at a time to keep up with large files. Not meant for security purposes */
+    uint64_t HashBytes(const void* data, size_t size);
+} // namespace vr
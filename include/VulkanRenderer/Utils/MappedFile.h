@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vr
+{
+    /**
+     * Read-only memory mapping of a whole file. The operating system pages the contents in on demand,
+     * so large files can be consumed without reading them into an intermediate buffer first.
+     */
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        /** Throws if the file cannot be opened or mapped */
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        bool IsOpen() const;
+        const uint8_t* GetData() const;
+        size_t GetSize() const;
+
+    private:
+        void Close();
+
+    private:
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+        bool m_isOpen = false;
+
+#ifdef _WIN32
+        void* m_fileHandle = nullptr;
+        void* m_mappingHandle = nullptr;
+#else
+        int m_fileDescriptor = -1;
+#endif
+    };
+} // namespace vr
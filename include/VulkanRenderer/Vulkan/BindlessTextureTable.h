@@ -0,0 +1,53 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+namespace vr
+{
+    /**
+     * Single descriptor set holding every texture the renderer samples, indexed in the shaders instead of being bound one by one.
+     * Textures are sampled images in a large, partially bound array, so only the indices in use need a valid image, and the array
+     * is update-after-bind, so indices not used by pending submissions can be written while the set stays bound. Every texture is
+     * sampled with the same sampler, written once next to the array.
+     *
+     * Requires the runtimeDescriptorArray, descriptorBindingPartiallyBound, descriptorBindingSampledImageUpdateAfterBind and
+     * descriptorBindingUpdateUnusedWhilePending Vulkan 1.2 features, and the shaderSampledImageArrayDynamicIndexing feature.
+     */
+    class BindlessTextureTable
+    {
+    public:
+        /**
+         * Upper bound of the array size, lowered to the update-after-bind limits of the device.
+         * The array may take every sampled image the fragment stage can use, so no other set of the pipeline may hold any
+         */
+        inline static const uint32_t MAX_TEXTURE_COUNT = 16384;
+
+        inline static const uint32_t SAMPLER_BINDING = 0;
+        inline static const uint32_t TEXTURES_BINDING = 1;
+
+        BindlessTextureTable(const vk::PhysicalDevice& physicalDevice, const vk::UniqueDevice& device);
+        ~BindlessTextureTable();
+
+        BindlessTextureTable(const BindlessTextureTable&) = delete;
+        BindlessTextureTable& operator=(const BindlessTextureTable&) = delete;
+
+        /** Whether the device supports the features the table requires */
+        static bool IsSupported(const vk::PhysicalDeviceFeatures& features, const vk::PhysicalDeviceVulkan12Features& vulkan12Features);
+
+        vk::DescriptorSetLayout GetDescriptorSetLayout() const;
+        vk::DescriptorSet GetDescriptorSet() const;
+        uint32_t GetCapacity() const;
+
+        /** Has to be called before the set is first used, the sampler cannot be replaced while the set is in use */
+        void SetSampler(vk::Sampler sampler);
+        /** The image has to be in the ShaderReadOnlyOptimal layout. The index must not be used by pending submissions */
+        void Write(uint32_t index, vk::ImageView view);
+
+    private:
+        vk::Device m_device;
+        uint32_t m_capacity = 0;
+
+        vk::DescriptorSetLayout m_descriptorSetLayout;
+        vk::DescriptorPool m_descriptorPool;
+        vk::DescriptorSet m_descriptorSet;
+    };
+} // namespace vr
@@ -0,0 +1,93 @@
+#pragma once
+#include "VulkanRenderer/Vulkan/MemoryAllocator.h"
+#include "VulkanRenderer/Utils/Frustum.h"
+
+#include <vulkan/vulkan.hpp>
+#include <vector>
+
+namespace vr
+{
+    /**
+     * GPU-driven drawing of many objects sharing a single mesh.
+     * Every frame, a compute shader tests the bounding sphere of every object against the view frustum and writes the draw commands
+     * of the visible ones into an indirect buffer, so the CPU records the same few commands no matter how many objects there are.
+     *
+     * With the drawIndirectCount feature, visible objects are compacted and drawn with drawIndexedIndirectCount.
+     * Otherwise every object keeps its own command, with instanceCount 0 when culled, and all of them are drawn with
+     * a single multi-draw drawIndexedIndirect. Every command draws one instance, starting at the object's index, so the
+     * per-instance vertex data of the object is used, which needs the drawIndirectFirstInstance feature for more than one object.
+     */
+    class GpuCuller
+    {
+    public:
+        inline static const uint32_t WORKGROUP_SIZE = 64;
+
+        GpuCuller(
+            const vk::PhysicalDevice& physicalDevice,
+            const vk::UniqueDevice& device,
+            MemoryAllocator& allocator,
+            vk::PipelineCache pipelineCache,
+            uint32_t frameCount,
+            bool isDrawIndirectCountEnabled,
+            bool isMultiDrawIndirectEnabled,
+            bool isDrawIndirectFirstInstanceEnabled);
+        ~GpuCuller();
+
+        GpuCuller(const GpuCuller&) = delete;
+        GpuCuller& operator=(const GpuCuller&) = delete;
+
+        /** Whether the enabled device features allow drawing the given number of objects */
+        bool CanDraw(uint32_t objectCount) const;
+
+        /**
+         * Sets the objects to cull: one model matrix per object (tightly packed mat4s) and one bounding sphere per object (center and radius
+         * in the object's space). Both buffers need the storage buffer usage. None of the frames may be in use by the GPU
+         */
+        void SetObjects(vk::Buffer instanceBuffer, vk::Buffer boundsBuffer, uint32_t objectCount);
+
+        /** Records the culling of the frame's objects. Has to be recorded outside of a render pass, before RecordDraws() */
+        void RecordCulling(vk::CommandBuffer commandBuffer, uint32_t frameIndex, const Frustum& frustum, const vk::DrawIndexedIndirectCommand& meshDraw);
+        /** Records the draws of the visible objects. The pipeline and the vertex and index buffers have to be bound already */
+        void RecordDraws(vk::CommandBuffer commandBuffer, uint32_t frameIndex) const;
+
+    private:
+        struct PushConstants
+        {
+            glm::vec4 frustumPlanes[6];
+            uint32_t objectCount;
+            uint32_t indexCount;
+            uint32_t firstIndex;
+            int32_t vertexOffset;
+            uint32_t compactCommands;
+        };
+
+        struct FrameResources
+        {
+            vk::Buffer commandsBuffer;
+            Allocation commandsAllocation;
+            vk::Buffer countBuffer;
+            Allocation countAllocation;
+            vk::DescriptorSet descriptorSet;
+        };
+
+        void CreateComputePipeline();
+        void DestroyFrameBuffers();
+
+    private:
+        vk::Device m_device;
+        MemoryAllocator& m_allocator;
+        vk::PipelineCache m_pipelineCache;
+        bool m_isDrawIndirectCountEnabled = false;
+        bool m_isMultiDrawIndirectEnabled = false;
+        bool m_isDrawIndirectFirstInstanceEnabled = false;
+        uint32_t m_maxDrawIndirectCount = 1;
+
+        vk::DescriptorSetLayout m_descriptorSetLayout;
+        vk::DescriptorPool m_descriptorPool;
+        vk::PipelineLayout m_pipelineLayout;
+        vk::Pipeline m_pipeline;
+
+        std::vector<FrameResources> m_frames;
+        uint32_t m_objectCount = 0;
+    };
+} // namespace vr
@@ -0,0 +1,94 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include <string>
+#include <vector>
+
+namespace vr
+{
+    struct ProfilerScopeStatistics
+    {
+        std::string name;
+        bool isGpu = true;
+        uint64_t sampleCount = 0;
+        double totalMilliseconds = 0.0;
+        double maxMilliseconds = 0.0;
+
+        double GetAverageMilliseconds() const;
+    };
+
+    /**
+     * Measures GPU time of named scopes with timestamp queries, and collects CPU timings next to them.
+     *
+     * Queries are grouped into slots. A slot belongs to the command buffers recorded together (e.g. the ones of a single frame in flight).
+     * Once the GPU finished executing them, Resolve() reads the timestamps without waiting and resets them from the host,
+     * so the slot can be recorded again. Results are therefore read back a few frames later without stalling.
+     *
+     * Every call is a no-op for INVALID_SLOT, which is what AcquireSlot() returns when profiling is not supported.
+     */
+    class GpuProfiler
+    {
+    public:
+        inline static const uint32_t INVALID_SLOT = UINT32_MAX;
+        inline static const uint32_t MAX_SLOTS = 32;
+        inline static const uint32_t MAX_SCOPES_PER_SLOT = 8;
+
+        /** Timestamps are only written if the device has the hostQueryReset feature enabled */
+        GpuProfiler(const vk::PhysicalDevice& physicalDevice, const vk::UniqueDevice& device, bool isHostQueryResetEnabled);
+        ~GpuProfiler();
+
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+        bool IsEnabled() const;
+        bool IsQueueFamilySupported(uint32_t queueFamilyIndex) const;
+
+        /** Returns INVALID_SLOT if profiling is disabled or all of the slots are in use */
+        uint32_t AcquireSlot();
+        /** The slot must not be used by the GPU anymore */
+        void ReleaseSlot(uint32_t slot);
+
+        /** Writes the timestamps in the given command buffer. Scopes can be nested and may begin and end in different command buffers */
+        void BeginScope(vk::CommandBuffer commandBuffer, uint32_t slot, const std::string& name);
+        void EndScope(vk::CommandBuffer commandBuffer, uint32_t slot);
+
+        /** Must only be called once the GPU finished executing the slot's scopes. The slot is empty afterwards */
+        void Resolve(uint32_t slot);
+
+        void AddCpuSample(const std::string& name, double milliseconds);
+
+        /** Statistics collected since the last ResetStatistics() call, in the order the scopes were first seen */
+        const std::vector<ProfilerScopeStatistics>& GetStatistics() const;
+        const ProfilerScopeStatistics* FindStatistics(const std::string& name, bool isGpu) const;
+        void ResetStatistics();
+        void LogStatistics() const;
+
+    private:
+        struct Scope
+        {
+            std::string name;
+            uint32_t beginQuery = 0;
+            bool isClosed = false;
+        };
+
+        struct Slot
+        {
+            bool isUsed = false;
+            std::vector<Scope> scopes;
+            std::vector<std::size_t> openScopes;
+        };
+
+        uint32_t GetFirstQuery(uint32_t slot) const;
+        void AddSample(const std::string& name, bool isGpu, double milliseconds);
+
+    private:
+        vk::Device m_device;
+        std::vector<uint32_t> m_timestampValidBits;
+        double m_timestampPeriod = 0.0;
+        bool m_isEnabled = false;
+
+        vk::QueryPool m_queryPool;
+        std::vector<Slot> m_slots;
+
+        std::vector<ProfilerScopeStatistics> m_statistics;
+    };
+} // namespace vr
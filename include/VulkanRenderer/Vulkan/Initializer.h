@@ -9,5 +9,6 @@ namespace vr
     public:
         void ListAvailableVulkanExtensions();
         std::unique_ptr<Vulkan> Init(const std::string& appName, GLFWwindow* window);
+        std::unique_ptr<Vulkan> Init(const std::string& appName, vk::Extent2D offscreenExtent);
     };
 } // namespace vr
\ No newline at end of file
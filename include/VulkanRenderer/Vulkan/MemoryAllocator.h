@@ -0,0 +1,115 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <mutex>
+#include <set>
+
+namespace vr
+{
+    /**
+     * Buddy - general purpose, long living resources. Freed memory is coalesced back with its buddy.
+     * Linear - short living resources (staging buffers and alike). A block is rewound once all of its allocations are freed.
+     */
+    enum class AllocationStrategy
+    {
+        Buddy,
+        Linear
+    };
+
+    struct MemoryBlock;
+
+    struct Allocation
+    {
+        vk::DeviceMemory memory;
+        vk::DeviceSize offset = 0;
+        vk::DeviceSize size = 0;
+        uint32_t memoryTypeIndex = 0;
+
+        /** Points to the beginning of the allocation if memory is host visible, nullptr otherwise */
+        void* mappedData = nullptr;
+
+        /** Owning block, nullptr for dedicated allocations */
+        MemoryBlock* block = nullptr;
+    };
+
+    struct MemoryTypeStatistics
+    {
+        uint32_t blockCount = 0;
+        uint32_t dedicatedAllocationCount = 0;
+        uint32_t allocationCount = 0;
+        vk::DeviceSize bytesReserved = 0;
+        vk::DeviceSize bytesUsed = 0;
+    };
+
+    struct AllocatorStatistics
+    {
+        std::vector<MemoryTypeStatistics> memoryTypes;
+
+        /** Number of live vkAllocateMemory allocations and the limit reported by the device */
+        uint32_t deviceMemoryAllocationCount = 0;
+        uint32_t maxDeviceMemoryAllocationCount = 0;
+
+        vk::DeviceSize totalBytesReserved = 0;
+        vk::DeviceSize totalBytesUsed = 0;
+    };
+
+    class MemoryAllocator
+    {
+    public:
+        MemoryAllocator(const vk::PhysicalDevice& physicalDevice, const vk::UniqueDevice& device);
+        ~MemoryAllocator();
+
+        MemoryAllocator(const MemoryAllocator&) = delete;
+        MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+        /** Allocates memory for the given buffer and binds it */
+        Allocation AllocateForBuffer(vk::Buffer buffer, vk::MemoryPropertyFlags properties, AllocationStrategy strategy = AllocationStrategy::Buddy);
+
+        /** Allocates memory for the given image and binds it. Large images and images the driver prefers so, get a dedicated allocation */
+        Allocation AllocateForImage(vk::Image image, vk::MemoryPropertyFlags properties);
+
+        void Free(Allocation& allocation);
+
+        AllocatorStatistics GetStatistics() const;
+        void LogStatistics() const;
+
+    private:
+        enum class ResourceType
+        {
+            Linear, // Buffers and linear tiled images
+            Optimal // Optimally tiled images
+        };
+
+        struct MemoryPool
+        {
+            uint32_t memoryTypeIndex = 0;
+            ResourceType resourceType = ResourceType::Linear;
+            AllocationStrategy strategy = AllocationStrategy::Buddy;
+            std::vector<std::unique_ptr<MemoryBlock>> blocks;
+        };
+
+        Allocation Allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, ResourceType resourceType, AllocationStrategy strategy, bool dedicated, const void* dedicatedInfo);
+        Allocation AllocateDedicated(const vk::MemoryRequirements& requirements, uint32_t memoryTypeIndex, const void* dedicatedInfo);
+        MemoryBlock& CreateBlock(MemoryPool& pool);
+        void DestroyBlock(MemoryBlock& block);
+
+        MemoryPool& GetPool(uint32_t memoryTypeIndex, ResourceType resourceType, AllocationStrategy strategy);
+        uint32_t FindMemoryType(uint32_t requiredType, vk::MemoryPropertyFlags requiredProperties) const;
+        vk::DeviceSize GetBlockSize(uint32_t memoryTypeIndex) const;
+        bool IsHostVisible(uint32_t memoryTypeIndex) const;
+
+    private:
+        static constexpr vk::DeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+        static constexpr vk::DeviceSize MIN_BUDDY_ALLOCATION_SIZE = 256;
+
+        vk::Device m_device;
+        vk::PhysicalDeviceMemoryProperties m_memoryProperties;
+        uint32_t m_maxAllocationCount = 0;
+        bool m_supportsDedicatedAllocation = false;
+
+        mutable std::mutex m_mutex;
+        std::vector<MemoryPool> m_pools;
+        std::vector<MemoryTypeStatistics> m_statistics;
+        uint32_t m_deviceMemoryAllocationCount = 0;
+    };
+} // namespace vr
@@ -0,0 +1,72 @@
+#pragma once
+#include "VulkanRenderer/Vulkan/UploadBatcher.h"
+
+#include <vulkan/vulkan.hpp>
+
+namespace vr
+{
+    /**
+     * Fills the mip chain of an uploaded texture from its first level on the GPU.
+     * Levels are blitted with linear filtering whenever the format supports it. Otherwise each level is downsampled
+     * by a compute shader, which only reads texels without filtering and writes the result through a storage view.
+     */
+    class MipmapGenerator
+    {
+    public:
+        MipmapGenerator(const vk::PhysicalDevice& physicalDevice, const vk::UniqueDevice& device, vk::PipelineCache pipelineCache);
+        ~MipmapGenerator();
+
+        MipmapGenerator(const MipmapGenerator&) = delete;
+        MipmapGenerator& operator=(const MipmapGenerator&) = delete;
+
+        /** Number of levels in a full mip chain, down to a single texel */
+        static uint32_t GetMipLevelsCount(uint32_t width, uint32_t height);
+
+        /**
+         * Usage and create flags the texture image has to be created with, so the chain can be generated for it.
+         * The storage usage may not be supported by the image's own format, so its views with that format only get the sampled usage
+         */
+        vk::ImageUsageFlags GetRequiredImageUsage(vk::Format format) const;
+        vk::ImageCreateFlags GetRequiredImageFlags(vk::Format format) const;
+
+        /**
+         * Generates levels 1..mipLevels-1 as a part of the current upload batch. Every level of the image has to be
+         * in the TransferDstOptimal layout with the first level already written. All levels end up in ShaderReadOnlyOptimal
+         */
+        void Generate(UploadBatcher& uploadBatcher, vk::Image image, vk::Format format, uint32_t width, uint32_t height, uint32_t mipLevels);
+
+    private:
+        struct PushConstants
+        {
+            int32_t destinationWidth;
+            int32_t destinationHeight;
+            uint32_t encodeSrgb;
+        };
+
+        bool SupportsLinearBlit(vk::Format format) const;
+        void RecordBlits(vk::CommandBuffer commandBuffer, vk::Image image, uint32_t width, uint32_t height, uint32_t mipLevels) const;
+        void RecordComputeDownsample(
+            vk::CommandBuffer commandBuffer,
+            vk::Image image,
+            bool isSrgb,
+            uint32_t width,
+            uint32_t height,
+            const std::vector<vk::DescriptorSet>& descriptorSets) const;
+
+        void CreateComputePipeline();
+        static vk::Format GetStorageFormat(vk::Format format);
+
+    private:
+        vk::PhysicalDevice m_physicalDevice;
+        vk::Device m_device;
+        vk::PipelineCache m_pipelineCache;
+
+        /** Compute fallback, created on first use */
+        vk::Sampler m_sampler;
+        vk::DescriptorSetLayout m_descriptorSetLayout;
+        vk::PipelineLayout m_pipelineLayout;
+        vk::Pipeline m_pipeline;
+
+        inline static const uint32_t WORKGROUP_SIZE = 8;
+    };
+} // namespace vr
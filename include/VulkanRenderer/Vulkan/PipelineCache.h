@@ -0,0 +1,55 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include <string>
+
+namespace vr
+{
+    /**
+     * VkPipelineCache persisted between launches. The file starts with a header identifying the driver which produced
+     * the data (vendor, device, driver version and UUIDs) and a checksum. Data from any other driver is discarded,
+     * so pipelines are compiled from scratch only once per driver.
+     */
+    class PipelineCache
+    {
+    public:
+        /** Seeds the cache with the contents of the given file, if it exists and matches the current driver */
+        PipelineCache(const vk::PhysicalDevice& physicalDevice, const vk::UniqueDevice& device, std::string filePath);
+        /** Saves the cache before destroying it */
+        ~PipelineCache();
+
+        PipelineCache(const PipelineCache&) = delete;
+        PipelineCache& operator=(const PipelineCache&) = delete;
+
+        vk::PipelineCache Get() const;
+
+        /** Writes the current contents of the cache to the file. Failures are logged, as the cache is only an optimization */
+        void Save() const;
+
+    private:
+        struct FileHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t vendorID;
+            uint32_t deviceID;
+            uint32_t driverVersion;
+            uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+            uint8_t driverUUID[VK_UUID_SIZE];
+            uint64_t dataSize;
+            uint64_t dataHash;
+        };
+
+        std::vector<uint8_t> LoadData() const;
+        FileHeader CreateHeader() const;
+
+    private:
+        vk::PhysicalDevice m_physicalDevice;
+        vk::Device m_device;
+        std::string m_filePath;
+
+        vk::PipelineCache m_pipelineCache;
+
+        inline static const uint32_t FILE_MAGIC = 0x43504B56; // "VKPC"
+        inline static const uint32_t FILE_VERSION = 1;
+    };
+} // namespace vr
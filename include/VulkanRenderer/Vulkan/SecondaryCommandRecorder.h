@@ -0,0 +1,81 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vr
+{
+    /**
+     * Records secondary command buffers on a pool of persistent worker threads.
+     * Every worker owns a transient command pool per frame in flight, so no command pool is ever shared between threads.
+     * A list of items (e.g. draws) is split into contiguous slices, one per worker, and every slice is recorded
+     * into its own secondary command buffer, which continues the render pass given in the inheritance info.
+     */
+    class SecondaryCommandRecorder
+    {
+    public:
+        /** Records the items [first, last) into the given command buffer. Called from the worker threads concurrently */
+        using RecordFunction = std::function<void(vk::CommandBuffer commandBuffer, std::size_t first, std::size_t last)>;
+
+        /** Slices smaller than this are not worth waking up another worker for */
+        inline static const std::size_t MIN_ITEMS_PER_WORKER = 256;
+
+        /** By default, there is one worker per hardware thread */
+        SecondaryCommandRecorder(const vk::UniqueDevice& device, uint32_t queueFamilyIndex, uint32_t frameCount, uint32_t workerCount = 0);
+        ~SecondaryCommandRecorder();
+
+        SecondaryCommandRecorder(const SecondaryCommandRecorder&) = delete;
+        SecondaryCommandRecorder& operator=(const SecondaryCommandRecorder&) = delete;
+
+        uint32_t GetWorkerCount() const;
+
+        /**
+         * Records all of the items and returns the secondary command buffers to execute, in the items order.
+         * Blocks until all of the workers are done. Exceptions thrown by the record function are rethrown here.
+         * The command buffers previously recorded for the given frame must not be in use by the GPU anymore
+         */
+        std::vector<vk::CommandBuffer> Record(
+            uint32_t frameIndex,
+            const vk::CommandBufferInheritanceInfo& inheritanceInfo,
+            std::size_t itemCount,
+            const RecordFunction& recordFunction);
+
+    private:
+        struct Worker
+        {
+            std::thread thread;
+            std::vector<vk::CommandPool> commandPools;
+            std::vector<vk::CommandBuffer> commandBuffers;
+        };
+
+        struct Job
+        {
+            uint32_t frameIndex = 0;
+            const vk::CommandBufferInheritanceInfo* inheritanceInfo = nullptr;
+            std::size_t itemCount = 0;
+            uint32_t sliceCount = 0;
+            const RecordFunction* recordFunction = nullptr;
+        };
+
+        void WorkerLoop(uint32_t workerIndex);
+        void RecordSlice(uint32_t workerIndex, const Job& job);
+
+    private:
+        vk::Device m_device;
+        std::vector<Worker> m_workers;
+
+        std::mutex m_mutex;
+        std::condition_variable m_jobReadyCondition;
+        std::condition_variable m_jobDoneCondition;
+        Job m_job;
+        uint64_t m_jobGeneration = 0;
+        uint32_t m_busyWorkersCount = 0;
+        bool m_isStopping = false;
+        std::exception_ptr m_exception;
+    };
+} // namespace vr
@@ -7,13 +7,14 @@ namespace vr
     enum class ShaderType
     {
         VR_VERTEX_SHADER,
-        VR_FRAGMENT_SHADER
+        VR_FRAGMENT_SHADER,
+        VR_COMPUTE_SHADER
     };
 
     class Shader
     {
     public:
-        Shader(const std::string& shaderName, const vk::UniqueDevice& device, ShaderType type);
+        Shader(const std::string& shaderName, vk::Device device, ShaderType type);
         vk::PipelineShaderStageCreateInfo GetPipelineShaderStageInfo() const;
 
     private:
@@ -27,6 +28,7 @@ namespace vr
         inline static const std::unordered_map<ShaderType, vk::ShaderStageFlagBits> SHADER_TYPES_MAP = {
             {ShaderType::VR_VERTEX_SHADER, vk::ShaderStageFlagBits::eVertex},
             {ShaderType::VR_FRAGMENT_SHADER, vk::ShaderStageFlagBits::eFragment},
+            {ShaderType::VR_COMPUTE_SHADER, vk::ShaderStageFlagBits::eCompute},
         };
     };
 } // namespace vr
\ No newline at end of file
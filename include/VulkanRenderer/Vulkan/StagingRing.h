@@ -0,0 +1,54 @@
+#pragma once
+#include "VulkanRenderer/Vulkan/MemoryAllocator.h"
+#include "VulkanRenderer/Vulkan/UploadBatcher.h"
+
+#include <vulkan/vulkan.hpp>
+#include <optional>
+
+namespace vr
+{
+    struct StagingAllocation
+    {
+        vk::Buffer buffer;
+        /** Offset from the beginning of the buffer, meant to be used as the copy source offset */
+        vk::DeviceSize offset = 0;
+        void* data = nullptr;
+    };
+
+    /**
+     * Single, persistently mapped host visible buffer staging uploads in a first in, first out manner.
+     * Every allocation is used by the upload batch being recorded, and is released once that batch completes.
+     * Batches complete in submission order, so the allocated part of the ring always stays contiguous and
+     * staging memory is reused without creating buffers or allocating memory for every upload.
+     */
+    class StagingRing
+    {
+    public:
+        StagingRing(const vk::UniqueDevice& device, MemoryAllocator& allocator, UploadBatcher& uploadBatcher, vk::DeviceSize size);
+        ~StagingRing();
+
+        StagingRing(const StagingRing&) = delete;
+        StagingRing& operator=(const StagingRing&) = delete;
+
+        /**
+         * Returns nullopt if the ring has no room for the allocation until earlier batches complete.
+         * The alignment has to be a power of two
+         */
+        std::optional<StagingAllocation> Allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+
+        vk::DeviceSize GetSize() const;
+
+    private:
+        vk::Device m_device;
+        MemoryAllocator& m_allocator;
+        UploadBatcher& m_uploadBatcher;
+
+        vk::Buffer m_buffer;
+        Allocation m_allocation;
+        vk::DeviceSize m_size;
+
+        /** Offset of the next allocation and the number of bytes in use, including the padding skipped at the end of the ring */
+        vk::DeviceSize m_head = 0;
+        vk::DeviceSize m_usedSize = 0;
+    };
+} // namespace vr
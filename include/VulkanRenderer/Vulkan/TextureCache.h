@@ -0,0 +1,118 @@
+#pragma once
+#include "VulkanRenderer/Vulkan/BindlessTextureTable.h"
+#include "VulkanRenderer/Vulkan/TextureStreamer.h"
+
+#include <vulkan/vulkan.hpp>
+#include <limits>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vr
+{
+    /** Identifies a cached texture from Acquire() until the matching Release() */
+    using TextureId = uint32_t;
+
+    struct TextureCacheStatistics
+    {
+        uint32_t loadedTextureCount = 0;
+        vk::DeviceSize bytesUsed = 0;
+        vk::DeviceSize budget = 0;
+
+        uint64_t hitCount = 0;
+        uint64_t missCount = 0;
+        /** Textures dropped once decoded, as an identical file was already loaded under another path */
+        uint64_t duplicateCount = 0;
+        uint64_t evictionCount = 0;
+    };
+
+    /**
+     * Shares streamed textures between everything that samples them.
+     * Loads are deduplicated by path when a texture is acquired, and by the file contents once it is loaded: a texture whose file
+     * has the same hash and size, and whose image has the same format and extent as a loaded one, is a duplicate. A duplicate is
+     * destroyed before it is ever bound, and its users are redirected to the texture loaded first.
+     *
+     * Textures are reference counted, and stay cached after their last reference is released. Once the loaded textures
+     * take more memory than the budget, unreferenced ones are evicted in least recently used order, as soon as every
+     * submission that used them has completed. Referenced textures are never evicted, even over the budget.
+     *
+     * With a bindless texture table, every loaded texture is written to the table at its own index, and the placeholder at index 0.
+     * An index is written only once its texture is loaded, and reused only once its texture has been evicted, so no index is ever
+     * written while pending submissions use it.
+     */
+    class TextureCache
+    {
+    public:
+        inline static const vk::DeviceSize DEFAULT_BUDGET = 512ull * 1024 * 1024;
+        inline static const uint32_t PLACEHOLDER_DESCRIPTOR_INDEX = 0;
+        /** Never returned by Acquire(), for ids that do not refer to any texture */
+        inline static const TextureId INVALID_ID = std::numeric_limits<TextureId>::max();
+
+        /** The bindless texture table is optional, and has to outlive the cache */
+        explicit TextureCache(TextureStreamer& textureStreamer, BindlessTextureTable* bindlessTextureTable = nullptr, vk::DeviceSize budget = DEFAULT_BUDGET);
+        /** Waits for the streamer, as the textures it has not handed over yet belong to the cache */
+        ~TextureCache();
+
+        TextureCache(const TextureCache&) = delete;
+        TextureCache& operator=(const TextureCache&) = delete;
+
+        /** Adds a reference to the texture of the given path, and requests it from the streamer if it is not cached */
+        TextureId Acquire(const std::string& path);
+        void Release(TextureId id);
+
+        bool IsLoaded(TextureId id) const;
+        /** View of the texture, or of the streamer's placeholder until the texture is loaded */
+        vk::ImageView GetView(TextureId id) const;
+        /** Index of the texture in the bindless texture table, or of the placeholder until the texture is loaded */
+        uint32_t GetDescriptorIndex(TextureId id) const;
+
+        /** Records that the given submission samples the texture, which makes it the most recently used one */
+        void Touch(TextureId id, uint64_t submissionNumber);
+
+        /** Evicts textures while over the budget. Every submission up to the given one must have completed */
+        void Collect(uint64_t completedSubmissionNumber);
+
+        void SetBudget(vk::DeviceSize budget);
+        TextureCacheStatistics GetStatistics() const;
+
+    private:
+        struct Entry
+        {
+            /** Paths resolving to the entry, more than one once duplicates are redirected to it */
+            std::vector<std::string> paths;
+            StreamedTexture texture;
+            uint32_t referenceCount = 0;
+            uint64_t lastSubmissionNumber = 0;
+
+            /** Set for duplicates, which only forward the ids handed out before their contents were known */
+            TextureId duplicateOf = INVALID_ID;
+            std::vector<TextureId> duplicates;
+
+            /** Only loaded textures are in the least recently used list */
+            std::list<TextureId>::iterator lruPosition;
+        };
+
+        TextureId CreateEntry(const std::string& path);
+        TextureId Resolve(TextureId id) const;
+        /** Textures with the same hash are only merged if everything else known about their contents matches too */
+        static bool IsSameContent(const StreamedTexture& texture, const StreamedTexture& otherTexture);
+        /** Textures with an index beyond the capacity of the table are not in it, and their placeholder is sampled instead */
+        bool IsInBindlessTable(TextureId id) const;
+        void OnTextureReady(TextureId id, StreamedTexture texture);
+        void Evict(TextureId id);
+
+    private:
+        TextureStreamer& m_textureStreamer;
+        BindlessTextureTable* m_bindlessTextureTable;
+
+        std::vector<Entry> m_entries;
+        std::vector<TextureId> m_freeIds;
+        std::unordered_map<std::string, TextureId> m_pathIds;
+        std::unordered_map<uint64_t, TextureId> m_contentIds;
+        /** Loaded textures, from the least recently used one */
+        std::list<TextureId> m_lruIds;
+
+        TextureCacheStatistics m_statistics;
+    };
+} // namespace vr
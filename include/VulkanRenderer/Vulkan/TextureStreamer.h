@@ -0,0 +1,150 @@
+#pragma once
+#include "VulkanRenderer/Assets/Ktx2Texture.h"
+#include "VulkanRenderer/Vulkan/MemoryAllocator.h"
+#include "VulkanRenderer/Vulkan/MipmapGenerator.h"
+#include "VulkanRenderer/Vulkan/StagingRing.h"
+#include "VulkanRenderer/Vulkan/UploadBatcher.h"
+
+#include <vulkan/vulkan.hpp>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vr
+{
+    /** Image of a streamed texture, with all of its levels in the ShaderReadOnlyOptimal layout */
+    struct StreamedTexture
+    {
+        vk::Image image;
+        Allocation allocation;
+        vk::ImageView view;
+        vk::Format format = vk::Format::eUndefined;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipLevels = 1;
+        /** Hash and size of the loaded file, the same for textures loaded from identical files */
+        uint64_t contentHash = 0;
+        uint64_t contentSize = 0;
+    };
+
+    /**
+     * Loads textures without blocking the render thread.
+     * Files are decoded on worker threads: KTX2 textures are parsed and transcoded if needed, other images are decoded
+     * to RGBA8 with stb_image. The render thread uploads the decoded textures through a staging ring in Update(), and
+     * hands every texture over once its upload batch completes, so it can be written to descriptors straight away.
+     * A placeholder texture is available from the start, to be sampled until the requested textures are ready.
+     */
+    class TextureStreamer
+    {
+    public:
+        /** Called on the thread calling Update(). The callback takes over the ownership of the texture */
+        using ReadyCallback = std::function<void(StreamedTexture texture)>;
+
+        inline static const vk::DeviceSize DEFAULT_STAGING_RING_SIZE = 32ull * 1024 * 1024;
+        /** Decoded images are in this format, unless a compressed KTX2 version of them is used */
+        inline static const vk::Format IMAGE_FORMAT = vk::Format::eR8G8B8A8Srgb;
+
+        /** By default, there is one worker per two hardware threads, as the render thread keeps running while textures decode */
+        TextureStreamer(
+            const vk::PhysicalDevice& physicalDevice,
+            const vk::UniqueDevice& device,
+            MemoryAllocator& allocator,
+            UploadBatcher& uploadBatcher,
+            MipmapGenerator& mipmapGenerator,
+            uint32_t workerCount = 0,
+            vk::DeviceSize stagingRingSize = DEFAULT_STAGING_RING_SIZE);
+        ~TextureStreamer();
+
+        TextureStreamer(const TextureStreamer&) = delete;
+        TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+        /** Opaque white, single texel texture owned by the streamer */
+        const StreamedTexture& GetPlaceholder() const;
+
+        /**
+         * Queues the texture for loading. A KTX2 file with the same name is preferred, if it exists and the device can sample it.
+         * Textures failing to load are logged and their callbacks are never called
+         */
+        void Request(const std::string& path, ReadyCallback onReady);
+
+        /** Records uploads of the decoded textures and hands over the uploaded ones. Meant to be called once per frame */
+        void Update();
+
+        /** Whether every requested texture has been either handed over or dropped */
+        bool IsIdle() const;
+        /** Submits the uploads and blocks until the streamer is idle */
+        void WaitIdle();
+
+        /** Destroys a texture handed over by the streamer. The GPU must not use it anymore */
+        void Destroy(StreamedTexture& texture);
+
+    private:
+        struct LoadRequest
+        {
+            std::string path;
+            ReadyCallback onReady;
+        };
+
+        struct DecodedTexture
+        {
+            std::string path;
+            ReadyCallback onReady;
+            /** Levels are stored next to each other, offsets are relative to the data */
+            std::vector<uint8_t> data;
+            std::vector<TextureLevel> levels;
+            vk::Format format = vk::Format::eUndefined;
+            /** Only the first level is decoded, the rest of the chain is generated on the GPU */
+            uint32_t mipLevels = 1;
+            uint64_t contentHash = 0;
+            uint64_t contentSize = 0;
+        };
+
+        struct PendingTexture
+        {
+            StreamedTexture texture;
+            ReadyCallback onReady;
+            bool isUploaded = false;
+        };
+
+        void WorkerLoop();
+        void Decode(LoadRequest& request);
+        bool DecodeCompressed(const std::string& path, DecodedTexture& decoded) const;
+        void DecodeImage(const std::string& path, DecodedTexture& decoded) const;
+
+        /** Returns false if the staging ring has no room for the texture yet */
+        bool Upload(DecodedTexture& decoded);
+        StreamedTexture CreateTexture(vk::Format format, uint32_t width, uint32_t height, uint32_t mipLevels, bool generatesMips);
+        void CreatePlaceholder();
+
+        bool IsSampleable(vk::Format format) const;
+
+    private:
+        vk::PhysicalDevice m_physicalDevice;
+        vk::Device m_device;
+        MemoryAllocator& m_allocator;
+        UploadBatcher& m_uploadBatcher;
+        MipmapGenerator& m_mipmapGenerator;
+        StagingRing m_stagingRing;
+
+        StreamedTexture m_placeholder;
+
+        std::vector<std::thread> m_workers;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_requestCondition;
+        std::condition_variable m_decodedCondition;
+        std::deque<LoadRequest> m_requests;
+        std::deque<DecodedTexture> m_decodedTextures;
+        /** Requests being decoded right now */
+        uint32_t m_decodingCount = 0;
+        bool m_isStopping = false;
+
+        /** Render thread only. Decoded textures wait here for room in the staging ring, and are handed over in the upload order */
+        std::deque<DecodedTexture> m_uploadQueue;
+        std::deque<std::unique_ptr<PendingTexture>> m_pendingTextures;
+    };
+} // namespace vr
@@ -0,0 +1,63 @@
+#pragma once
+#include "VulkanRenderer/Vulkan/MemoryAllocator.h"
+
+#include <vulkan/vulkan.hpp>
+#include <cstring>
+
+namespace vr
+{
+    struct RingAllocation
+    {
+        /** Offset from the beginning of the ring buffer. Meant to be used as a dynamic descriptor offset */
+        vk::DeviceSize offset = 0;
+        void* data = nullptr;
+    };
+
+    /**
+     * Single, persistently mapped host visible uniform buffer split into one region per frame.
+     * Allocations within a frame region are bumped linearly and aligned to minUniformBufferOffsetAlignment,
+     * so uploading per-frame constants does not involve any driver calls.
+     */
+    class UniformRingBuffer
+    {
+    public:
+        UniformRingBuffer(const vk::UniqueDevice& device, MemoryAllocator& allocator, vk::DeviceSize minOffsetAlignment, uint32_t frameCount, vk::DeviceSize frameSize);
+        ~UniformRingBuffer();
+
+        UniformRingBuffer(const UniformRingBuffer&) = delete;
+        UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+
+        /** Rewinds the region of the given frame. The GPU must be done reading it */
+        void BeginFrame(uint32_t frameIndex);
+        RingAllocation Allocate(vk::DeviceSize size);
+
+        template<typename T>
+        RingAllocation Push(const T& data)
+        {
+            const auto allocation = Allocate(sizeof(T));
+            memcpy(allocation.data, &data, sizeof(T));
+
+            return allocation;
+        }
+
+        vk::Buffer GetBuffer() const;
+        vk::DeviceSize GetFrameOffset(uint32_t frameIndex) const;
+
+    private:
+        vk::DeviceSize AlignUp(vk::DeviceSize value) const;
+
+    private:
+        vk::Device m_device;
+        MemoryAllocator& m_allocator;
+
+        vk::Buffer m_buffer;
+        Allocation m_allocation;
+
+        vk::DeviceSize m_alignment;
+        vk::DeviceSize m_frameSize;
+        uint32_t m_frameCount;
+
+        vk::DeviceSize m_frameBegin = 0;
+        vk::DeviceSize m_frameOffset = 0;
+    };
+} // namespace vr
@@ -0,0 +1,115 @@
+#pragma once
+#include "VulkanRenderer/Vulkan/MemoryAllocator.h"
+#include "VulkanRenderer/Vulkan/GpuProfiler.h"
+
+#include <vulkan/vulkan.hpp>
+#include <deque>
+#include <functional>
+
+namespace vr
+{
+    /** Identifies a submitted upload batch. Tokens grow monotonically, 0 is always complete */
+    using UploadToken = uint64_t;
+
+    /**
+     * Records transfer commands (copies and layout transitions) of many uploads into a single command buffer.
+     * Batches are submitted with a fence, so the CPU never waits for the GPU unless it explicitly asks for it with Wait().
+     * Staging memory and other resources used by a batch are released once the batch completes.
+     *
+     * Transfers are executed on the transfer queue. If it belongs to a different family than the graphics queue,
+     * ownership of the uploaded resources is released by the transfer queue and acquired by the graphics queue
+     * in a small follow-up submission, which waits for the transfers with a semaphore.
+     *
+     * If a profiler is given, GPU time of every batch is measured under the UPLOADS_SCOPE and UPLOADS_ACQUIRE_SCOPE names.
+     */
+    class UploadBatcher
+    {
+    public:
+        inline static const std::string UPLOADS_SCOPE = "Uploads";
+        inline static const std::string UPLOADS_ACQUIRE_SCOPE = "Uploads (graphics queue)";
+
+        UploadBatcher(
+            const vk::UniqueDevice& device,
+            MemoryAllocator& allocator,
+            uint32_t transferQueueFamilyIndex,
+            vk::Queue transferQueue,
+            uint32_t graphicsQueueFamilyIndex,
+            vk::Queue graphicsQueue,
+            GpuProfiler* profiler = nullptr);
+        ~UploadBatcher();
+
+        UploadBatcher(const UploadBatcher&) = delete;
+        UploadBatcher& operator=(const UploadBatcher&) = delete;
+
+        /** Creates a host visible buffer filled with the given data, which lives until the current batch completes */
+        vk::Buffer Stage(const void* data, vk::DeviceSize size);
+
+        void CopyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size);
+        void CopyBufferToImage(vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height, uint32_t mipLevel = 0, vk::DeviceSize bufferOffset = 0);
+        void TransitionImageLayout(vk::Image image, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, uint32_t mipLevels = 1);
+
+        /**
+         * Hands the image, whose levels are all in the TransferDstOptimal layout, over to the graphics queue and calls the recorder
+         * with a command buffer executed there after the transfers of the current batch. Meant for processing the transfer queue
+         * is not capable of, like blits or compute dispatches. The recorder is responsible for the final layout of the image
+         */
+        void RecordOnGraphicsQueue(vk::Image image, uint32_t mipLevels, std::function<void(vk::CommandBuffer)> recorder);
+
+        /** Calls the given function once the current batch completes on the GPU */
+        void DeferUntilComplete(std::function<void()> callback);
+
+        /** Submits everything recorded so far. Returns the token of the last submitted batch if there was nothing to submit */
+        UploadToken Submit();
+
+        bool IsComplete(UploadToken token);
+        void Wait(UploadToken token);
+        void WaitAll();
+
+        /** Releases resources of completed batches */
+        void Collect();
+
+    private:
+        struct Batch
+        {
+            vk::CommandBuffer commandBuffer;
+            vk::Fence fence;
+            UploadToken token = 0;
+            uint32_t profilerSlot = GpuProfiler::INVALID_SLOT;
+            std::vector<std::function<void()>> completionCallbacks;
+            std::vector<std::function<void(vk::CommandBuffer)>> graphicsRecorders;
+
+            /** Queue family ownership transfer, only used if the transfer and graphics families differ */
+            vk::CommandBuffer acquireCommandBuffer;
+            vk::Semaphore transferFinishedSemaphore;
+            std::vector<vk::BufferMemoryBarrier> bufferAcquires;
+            std::vector<vk::ImageMemoryBarrier> imageAcquires;
+        };
+
+        vk::CommandBuffer GetCommandBuffer();
+        void SubmitWithOwnershipTransfer();
+        void Complete(Batch& batch);
+        bool IsOwnershipTransferRequired() const;
+
+    private:
+        vk::Device m_device;
+        MemoryAllocator& m_allocator;
+
+        uint32_t m_transferQueueFamilyIndex;
+        vk::Queue m_transferQueue;
+        vk::CommandPool m_transferCommandPool;
+
+        uint32_t m_graphicsQueueFamilyIndex;
+        vk::Queue m_graphicsQueue;
+        vk::CommandPool m_graphicsCommandPool;
+
+        GpuProfiler* m_profiler;
+
+        bool m_isRecording = false;
+        Batch m_recordingBatch;
+        std::deque<Batch> m_submittedBatches;
+        std::vector<Batch> m_freeBatches;
+
+        UploadToken m_lastSubmittedToken = 0;
+        UploadToken m_lastCompletedToken = 0;
+    };
+} // namespace vr
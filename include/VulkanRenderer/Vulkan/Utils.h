@@ -0,0 +1,14 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include <stdexcept>
+
+#ifndef VK_CHECK_FENCES_WAIT_RESULT
+    #define VK_CHECK_FENCES_WAIT_RESULT(x)                                        \
+        {                                                                         \
+            const auto result = x;                                                \
+            if (result != vk::Result::eSuccess && result != vk::Result::eTimeout) \
+            {                                                                     \
+                throw std::runtime_error("Wait for fences error!");               \
+            }                                                                     \
+        }
+#endif
@@ -0,0 +1,134 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+
+#ifndef GLM_ENABLE_EXPERIMENTAL
+    #define GLM_ENABLE_EXPERIMENTAL
+#endif
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+#include <array>
+
+namespace vr
+{
+    /** Per-instance data, advanced once per instance from the second vertex binding */
+    struct InstanceData
+    {
+        glm::mat4 model;
+    };
+
+    /** Full precision vertex, as loaded from the source assets. Meshes pack their vertices as described by their VertexFormat */
+    struct Vertex
+    {
+        glm::vec3 pos;
+        glm::vec3 color = glm::vec3(1.0f);
+        glm::vec2 texCoord;
+        /** Zero if the source asset has no normals */
+        glm::vec3 normal = glm::vec3(0.0f);
+
+        bool operator==(const Vertex& other) const
+        {
+            return pos == other.pos && color == other.color && texCoord == other.texCoord && normal == other.normal;
+        }
+    };
+
+    /** Values of the attributes a mesh does not store per vertex, read by every vertex from a zero stride binding */
+    struct ConstantVertexAttributes
+    {
+        /** Octahedral encoded, as snorm16 */
+        std::array<int16_t, 2> normal = {0, 0};
+        /** RGBA, as unorm8 */
+        std::array<uint8_t, 4> color = {255, 255, 255, 255};
+    };
+
+    /**
+     * Layout of the packed vertices of a mesh, interleaved in the first vertex binding:
+     * - the position as unorm16, relative to the bounds of the mesh, with an unused fourth component
+     * - the texture coordinates as half floats, as they may be outside of [0, 1]
+     * - the normal, octahedral encoded as snorm16, if the normals of the mesh vary
+     * - the color as unorm8, if the colors of the mesh vary
+     *
+     * Normals and colors that are the same for every vertex are read from the constant attributes instead, through the third
+     * binding with a zero stride, so the shaders stay the same for every format.
+     */
+    struct VertexFormat
+    {
+        inline static const uint32_t VERTEX_BINDING = 0;
+        inline static const uint32_t INSTANCE_BINDING = 1;
+        inline static const uint32_t CONSTANT_BINDING = 2;
+
+        inline static const uint32_t POSITION_OFFSET = 0;
+        inline static const uint32_t TEX_COORD_OFFSET = 8;
+        inline static const uint32_t NORMAL_OFFSET = 12;
+        inline static const uint32_t NORMAL_SIZE = 4;
+        inline static const uint32_t COLOR_SIZE = 4;
+
+        bool hasNormals = false;
+        bool hasColors = false;
+        ConstantVertexAttributes constants;
+
+        uint32_t GetStride() const
+        {
+            return GetColorOffset() + (hasColors ? COLOR_SIZE : 0);
+        }
+
+        uint32_t GetColorOffset() const
+        {
+            return NORMAL_OFFSET + (hasNormals ? NORMAL_SIZE : 0);
+        }
+
+        std::array<vk::VertexInputBindingDescription, 3> GetBindingDescriptions() const
+        {
+            std::array<vk::VertexInputBindingDescription, 3> bindingDescriptions;
+            bindingDescriptions[0] = vk::VertexInputBindingDescription(VERTEX_BINDING, GetStride(), vk::VertexInputRate::eVertex);
+            bindingDescriptions[1] = vk::VertexInputBindingDescription(INSTANCE_BINDING, sizeof(InstanceData), vk::VertexInputRate::eInstance);
+            bindingDescriptions[2] = vk::VertexInputBindingDescription(CONSTANT_BINDING, 0, vk::VertexInputRate::eVertex);
+
+            return bindingDescriptions;
+        }
+
+        std::array<vk::VertexInputAttributeDescription, 8> GetAttributeDescriptions() const
+        {
+            std::array<vk::VertexInputAttributeDescription, 8> attributeDescriptions;
+            // Position, dequantized in the vertex shader
+            attributeDescriptions[0] = vk::VertexInputAttributeDescription(0, VERTEX_BINDING, vk::Format::eR16G16B16A16Unorm, POSITION_OFFSET);
+
+            // Color
+            attributeDescriptions[1] = hasColors
+                ? vk::VertexInputAttributeDescription(1, VERTEX_BINDING, vk::Format::eR8G8B8A8Unorm, GetColorOffset())
+                : vk::VertexInputAttributeDescription(1, CONSTANT_BINDING, vk::Format::eR8G8B8A8Unorm, offsetof(ConstantVertexAttributes, color));
+
+            // UV
+            attributeDescriptions[2] = vk::VertexInputAttributeDescription(2, VERTEX_BINDING, vk::Format::eR16G16Sfloat, TEX_COORD_OFFSET);
+
+            // Instance model matrix, a matrix attribute takes one location per column
+            for (uint32_t column = 0; column < 4; ++column)
+            {
+                attributeDescriptions[3 + column] = vk::VertexInputAttributeDescription(
+                    3 + column,
+                    INSTANCE_BINDING,
+                    vk::Format::eR32G32B32A32Sfloat,
+                    static_cast<uint32_t>(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+            }
+
+            // Normal
+            attributeDescriptions[7] = hasNormals
+                ? vk::VertexInputAttributeDescription(7, VERTEX_BINDING, vk::Format::eR16G16Snorm, NORMAL_OFFSET)
+                : vk::VertexInputAttributeDescription(7, CONSTANT_BINDING, vk::Format::eR16G16Snorm, offsetof(ConstantVertexAttributes, normal));
+
+            return attributeDescriptions;
+        }
+    };
+} // namespace vr
+
+namespace std
+{
+    template<>
+    struct hash<vr::Vertex>
+    {
+        size_t operator()(const vr::Vertex& vertex) const
+        {
+            const size_t attributesHash = ((hash<glm::vec3>()(vertex.pos) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (hash<glm::vec2>()(vertex.texCoord) << 1);
+            return attributesHash ^ (hash<glm::vec3>()(vertex.normal) << 2);
+        }
+    };
+} // namespace std
@@ -1,6 +1,20 @@
 #pragma once
 #include <vulkan/vulkan.hpp>
 #include <VulkanRenderer/Vulkan/Shader.h>
+#include <VulkanRenderer/Vulkan/MemoryAllocator.h>
+#include <VulkanRenderer/Vulkan/UniformRingBuffer.h>
+#include <VulkanRenderer/Vulkan/UploadBatcher.h>
+#include <VulkanRenderer/Vulkan/MipmapGenerator.h>
+#include <VulkanRenderer/Vulkan/PipelineCache.h>
+#include <VulkanRenderer/Vulkan/GpuProfiler.h>
+#include <VulkanRenderer/Vulkan/GpuCuller.h>
+#include <VulkanRenderer/Vulkan/SecondaryCommandRecorder.h>
+#include <VulkanRenderer/Vulkan/BindlessTextureTable.h>
+#include <VulkanRenderer/Vulkan/TextureStreamer.h>
+#include <VulkanRenderer/Vulkan/TextureCache.h>
+#include <VulkanRenderer/Vulkan/Vertex.h>
+#include <VulkanRenderer/Assets/Mesh.h>
+#include <VulkanRenderer/Culling/FrustumCuller.h>
 #include <glfw/glfw3.h>
 #include <optional>
 #include <glm/glm.hpp>
@@ -8,52 +22,21 @@
 
 namespace vr
 {
-    struct Vertex
-    {
-        glm::vec3 pos;
-        glm::vec3 color;
-        glm::vec2 texCoord;
-
-        static vk::VertexInputBindingDescription getBindingDescription()
-        {
-            vk::VertexInputBindingDescription bindingDescription;
-            bindingDescription.binding = 0;
-            bindingDescription.stride = sizeof(Vertex);
-            bindingDescription.inputRate = vk::VertexInputRate::eVertex;
-
-            return bindingDescription;
-        }
-
-        static std::array<vk::VertexInputAttributeDescription, 3> getAttributeDescriptions()
-        {
-            std::array<vk::VertexInputAttributeDescription, 3> attributeDescriptions;
-            // Position
-            attributeDescriptions[0].binding = 0;
-            attributeDescriptions[0].location = 0;
-            attributeDescriptions[0].format = vk::Format::eR32G32B32Sfloat;
-            attributeDescriptions[0].offset = offsetof(Vertex, pos);
-
-            // Color
-            attributeDescriptions[1].binding = 0;
-            attributeDescriptions[1].location = 1;
-            attributeDescriptions[1].format = vk::Format::eR32G32B32Sfloat;
-            attributeDescriptions[1].offset = offsetof(Vertex, color);
-
-            // UV
-            attributeDescriptions[2].binding = 0;
-            attributeDescriptions[2].location = 2;
-            attributeDescriptions[2].format = vk::Format::eR32G32Sfloat;
-            attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
-
-            return attributeDescriptions;
-        }
-    };
-
     struct UniformBufferObject
     {
         glm::mat4 model;
         glm::mat4 view;
         glm::mat4 proj;
+        /** Dequantizes the packed positions of the mesh: the minimum of its bounds and their extent */
+        glm::vec4 positionOffset;
+        glm::vec4 positionScale;
+    };
+
+    /** Per-draw data of the bindless path, pushed to the fragment shader before the draws using it */
+    struct MaterialPushConstants
+    {
+        /** Index of the texture in the bindless texture table */
+        uint32_t textureIndex = 0;
     };
 
     struct SwapChainSupportDetails
@@ -68,21 +51,109 @@ namespace vr
         std::optional<uint32_t> graphicsFamily;
         std::optional<uint32_t> presentationFamily;
 
+        /** Dedicated transfer (or async compute) family if the device has one, graphics family otherwise */
+        std::optional<uint32_t> transferFamily;
+
         std::vector<uint32_t> List() const
         {
             return std::vector{graphicsFamily.value(), presentationFamily.value()};
         }
     };
 
+    /**
+     * Resources replaced by a swap chain recreation. Frames in flight may still use them, so they are destroyed
+     * once the last frame submitted before the recreation has completed, instead of waiting for the device to idle.
+     * Handles which were not replaced are left null
+     */
+    struct RetiredSwapChain
+    {
+        /** Number of frames submitted when the resources were retired */
+        uint64_t lastSubmission = 0;
+
+        vk::SwapchainKHR swapChain;
+        std::vector<vk::ImageView> imageViews;
+        std::vector<vk::Framebuffer> framebuffers;
+
+        vk::Image colorImage;
+        Allocation colorImageAllocation;
+        vk::ImageView colorImageView;
+        vk::Image depthImage;
+        Allocation depthImageAllocation;
+        vk::ImageView depthImageView;
+
+        vk::Pipeline pipeline;
+        vk::PipelineLayout pipelineLayout;
+        vk::RenderPass renderPass;
+    };
+
+    /**
+     * Everything a single frame in flight records and submits with. A context is reused only once its fence is signaled,
+     * so the number of contexts, and not the number of swap chain images, bounds how far the CPU runs ahead of the GPU
+     */
+    struct FrameContext
+    {
+        /** Transient pool, reset as a whole before the frame is recorded again */
+        vk::CommandPool commandPool;
+        vk::CommandBuffer commandBuffer;
+        uint32_t profilerSlot = GpuProfiler::INVALID_SLOT;
+
+        vk::Semaphore imageAvailableSemaphore;
+        vk::Semaphore renderFinishedSemaphore;
+        vk::Fence inFlightFence;
+        /** Number of the frame's last submission */
+        uint64_t submissionNumber = 0;
+
+        /** Refers to the uniform ring buffer, with the frame's region selected by the dynamic offset */
+        vk::DescriptorSet descriptorSet;
+        /** Texture view written to the descriptor set, rewritten once the frame completes if the texture changes */
+        vk::ImageView boundTextureView;
+
+        /** CPU culling related. Instances visible in the frame, written before the frame is recorded */
+        vk::Buffer visibleInstanceBuffer;
+        Allocation visibleInstanceAllocation;
+    };
+
 	class Vulkan
     {
     public:
         const std::string MODEL_PATH = VK_GET_MODEL_PATH("viking_room.obj");
         const std::string TEXTURE_PATH = VK_GET_TEXTURE_PATH("viking_room.png");
+        const std::string PIPELINE_CACHE_PATH = VK_GET_CACHE_PATH("pipeline_cache.bin");
+
+        /** Names of the profiler scopes measured by the renderer */
+        inline static const std::string RENDER_PASS_SCOPE = "RenderPass";
+        inline static const std::string DRAW_FRAME_SCOPE = "DrawFrame";
+        inline static const std::string DRAW_FRAME_WAIT_SCOPE = "DrawFrame (waiting for GPU)";
+        inline static const std::string CULLING_SCOPE = "Culling";
+
+        /** Frames with fewer draws are recorded inline on the main thread, as waking up the workers would cost more than it saves */
+        inline static const std::size_t PARALLEL_RECORDING_MIN_DRAWS = 2 * SecondaryCommandRecorder::MIN_ITEMS_PER_WORKER;
+
+        /** Distance between neighbouring instances of the model, relative to the model's size */
+        inline static const float INSTANCE_GRID_SPACING = 1.25f;
+
+        /** Profiler statistics are logged and reset every this many frames by default */
+        inline static const uint32_t PROFILER_REPORT_INTERVAL = 1000;
+
+        /** Number of offscreen images, which stand in for the swap chain images in the headless mode */
+        inline static const uint32_t OFFSCREEN_IMAGE_COUNT = 2;
+
+        /** Bounds of the number of frames the CPU may record ahead of the GPU */
+        inline static const uint32_t MIN_FRAMES_IN_FLIGHT = 1;
+        inline static const uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+        inline static const uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
 
         Vulkan(std::string appName, GLFWwindow* window);
+
+        /**
+         * Creates a headless renderer, which does not need GLFW nor presentation support. Frames are rendered into offscreen images
+         * of the given extent, left in the TransferSrcOptimal layout, and are never presented
+         */
+        Vulkan(std::string appName, vk::Extent2D offscreenExtent);
         ~Vulkan();
 
+        bool IsHeadless() const;
+
         void CreateInstance();
         void CreateSurface();
         void CreateLogicalDevice();
@@ -95,54 +166,136 @@ namespace vr
         void CreateColorResources();
         void CreateDepthResources();
         void CreateFramebuffers();
+        /** Requests the texture from the streamer, a KTX2 version of it is preferred if present */
         void CreateTextureImage();
-        void CreateTextureImageView();
         void CreateTextureSampler();
         void LoadModel();
         void CreateVertexBuffer();
         void CreateIndexBuffer();
+        void CreateInstanceBuffer();
         void CreateUniformBuffers();
         void CreateDescriptorPool();
         void CreateDescriptorSets();
         void CreateCommandBuffers();
         void CreateSyncObjects();
 
+        /** Submits all of the uploads recorded so far without waiting for them */
+        UploadToken FlushUploads();
+        /** Submits all of the uploads recorded so far and waits until they and the requested textures complete */
+        void WaitForUploads();
+
         void DrawFrame();
-        void UpdateUniformBuffer(uint32_t currentImage);
+        void UpdateUniformBuffer(uint32_t frameIndex);
         void WaitForDevice();
+
+        /** Splits the model into the given number of draws of consecutive triangles, which is only useful for measuring the draw submission overhead */
+        void SetDrawCount(uint32_t drawCount);
+        /** Draws the given number of copies of the model, laid out on a grid, with a single instanced draw per draw command */
+        void SetInstanceCount(uint32_t instanceCount);
+        /**
+         * Culls the instances against the view frustum on the GPU and draws the visible ones with indirect draws generated there.
+         * Falls back to the CPU recorded draws if the device cannot draw that many indirect draws
+         */
+        void SetGpuDrivenRenderingEnabled(bool isEnabled);
+        /** Culls the instances against the view frustum on the CPU every frame and draws the visible ones only. Ignored while GPU-driven rendering is active */
+        void SetCpuCullingEnabled(bool isEnabled);
+        /**
+         * Recreates the frame contexts for the given number of frames in flight, which has to be within [MIN_FRAMES_IN_FLIGHT, MAX_FRAMES_IN_FLIGHT].
+         * More frames absorb CPU and GPU spikes better, fewer frames lower the input latency and the per-frame memory
+         */
+        void SetFramesInFlight(uint32_t framesCount);
+        uint32_t GetFramesInFlight() const;
+        /** Large draw lists are recorded on worker threads into secondary command buffers unless this is disabled */
+        void SetParallelRecordingEnabled(bool isEnabled);
+
+        /** Advances the animation by the given time every frame instead of following the clock, so every run renders the same frames. 0 restores the clock */
+        void SetFixedTimeStep(float seconds);
         
         void CleanupSwapChain();
+        /** Destroys the graphics pipeline with its layout and render pass, which outlive swap chain recreations */
+        void DestroyGraphicsPipeline();
+        /** Replaces only the resources depending on what changed. The replaced ones are retired instead of waiting for the device */
         void RecreateSwapChain();
         void ResizeFramebuffers();
 
+        AllocatorStatistics GetMemoryStatistics() const;
+        void LogMemoryStatistics() const;
+
+        /** Unreferenced textures are evicted once the cached ones take more memory than the budget */
+        void SetTextureBudget(vk::DeviceSize budget);
+        TextureCacheStatistics GetTextureCacheStatistics() const;
+
+        std::string GetDeviceName() const;
+
+        GpuProfiler& GetProfiler();
+        /** 0 disables the periodic logging, so the statistics are collected until they are reset explicitly */
+        void SetProfilerReportInterval(uint32_t framesCount);
+        /** Logs the profiler statistics and whether the frames are CPU or GPU bound */
+        void LogProfilerStatistics() const;
+
     private:
-        void CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Buffer& buffer, vk::DeviceMemory& bufferMemory);
-        void CopyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size);
+        void CreateBuffer(
+            vk::DeviceSize size,
+            vk::BufferUsageFlags usage,
+            vk::MemoryPropertyFlags properties,
+            vk::Buffer& buffer,
+            Allocation& bufferAllocation,
+            AllocationStrategy strategy = AllocationStrategy::Buddy);
+        void DestroyBuffer(vk::Buffer& buffer, Allocation& bufferAllocation);
         void CreateImage(
             uint32_t width,
             uint32_t height,
+            uint32_t mipLevels,
             vk::SampleCountFlagBits numSumples,
             vk::Format format,
             vk::ImageTiling tiling,
             vk::ImageUsageFlags usage,
             vk::MemoryPropertyFlags properties,
             vk::Image& image,
-            vk::DeviceMemory& imageMemory
+            Allocation& imageAllocation,
+            vk::ImageCreateFlags flags = {}
         );
-        void TransitionImageLayout(vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
-        void CopyBufferToImage(vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height);
-
-        vk::CommandBuffer BeginSingleTimeCommands();
-        void EndSingleTimeCommands(vk::CommandBuffer commandBuffer);
-
-        vk::ImageView CreateImageView(vk::Image image, vk::Format format, vk::ImageAspectFlags aspectFlags);
+        void DestroyImage(vk::Image& image, Allocation& imageAllocation);
+
+        vk::ImageView CreateImageView(vk::Image image, vk::Format format, vk::ImageAspectFlags aspectFlags, uint32_t mipLevels);
+
+        /** Records the whole frame rendering into the swap chain image of the given index */
+        void RecordCommandBuffer(vk::CommandBuffer commandBuffer, uint32_t imageIndex, uint32_t profilerSlot);
+        /** Binds the pipeline, the vertex, index and instance buffers and the current frame's descriptor set */
+        void BindDrawState(vk::CommandBuffer commandBuffer) const;
+        /** Binds the current frame's state and records the draws [first, last) */
+        void RecordDraws(vk::CommandBuffer commandBuffer, std::size_t first, std::size_t last) const;
+
+        bool IsGpuDrivenRenderingActive() const;
+        bool IsCpuCullingActive() const;
+        /** Fills the current frame's visible instance buffer */
+        void CullInstances();
+        void CreateVisibleInstanceBuffers();
+        void DestroyVisibleInstanceBuffers();
+
+        /** Creates the frame contexts, with their command pools only */
+        void CreateFrameCommandPools();
+        /** Destroys the frame contexts with everything sized by the number of frames in flight. The GPU must be done with all of them */
+        void DestroyFrameContexts();
+        /** The frame must not be in use by the GPU. Unused by the bindless path, which never writes the frame's texture descriptor */
+        void WriteTextureDescriptor(FrameContext& frame);
+        /** View of the streamed texture, or of the placeholder until the texture is ready */
+        vk::ImageView GetTextureView() const;
 
         vk::Format FindDepthFormat();
         vk::Format FindSupportedFormat(const std::vector<vk::Format>& candidates, vk::ImageTiling tiling, vk::FormatFeatureFlags features);
+        bool IsFormatSupported(vk::Format format, vk::ImageTiling tiling, vk::FormatFeatureFlags features);
         bool HasStencilComponent(vk::Format format);
 
+        void CreateOffscreenImages();
+
+        void DestroyRetiredSwapChain(RetiredSwapChain& retiredSwapChain);
+        /** Destroys the retired resources of which every frame that could use them has completed */
+        void ReleaseRetiredSwapChains();
+
         /** Extensions, Layers and Debugging */
         std::vector<const char*> GetRequiredInstanceExtensions();
+        std::vector<const char*> GetRequiredDeviceExtensions() const;
         void CheckIfValidationLayersAreAvailable();
         void SetUpDebugCallback();
         vk::DebugUtilsMessengerCreateInfoEXT GetDebugMessengerCreateInfo();
@@ -157,8 +310,6 @@ namespace vr
         bool DoesDeviceSupportRequiredExtensions(const vk::PhysicalDevice& device);
         /**************************/
 
-        uint32_t FindMemoryType(uint32_t requiredType, vk::MemoryPropertyFlags requiredProperties);
-
         vk::SampleCountFlagBits GetMaxUsableSampleCount();
 
         static VKAPI_ATTR VkBool32 VKAPI_CALL DebugCallback(
@@ -171,6 +322,7 @@ namespace vr
     private:
         std::string m_appName;
         GLFWwindow* m_window;
+        bool m_isHeadless = false;
         std::size_t m_currentFrame = 0;
         bool m_shouldResizeFramebuffer = false;
 
@@ -186,6 +338,15 @@ namespace vr
         vk::UniqueDevice m_logicalDevice;
         vk::Queue m_graphicsQueue;
         vk::Queue m_presentationQueue;
+        vk::Queue m_transferQueue;
+        std::unique_ptr<MemoryAllocator> m_allocator;
+        std::unique_ptr<PipelineCache> m_pipelineCache;
+        std::unique_ptr<GpuProfiler> m_gpuProfiler;
+        bool m_isDrawIndirectCountSupported = false;
+        bool m_isMultiDrawIndirectSupported = false;
+        bool m_isDrawIndirectFirstInstanceSupported = false;
+        /** Textures are sampled through the bindless texture table, instead of a descriptor in every frame's set */
+        bool m_isBindlessSupported = false;
 
         /** SwapChain related */
         vk::SwapchainKHR m_swapChain;
@@ -194,54 +355,87 @@ namespace vr
         vk::Format m_swapChainImagesFormat;
         vk::Extent2D m_swapChainImagesExtent;
         std::vector<vk::Framebuffer> m_swapChainFramebuffers;
+        std::vector<RetiredSwapChain> m_retiredSwapChains;
+
+        /** Headless mode related. The images themselves are kept in m_swapChainImages */
+        std::vector<Allocation> m_offscreenImageAllocations;
 
         /** Render pass related */
         vk::RenderPass m_renderPass;
 
         /** Graphics pipeline related */
-        vk::Viewport m_viewport;
-        vk::Rect2D m_scissors;
         vk::Pipeline m_pipeline;
         vk::DescriptorSetLayout m_descriptorSetLayout;
         vk::DescriptorPool m_descriptorPool;
-        std::vector<vk::DescriptorSet> m_descriptorSets;
         vk::PipelineLayout m_pipelineLayout;
 
         /** Commands related */
-        vk::CommandPool m_commandPool;
-        std::vector<vk::CommandBuffer> m_commandBuffers;
-        std::vector<vk::Semaphore> m_imageAvailableSemaphores;
-        std::vector<vk::Semaphore> m_renderFinishedSemaphores;
-        std::vector<vk::Fence> m_inFlightFences;
-        std::vector<vk::Fence> m_imagesInFlight;
-
-        std::vector<Vertex> m_vertices;
-        std::vector<uint32_t> m_indices;
+        std::unique_ptr<UploadBatcher> m_uploadBatcher;
+        std::unique_ptr<MipmapGenerator> m_mipmapGenerator;
+        std::unique_ptr<SecondaryCommandRecorder> m_secondaryCommandRecorder;
+        bool m_isParallelRecordingEnabled = true;
+        /** Created once GPU-driven rendering is enabled for the first time */
+        std::unique_ptr<GpuCuller> m_gpuCuller;
+        bool m_isGpuDrivenRenderingEnabled = false;
+        uint32_t m_profiledFramesCount = 0;
+        uint32_t m_profilerReportInterval = PROFILER_REPORT_INTERVAL;
+
+        float m_fixedTimeStep = 0.0f;
+        float m_animationTime = 0.0f;
+
+        /** Frames in flight related */
+        uint32_t m_framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+        std::vector<FrameContext> m_frames;
+        /** Submissions are numbered, so retired resources know when every frame that could use them has completed */
+        uint64_t m_submittedFrameCount = 0;
+        uint64_t m_completedFrameCount = 0;
+
+        Mesh m_mesh;
+        std::vector<vk::DrawIndexedIndirectCommand> m_drawCommands;
 
         UniformBufferObject m_mvpUBO;
+        vk::DeviceSize m_mvpUBOOffset = 0;
 
         /** Buffers related */
         vk::Buffer m_vertexBuffer;
-        vk::DeviceMemory m_vertexBufferMemory;
+        Allocation m_vertexBufferAllocation;
+        /** Read with a zero stride for the attributes the mesh does not store per vertex */
+        vk::Buffer m_constantVertexAttributesBuffer;
+        Allocation m_constantVertexAttributesBufferAllocation;
         vk::Buffer m_indexBuffer;
-        vk::DeviceMemory m_indexBufferMemory;
-
-        std::vector<vk::Buffer> m_uniformBuffers;
-        std::vector<vk::DeviceMemory> m_uniformBuffersMemory;
+        Allocation m_indexBufferAllocation;
+        vk::Buffer m_instanceBuffer;
+        Allocation m_instanceBufferAllocation;
+        uint32_t m_instanceCount = 1;
+        /** Bounding sphere of every instance, for the GPU culling */
+        vk::Buffer m_objectBoundsBuffer;
+        Allocation m_objectBoundsBufferAllocation;
+
+        /** CPU culling related. Visible instances are copied every frame into the frame's host visible buffer */
+        std::vector<InstanceData> m_instances;
+        FrustumCuller m_frustumCuller;
+        bool m_isCpuCullingEnabled = false;
+        std::vector<uint32_t> m_visibleInstances;
+        uint32_t m_visibleInstanceCount = 0;
+        /** The camera moves away from the grid of instances as it grows, so all of them stay in view */
+        float m_cameraDistanceScale = 1.0f;
+
+        std::unique_ptr<UniformRingBuffer> m_uniformRingBuffer;
 
         /** Textures related */
-        vk::Image m_textureImage;
-        vk::DeviceMemory m_textureImageMemory;
-        vk::ImageView m_textureImageView;
+        std::unique_ptr<TextureStreamer> m_textureStreamer;
+        std::unique_ptr<BindlessTextureTable> m_bindlessTextureTable;
+        std::unique_ptr<TextureCache> m_textureCache;
+        TextureId m_textureId = TextureCache::INVALID_ID;
         vk::Sampler m_textureSampler;
 
         vk::Image m_depthImage;
-        vk::DeviceMemory m_depthImageMemory;
+        Allocation m_depthImageAllocation;
         vk::ImageView m_depthImageView;
 
         vk::SampleCountFlagBits m_msaaSamples = vk::SampleCountFlagBits::e1;
         vk::Image m_colorImage;
-        vk::DeviceMemory m_colorImageMemory;
+        Allocation m_colorImageAllocation;
         vk::ImageView m_colorImageView;
     };
 } // namespace vr
@@ -0,0 +1,21 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoords;
+
+layout(location = 0) out vec4 finalColor;
+
+layout(set = 1, binding = 0) uniform sampler textureSampler;
+layout(set = 1, binding = 1) uniform texture2D textures[];
+
+// The index is the same for the whole draw, so it needs no nonuniformEXT
+layout(push_constant) uniform PushConstants
+{
+    uint textureIndex;
+} pushConstants;
+
+void main()
+{
+    finalColor = texture(sampler2D(textures[pushConstants.textureIndex], textureSampler), fragTexCoords);
+}
\ No newline at end of file
@@ -1,8 +1,12 @@
 #version 450
 
+// Position quantized within the bounds of the mesh, see positionOffset and positionScale
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
+layout(location = 1) in vec4 inColor;
 layout(location = 2) in vec2 inTexCoords;
+layout(location = 3) in mat4 inInstanceModel;
+// Octahedral encoded, not shaded with yet
+layout(location = 7) in vec2 inNormal;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoords;
@@ -12,12 +16,15 @@ layout(binding = 0) uniform UBO
     mat4 model;
     mat4 view;
     mat4 projection;
+    vec4 positionOffset;
+    vec4 positionScale;
 } ubo;
 
 void main()
 {
-    gl_Position = ubo.projection * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    vec3 position = ubo.positionOffset.xyz + inPosition * ubo.positionScale.xyz;
+    gl_Position = ubo.projection * ubo.view * inInstanceModel * ubo.model * vec4(position, 1.0);
     
-    fragColor = inColor;
+    fragColor = inColor.rgb;
     fragTexCoords = inTexCoords;
 }
\ No newline at end of file
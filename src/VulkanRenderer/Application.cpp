@@ -2,6 +2,7 @@
 #include "VulkanRenderer/Vulkan/Initializer.h"
 
 #include <spdlog/spdlog.h>
+#include <chrono>
 
 namespace vr
 {
@@ -11,13 +12,19 @@ namespace vr
         vulkan->ResizeFramebuffers();
     }
 
-    Application::Application(int windowWidth, int windowHeight)
-        : WINDOW_WIDTH(windowWidth), WINDOW_HEIGHT(windowHeight)
+    Application::Application(int windowWidth, int windowHeight, bool isHeadless)
+        : WINDOW_WIDTH(windowWidth), WINDOW_HEIGHT(windowHeight), IS_HEADLESS(isHeadless)
     {
-        InitWindow();
+        if (!IS_HEADLESS)
+        {
+            InitWindow();
+        }
         InitVulkan();
 
-        glfwSetWindowUserPointer(m_window, m_vulkan.get());
+        if (!IS_HEADLESS)
+        {
+            glfwSetWindowUserPointer(m_window, m_vulkan.get());
+        }
     }
 
     Application::~Application()
@@ -25,9 +32,19 @@ namespace vr
         Cleanup();
     }
 
-    void Application::Run()
+    void Application::Run(uint32_t frameCount)
+    {
+        MainLoop(frameCount);
+    }
+
+    Vulkan& Application::GetVulkan()
     {
-        MainLoop();
+        return *m_vulkan;
+    }
+
+    const StartupStatistics& Application::GetStartupStatistics() const
+    {
+        return m_startupStatistics;
     }
 
     void Application::InitWindow()
@@ -43,7 +60,17 @@ namespace vr
 
     void Application::InitVulkan()
     {
-        m_vulkan = m_vulkanInitializer.Init("Vulkan Hello Triangle", m_window);
+        const auto initializationStartTime = std::chrono::high_resolution_clock::now();
+
+        if (IS_HEADLESS)
+        {
+            const vk::Extent2D offscreenExtent(static_cast<uint32_t>(WINDOW_WIDTH), static_cast<uint32_t>(WINDOW_HEIGHT));
+            m_vulkan = m_vulkanInitializer.Init("Vulkan Hello Triangle", offscreenExtent);
+        }
+        else
+        {
+            m_vulkan = m_vulkanInitializer.Init("Vulkan Hello Triangle", m_window);
+        }
         m_vulkanInitializer.ListAvailableVulkanExtensions();
 
         m_vulkan->CreateInstance();
@@ -53,37 +80,69 @@ namespace vr
         m_vulkan->CreateImageViews();
         m_vulkan->CreateRenderPass();
         m_vulkan->CreateDescriptorSetLayout();
-        m_vulkan->CreateGraphicsPipeline();
         m_vulkan->CreateCommandPool();
         m_vulkan->CreateColorResources();
         m_vulkan->CreateDepthResources();
         m_vulkan->CreateFramebuffers();
+        const auto assetsLoadingStartTime = std::chrono::high_resolution_clock::now();
         m_vulkan->CreateTextureImage();
-        m_vulkan->CreateTextureImageView();
         m_vulkan->CreateTextureSampler();
         m_vulkan->LoadModel();
         m_vulkan->CreateVertexBuffer();
         m_vulkan->CreateIndexBuffer();
+        m_vulkan->CreateInstanceBuffer();
+        const auto assetsLoadingEndTime = std::chrono::high_resolution_clock::now();
+        // The vertex input of the pipeline depends on the vertex format of the loaded mesh
+        m_vulkan->CreateGraphicsPipeline();
         m_vulkan->CreateUniformBuffers();
         m_vulkan->CreateDescriptorPool();
         m_vulkan->CreateDescriptorSets();
         m_vulkan->CreateCommandBuffers();
         m_vulkan->CreateSyncObjects();
+        m_vulkan->FlushUploads();
+
+        const auto initializationEndTime = std::chrono::high_resolution_clock::now();
+        m_startupStatistics.initializationMilliseconds = std::chrono::duration<double, std::milli>(initializationEndTime - initializationStartTime).count();
+        m_startupStatistics.assetsLoadingMilliseconds = std::chrono::duration<double, std::milli>(assetsLoadingEndTime - assetsLoadingStartTime).count();
+
+        m_vulkan->LogMemoryStatistics();
 
         spdlog::info("APP IS UP AN RUNNING");
     }
 
-    void Application::MainLoop()
+    void Application::MainLoop(uint32_t frameCount)
     {
-        while (!glfwWindowShouldClose(m_window))
+        const auto startTime = std::chrono::high_resolution_clock::now();
+
+        uint32_t renderedFrames = 0;
+        while (frameCount == 0 || renderedFrames < frameCount)
         {
-            glfwPollEvents();
+            if (!IS_HEADLESS)
+            {
+                if (glfwWindowShouldClose(m_window))
+                {
+                    break;
+                }
+                glfwPollEvents();
+            }
+
             m_vulkan->DrawFrame();
+            ++renderedFrames;
         }
+
+        m_vulkan->WaitForDevice();
+
+        const auto seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+        spdlog::info("Rendered {} frames in {:.3f} s ({:.1f} FPS)", renderedFrames, seconds, seconds > 0.0 ? renderedFrames / seconds : 0.0);
     }
 
     void Application::Cleanup()
     {
+        if (IS_HEADLESS)
+        {
+            return;
+        }
+
         glfwDestroyWindow(m_window);
         glfwTerminate();
     }
@@ -0,0 +1,106 @@
+#include "VulkanRenderer/Assets/BasisTranscoder.h"
+
+#include <fmt/format.h>
+#include <stdexcept>
+
+#ifdef VR_WITH_BASIS_UNIVERSAL
+    #include <basisu_transcoder.h>
+    #include <mutex>
+#endif
+
+namespace vr
+{
+#ifdef VR_WITH_BASIS_UNIVERSAL
+    namespace
+    {
+        /** Every target format stores 4x4 texel blocks in 16 bytes */
+        constexpr uint32_t TARGET_BLOCK_SIZE = 16;
+
+        basist::transcoder_texture_format GetTranscoderFormat(vk::Format format)
+        {
+            switch (format)
+            {
+                case vk::Format::eBc7UnormBlock:
+                case vk::Format::eBc7SrgbBlock:
+                    return basist::transcoder_texture_format::cTFBC7_RGBA;
+                case vk::Format::eAstc4x4UnormBlock:
+                case vk::Format::eAstc4x4SrgbBlock:
+                    return basist::transcoder_texture_format::cTFASTC_4x4_RGBA;
+                default:
+                    return basist::transcoder_texture_format::cTFETC2_RGBA;
+            }
+        }
+    } // namespace
+#endif
+
+    bool BasisTranscoder::IsAvailable()
+    {
+#ifdef VR_WITH_BASIS_UNIVERSAL
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool BasisTranscoder::IsTargetSupported(vk::Format format)
+    {
+        switch (format)
+        {
+            case vk::Format::eBc7UnormBlock:
+            case vk::Format::eBc7SrgbBlock:
+            case vk::Format::eAstc4x4UnormBlock:
+            case vk::Format::eAstc4x4SrgbBlock:
+            case vk::Format::eEtc2R8G8B8A8UnormBlock:
+            case vk::Format::eEtc2R8G8B8A8SrgbBlock:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    TranscodedTexture BasisTranscoder::Transcode(const Ktx2Texture& texture, vk::Format target)
+    {
+        if (!IsTargetSupported(target))
+        {
+            throw std::runtime_error(fmt::format("Basis Universal textures cannot be transcoded to {}!", vk::to_string(target)));
+        }
+
+#ifdef VR_WITH_BASIS_UNIVERSAL
+        static std::once_flag initializationFlag;
+        std::call_once(initializationFlag, []() { basist::basisu_transcoder_init(); });
+
+        basist::ktx2_transcoder transcoder;
+        if (!transcoder.init(texture.GetFileData(), static_cast<uint32_t>(texture.GetFileSize())) || !transcoder.start_transcoding())
+        {
+            throw std::runtime_error(fmt::format("Failed to start transcoding '{}'!", texture.GetPath()));
+        }
+
+        TranscodedTexture transcodedTexture;
+        transcodedTexture.levels.resize(transcoder.get_levels());
+        for (uint32_t level = 0; level < transcodedTexture.levels.size(); ++level)
+        {
+            basist::ktx2_image_level_info levelInfo;
+            if (!transcoder.get_image_level_info(levelInfo, level, 0, 0))
+            {
+                throw std::runtime_error(fmt::format("Failed to query level {} of '{}'!", level, texture.GetPath()));
+            }
+
+            auto& transcodedLevel = transcodedTexture.levels[level];
+            transcodedLevel.offset = transcodedTexture.data.size();
+            transcodedLevel.size = size_t(levelInfo.m_total_blocks) * TARGET_BLOCK_SIZE;
+            transcodedLevel.width = levelInfo.m_orig_width;
+            transcodedLevel.height = levelInfo.m_orig_height;
+
+            transcodedTexture.data.resize(transcodedLevel.offset + transcodedLevel.size);
+            if (!transcoder.transcode_image_level(level, 0, 0, transcodedTexture.data.data() + transcodedLevel.offset, levelInfo.m_total_blocks, GetTranscoderFormat(target)))
+            {
+                throw std::runtime_error(fmt::format("Failed to transcode level {} of '{}'!", level, texture.GetPath()));
+            }
+        }
+
+        return transcodedTexture;
+#else
+        throw std::runtime_error(fmt::format("'{}' needs transcoding, but the renderer was built without Basis Universal!", texture.GetPath()));
+#endif
+    }
+} // namespace vr
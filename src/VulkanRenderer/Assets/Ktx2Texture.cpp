@@ -0,0 +1,316 @@
+#include "VulkanRenderer/Assets/Ktx2Texture.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace vr
+{
+    namespace
+    {
+        constexpr uint8_t KTX2_IDENTIFIER[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+        constexpr uint32_t KTX2_SUPERCOMPRESSION_NONE = 0;
+        constexpr uint32_t KTX2_SUPERCOMPRESSION_BASIS_LZ = 1;
+
+        /** Data format descriptor values (Khronos Data Format Specification) */
+        constexpr uint8_t KHR_DF_MODEL_UASTC = 166;
+        constexpr uint8_t KHR_DF_TRANSFER_SRGB = 2;
+        /** Offsets of the color model and transfer function of the basic descriptor block, from the start of the descriptor */
+        constexpr size_t DFD_COLOR_MODEL_OFFSET = 12;
+        constexpr size_t DFD_TRANSFER_FUNCTION_OFFSET = 14;
+
+        struct Ktx2Header
+        {
+            uint8_t identifier[12];
+            uint32_t vkFormat;
+            uint32_t typeSize;
+            uint32_t pixelWidth;
+            uint32_t pixelHeight;
+            uint32_t pixelDepth;
+            uint32_t layerCount;
+            uint32_t faceCount;
+            uint32_t levelCount;
+            uint32_t supercompressionScheme;
+
+            uint32_t dfdByteOffset;
+            uint32_t dfdByteLength;
+            uint32_t kvdByteOffset;
+            uint32_t kvdByteLength;
+            uint64_t sgdByteOffset;
+            uint64_t sgdByteLength;
+        };
+
+        struct Ktx2LevelIndex
+        {
+            uint64_t byteOffset;
+            uint64_t byteLength;
+            uint64_t uncompressedByteLength;
+        };
+
+        static_assert(sizeof(Ktx2Header) == 80, "KTX2 header must match the file layout");
+        static_assert(sizeof(Ktx2LevelIndex) == 24, "KTX2 level index must match the file layout");
+
+        /** Texels are stored in blocks of the given size, one texel per block for uncompressed formats */
+        struct FormatBlock
+        {
+            uint32_t width = 1;
+            uint32_t height = 1;
+            /** 0 for formats that are not supported */
+            uint32_t bytes = 0;
+        };
+
+        FormatBlock GetFormatBlock(vk::Format format)
+        {
+            switch (format)
+            {
+                case vk::Format::eR8Unorm:
+                case vk::Format::eR8Srgb:
+                    return {1, 1, 1};
+                case vk::Format::eR8G8Unorm:
+                case vk::Format::eR8G8Srgb:
+                case vk::Format::eR16Sfloat:
+                    return {1, 1, 2};
+                case vk::Format::eR8G8B8A8Unorm:
+                case vk::Format::eR8G8B8A8Srgb:
+                case vk::Format::eB8G8R8A8Unorm:
+                case vk::Format::eB8G8R8A8Srgb:
+                case vk::Format::eR16G16Sfloat:
+                case vk::Format::eR32Sfloat:
+                case vk::Format::eB10G11R11UfloatPack32:
+                case vk::Format::eE5B9G9R9UfloatPack32:
+                    return {1, 1, 4};
+                case vk::Format::eR16G16B16A16Sfloat:
+                case vk::Format::eR32G32Sfloat:
+                    return {1, 1, 8};
+                case vk::Format::eR32G32B32A32Sfloat:
+                    return {1, 1, 16};
+
+                case vk::Format::eBc1RgbUnormBlock:
+                case vk::Format::eBc1RgbSrgbBlock:
+                case vk::Format::eBc1RgbaUnormBlock:
+                case vk::Format::eBc1RgbaSrgbBlock:
+                case vk::Format::eBc4UnormBlock:
+                case vk::Format::eBc4SnormBlock:
+                case vk::Format::eEtc2R8G8B8UnormBlock:
+                case vk::Format::eEtc2R8G8B8SrgbBlock:
+                case vk::Format::eEtc2R8G8B8A1UnormBlock:
+                case vk::Format::eEtc2R8G8B8A1SrgbBlock:
+                case vk::Format::eEacR11UnormBlock:
+                case vk::Format::eEacR11SnormBlock:
+                    return {4, 4, 8};
+                case vk::Format::eBc2UnormBlock:
+                case vk::Format::eBc2SrgbBlock:
+                case vk::Format::eBc3UnormBlock:
+                case vk::Format::eBc3SrgbBlock:
+                case vk::Format::eBc5UnormBlock:
+                case vk::Format::eBc5SnormBlock:
+                case vk::Format::eBc6HUfloatBlock:
+                case vk::Format::eBc6HSfloatBlock:
+                case vk::Format::eBc7UnormBlock:
+                case vk::Format::eBc7SrgbBlock:
+                case vk::Format::eEtc2R8G8B8A8UnormBlock:
+                case vk::Format::eEtc2R8G8B8A8SrgbBlock:
+                case vk::Format::eEacR11G11UnormBlock:
+                case vk::Format::eEacR11G11SnormBlock:
+                    return {4, 4, 16};
+
+                // Every ASTC block takes 16 bytes, whatever its size
+                case vk::Format::eAstc4x4UnormBlock:
+                case vk::Format::eAstc4x4SrgbBlock:
+                    return {4, 4, 16};
+                case vk::Format::eAstc5x4UnormBlock:
+                case vk::Format::eAstc5x4SrgbBlock:
+                    return {5, 4, 16};
+                case vk::Format::eAstc5x5UnormBlock:
+                case vk::Format::eAstc5x5SrgbBlock:
+                    return {5, 5, 16};
+                case vk::Format::eAstc6x5UnormBlock:
+                case vk::Format::eAstc6x5SrgbBlock:
+                    return {6, 5, 16};
+                case vk::Format::eAstc6x6UnormBlock:
+                case vk::Format::eAstc6x6SrgbBlock:
+                    return {6, 6, 16};
+                case vk::Format::eAstc8x5UnormBlock:
+                case vk::Format::eAstc8x5SrgbBlock:
+                    return {8, 5, 16};
+                case vk::Format::eAstc8x6UnormBlock:
+                case vk::Format::eAstc8x6SrgbBlock:
+                    return {8, 6, 16};
+                case vk::Format::eAstc8x8UnormBlock:
+                case vk::Format::eAstc8x8SrgbBlock:
+                    return {8, 8, 16};
+                case vk::Format::eAstc10x5UnormBlock:
+                case vk::Format::eAstc10x5SrgbBlock:
+                    return {10, 5, 16};
+                case vk::Format::eAstc10x6UnormBlock:
+                case vk::Format::eAstc10x6SrgbBlock:
+                    return {10, 6, 16};
+                case vk::Format::eAstc10x8UnormBlock:
+                case vk::Format::eAstc10x8SrgbBlock:
+                    return {10, 8, 16};
+                case vk::Format::eAstc10x10UnormBlock:
+                case vk::Format::eAstc10x10SrgbBlock:
+                    return {10, 10, 16};
+                case vk::Format::eAstc12x10UnormBlock:
+                case vk::Format::eAstc12x10SrgbBlock:
+                    return {12, 10, 16};
+                case vk::Format::eAstc12x12UnormBlock:
+                case vk::Format::eAstc12x12SrgbBlock:
+                    return {12, 12, 16};
+
+                default:
+                    return {};
+            }
+        }
+    } // namespace
+
+    Ktx2Texture::Ktx2Texture(const std::string& path)
+        : m_path(path),
+          m_file(path)
+    {
+        const auto* data = m_file.GetData();
+        const auto size = m_file.GetSize();
+
+        Ktx2Header header;
+        if (size < sizeof(header))
+        {
+            throw std::runtime_error(fmt::format("KTX2 file '{}' is truncated!", path));
+        }
+        memcpy(&header, data, sizeof(header));
+
+        if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+        {
+            throw std::runtime_error(fmt::format("'{}' is not a KTX2 file!", path));
+        }
+
+        if (header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1)
+        {
+            throw std::runtime_error(fmt::format("KTX2 file '{}' is not a 2D texture! Arrays, cube maps and 3D textures are not supported", path));
+        }
+
+        if (header.supercompressionScheme != KTX2_SUPERCOMPRESSION_NONE && header.supercompressionScheme != KTX2_SUPERCOMPRESSION_BASIS_LZ)
+        {
+            throw std::runtime_error(fmt::format("KTX2 file '{}' uses unsupported supercompression scheme {}!", path, header.supercompressionScheme));
+        }
+
+        if (header.dfdByteLength < DFD_TRANSFER_FUNCTION_OFFSET + 1 || size_t(header.dfdByteOffset) + header.dfdByteLength > size)
+        {
+            throw std::runtime_error(fmt::format("KTX2 file '{}' has an invalid data format descriptor!", path));
+        }
+
+        const auto colorModel = data[header.dfdByteOffset + DFD_COLOR_MODEL_OFFSET];
+        m_isSrgb = data[header.dfdByteOffset + DFD_TRANSFER_FUNCTION_OFFSET] == KHR_DF_TRANSFER_SRGB;
+        m_isBasisUniversal = header.supercompressionScheme == KTX2_SUPERCOMPRESSION_BASIS_LZ || (header.vkFormat == 0 && colorModel == KHR_DF_MODEL_UASTC);
+        m_format = m_isBasisUniversal ? vk::Format::eUndefined : static_cast<vk::Format>(header.vkFormat);
+
+        if (!m_isBasisUniversal && m_format == vk::Format::eUndefined)
+        {
+            throw std::runtime_error(fmt::format("KTX2 file '{}' has no format!", path));
+        }
+
+        // Basis Universal levels are validated by the transcoder
+        const auto formatBlock = GetFormatBlock(m_format);
+        if (!m_isBasisUniversal && formatBlock.bytes == 0)
+        {
+            throw std::runtime_error(fmt::format("KTX2 file '{}' uses unsupported format {}!", path, vk::to_string(m_format)));
+        }
+
+        m_width = header.pixelWidth;
+        m_height = header.pixelHeight;
+
+        // A level count of 0 asks the loader to generate the mips, which compressed formats cannot be blitted for
+        const auto levelCount = std::max(header.levelCount, 1u);
+
+        // The chain ends with the level where both dimensions reach a single texel
+        uint32_t maxLevelCount = 1;
+        for (uint32_t extent = std::max(m_width, m_height); extent > 1; extent >>= 1)
+        {
+            ++maxLevelCount;
+        }
+
+        if (levelCount > maxLevelCount)
+        {
+            throw std::runtime_error(fmt::format("KTX2 file '{}' has too many levels! {} levels for {}x{} texels", path, levelCount, m_width, m_height));
+        }
+
+        if (sizeof(header) + size_t(levelCount) * sizeof(Ktx2LevelIndex) > size)
+        {
+            throw std::runtime_error(fmt::format("KTX2 file '{}' is truncated!", path));
+        }
+
+        m_levels.resize(levelCount);
+        for (uint32_t level = 0; level < levelCount; ++level)
+        {
+            Ktx2LevelIndex levelIndex;
+            memcpy(&levelIndex, data + sizeof(header) + level * sizeof(Ktx2LevelIndex), sizeof(levelIndex));
+
+            if (levelIndex.byteOffset > size || levelIndex.byteLength > size - levelIndex.byteOffset)
+            {
+                throw std::runtime_error(fmt::format("Level {} of KTX2 file '{}' lies outside of the file!", level, path));
+            }
+
+            auto& textureLevel = m_levels[level];
+            textureLevel.offset = static_cast<size_t>(levelIndex.byteOffset);
+            textureLevel.size = static_cast<size_t>(levelIndex.byteLength);
+            textureLevel.width = std::max(m_width >> level, 1u);
+            textureLevel.height = std::max(m_height >> level, 1u);
+
+            if (!m_isBasisUniversal)
+            {
+                const uint64_t blockCountX = (uint64_t(textureLevel.width) + formatBlock.width - 1) / formatBlock.width;
+                const uint64_t blockCountY = (uint64_t(textureLevel.height) + formatBlock.height - 1) / formatBlock.height;
+                if (levelIndex.byteLength < blockCountX * blockCountY * formatBlock.bytes)
+                {
+                    throw std::runtime_error(fmt::format("Level {} of KTX2 file '{}' is smaller than its {}x{} texels!", level, path, textureLevel.width, textureLevel.height));
+                }
+            }
+        }
+    }
+
+    vk::Format Ktx2Texture::GetFormat() const
+    {
+        return m_format;
+    }
+
+    bool Ktx2Texture::IsBasisUniversal() const
+    {
+        return m_isBasisUniversal;
+    }
+
+    bool Ktx2Texture::IsSrgb() const
+    {
+        return m_isSrgb;
+    }
+
+    uint32_t Ktx2Texture::GetWidth() const
+    {
+        return m_width;
+    }
+
+    uint32_t Ktx2Texture::GetHeight() const
+    {
+        return m_height;
+    }
+
+    const std::vector<TextureLevel>& Ktx2Texture::GetLevels() const
+    {
+        return m_levels;
+    }
+
+    const uint8_t* Ktx2Texture::GetFileData() const
+    {
+        return m_file.GetData();
+    }
+
+    size_t Ktx2Texture::GetFileSize() const
+    {
+        return m_file.GetSize();
+    }
+
+    const std::string& Ktx2Texture::GetPath() const
+    {
+        return m_path;
+    }
+} // namespace vr
@@ -0,0 +1,206 @@
+#include "VulkanRenderer/Assets/Mesh.h"
+
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace vr
+{
+    namespace
+    {
+        /** Maps the direction onto an octahedron unfolded over [-1, 1]^2, which spreads the precision evenly over every direction */
+        std::array<int16_t, 2> PackNormal(const glm::vec3& normal)
+        {
+            const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+            if (length == 0.0f)
+            {
+                // Vertices without a normal face +Z, which is encoded as the center of the octahedron
+                return {0, 0};
+            }
+
+            glm::vec2 encoded = glm::vec2(normal.x, normal.y) / length;
+            if (normal.z < 0.0f)
+            {
+                // The lower half of the octahedron is folded over the corners of the square
+                const glm::vec2 signs(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+                encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * signs;
+            }
+
+            const uint32_t packed = glm::packSnorm2x16(encoded);
+            std::array<int16_t, 2> components;
+            memcpy(components.data(), &packed, sizeof(packed));
+            return components;
+        }
+
+        std::array<uint8_t, 4> PackColor(const glm::vec3& color)
+        {
+            const uint32_t packed = glm::packUnorm4x8(glm::vec4(color, 1.0f));
+            std::array<uint8_t, 4> components;
+            memcpy(components.data(), &packed, sizeof(packed));
+            return components;
+        }
+    } // namespace
+
+    Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+    {
+        m_vertexCount = static_cast<uint32_t>(vertices.size());
+        m_indexCount = static_cast<uint32_t>(indices.size());
+
+        if (!vertices.empty())
+        {
+            m_bounds.min = m_bounds.max = vertices.front().pos;
+            for (const auto& vertex : vertices)
+            {
+                m_bounds.min = glm::min(m_bounds.min, vertex.pos);
+                m_bounds.max = glm::max(m_bounds.max, vertex.pos);
+            }
+
+            // Tighter than the sphere around the whole box, as the vertices rarely reach its corners
+            m_boundingSphere.center = 0.5f * (m_bounds.min + m_bounds.max);
+            float maxDistanceSquared = 0.0f;
+            for (const auto& vertex : vertices)
+            {
+                const glm::vec3 offset = vertex.pos - m_boundingSphere.center;
+                maxDistanceSquared = std::max(maxDistanceSquared, glm::dot(offset, offset));
+            }
+            m_boundingSphere.radius = std::sqrt(maxDistanceSquared);
+
+            // Attributes with a single value are read from the constants instead of being stored per vertex
+            const auto& firstVertex = vertices.front();
+            m_vertexFormat.hasNormals = std::any_of(vertices.begin(), vertices.end(), [&](const Vertex& vertex) { return vertex.normal != firstVertex.normal; });
+            m_vertexFormat.hasColors = std::any_of(vertices.begin(), vertices.end(), [&](const Vertex& vertex) { return vertex.color != firstVertex.color; });
+            m_vertexFormat.constants.normal = PackNormal(firstVertex.normal);
+            m_vertexFormat.constants.color = PackColor(firstVertex.color);
+        }
+
+        const uint32_t stride = m_vertexFormat.GetStride();
+        const uint32_t colorOffset = m_vertexFormat.GetColorOffset();
+        m_ownedVertices.resize(static_cast<size_t>(m_vertexCount) * stride);
+
+        // Flat axes have no extent to quantize, every position lies at their minimum
+        const glm::vec3 extent = m_bounds.max - m_bounds.min;
+        const glm::vec3 inverseExtent(
+            extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+            extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+            extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            const auto& vertex = vertices[i];
+            auto* packedVertex = m_ownedVertices.data() + i * stride;
+
+            const uint64_t position = glm::packUnorm4x16(glm::vec4((vertex.pos - m_bounds.min) * inverseExtent, 0.0f));
+            memcpy(packedVertex + VertexFormat::POSITION_OFFSET, &position, sizeof(position));
+
+            const uint32_t texCoord = glm::packHalf2x16(vertex.texCoord);
+            memcpy(packedVertex + VertexFormat::TEX_COORD_OFFSET, &texCoord, sizeof(texCoord));
+
+            if (m_vertexFormat.hasNormals)
+            {
+                const auto normal = PackNormal(vertex.normal);
+                memcpy(packedVertex + VertexFormat::NORMAL_OFFSET, normal.data(), VertexFormat::NORMAL_SIZE);
+            }
+
+            if (m_vertexFormat.hasColors)
+            {
+                const auto color = PackColor(vertex.color);
+                memcpy(packedVertex + colorOffset, color.data(), VertexFormat::COLOR_SIZE);
+            }
+        }
+        m_vertexData = m_ownedVertices.data();
+
+        // Index 0xFFFF is left out, so 16-bit indices never collide with the primitive restart value
+        m_indexType = m_vertexCount <= std::numeric_limits<uint16_t>::max() ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+
+        m_ownedIndices.resize(m_indexCount * GetIndexSize(m_indexType));
+        if (m_indexType == vk::IndexType::eUint16)
+        {
+            auto* indices16 = reinterpret_cast<uint16_t*>(m_ownedIndices.data());
+            std::transform(indices.begin(), indices.end(), indices16, [](uint32_t index) { return static_cast<uint16_t>(index); });
+        }
+        else if (!indices.empty())
+        {
+            memcpy(m_ownedIndices.data(), indices.data(), m_ownedIndices.size());
+        }
+        m_indexData = m_ownedIndices.data();
+    }
+
+    Mesh::Mesh(
+        MappedFile file,
+        size_t vertexDataOffset,
+        uint32_t vertexCount,
+        const VertexFormat& vertexFormat,
+        size_t indexDataOffset,
+        uint32_t indexCount,
+        vk::IndexType indexType,
+        const BoundingBox& bounds,
+        const BoundingSphere& boundingSphere)
+        : m_file(std::move(file)),
+          m_vertexCount(vertexCount),
+          m_vertexFormat(vertexFormat),
+          m_indexCount(indexCount),
+          m_indexType(indexType),
+          m_bounds(bounds),
+          m_boundingSphere(boundingSphere)
+    {
+        m_vertexData = m_file.GetData() + vertexDataOffset;
+        m_indexData = m_file.GetData() + indexDataOffset;
+    }
+
+    const void* Mesh::GetVertexData() const
+    {
+        return m_vertexData;
+    }
+
+    vk::DeviceSize Mesh::GetVertexDataSize() const
+    {
+        return static_cast<vk::DeviceSize>(m_vertexCount) * m_vertexFormat.GetStride();
+    }
+
+    uint32_t Mesh::GetVertexCount() const
+    {
+        return m_vertexCount;
+    }
+
+    const VertexFormat& Mesh::GetVertexFormat() const
+    {
+        return m_vertexFormat;
+    }
+
+    const void* Mesh::GetIndexData() const
+    {
+        return m_indexData;
+    }
+
+    vk::DeviceSize Mesh::GetIndexDataSize() const
+    {
+        return static_cast<vk::DeviceSize>(m_indexCount) * GetIndexSize(m_indexType);
+    }
+
+    uint32_t Mesh::GetIndexCount() const
+    {
+        return m_indexCount;
+    }
+
+    vk::IndexType Mesh::GetIndexType() const
+    {
+        return m_indexType;
+    }
+
+    const BoundingBox& Mesh::GetBounds() const
+    {
+        return m_bounds;
+    }
+
+    const BoundingSphere& Mesh::GetBoundingSphere() const
+    {
+        return m_boundingSphere;
+    }
+
+    vk::DeviceSize Mesh::GetIndexSize(vk::IndexType indexType)
+    {
+        return indexType == vk::IndexType::eUint16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+} // namespace vr
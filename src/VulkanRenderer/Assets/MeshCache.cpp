@@ -0,0 +1,256 @@
+#include "VulkanRenderer/Assets/MeshCache.h"
+#include "VulkanRenderer/Utils/Hash.h"
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace vr
+{
+    namespace
+    {
+        constexpr uint32_t MESH_CACHE_MAGIC = 0x48534D56; // "VMSH"
+        constexpr uint32_t MESH_CACHE_VERSION = 3;
+        constexpr size_t MESH_CACHE_BLOB_ALIGNMENT = 16;
+
+        /** Vertex attributes stored per vertex */
+        constexpr uint32_t MESH_CACHE_NORMALS_BIT = 1u << 0;
+        constexpr uint32_t MESH_CACHE_COLORS_BIT = 1u << 1;
+
+        struct MeshCacheHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t sourceHash;
+
+            uint32_t vertexStride;
+            uint32_t vertexCount;
+            uint64_t vertexDataOffset;
+            uint32_t vertexAttributes;
+            ConstantVertexAttributes constantVertexAttributes;
+
+            uint32_t indexSize;
+            uint32_t indexCount;
+            uint64_t indexDataOffset;
+
+            float boundsMin[3];
+            float boundsMax[3];
+            /** Center and radius */
+            float boundingSphere[4];
+        };
+
+        size_t AlignBlobOffset(size_t offset)
+        {
+            return (offset + MESH_CACHE_BLOB_ALIGNMENT - 1) & ~(MESH_CACHE_BLOB_ALIGNMENT - 1);
+        }
+
+        /** Written so that offsets and sizes read from a corrupted file cannot overflow */
+        bool IsBlobInFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+        {
+            return offset <= fileSize && size <= fileSize - offset;
+        }
+
+        bool IsBlobOffsetAligned(uint64_t offset)
+        {
+            return offset % MESH_CACHE_BLOB_ALIGNMENT == 0;
+        }
+
+        /** The offset comes from the file, so the indices are read without assuming their alignment */
+        template<typename IndexType>
+        uint32_t FindMaxIndex(const uint8_t* indexData, uint32_t indexCount)
+        {
+            uint32_t maxIndex = 0;
+            for (uint32_t i = 0; i < indexCount; ++i)
+            {
+                IndexType index;
+                memcpy(&index, indexData + static_cast<size_t>(i) * sizeof(IndexType), sizeof(IndexType));
+                maxIndex = std::max(maxIndex, static_cast<uint32_t>(index));
+            }
+
+            return maxIndex;
+        }
+    } // namespace
+
+    MeshCache::MeshCache(const std::string& sourcePath)
+        : m_cachePath(sourcePath + CACHE_EXTENSION)
+    {
+        const MappedFile sourceFile(sourcePath);
+        m_sourceHash = HashBytes(sourceFile.GetData(), sourceFile.GetSize());
+    }
+
+    std::optional<Mesh> MeshCache::Load() const
+    {
+        std::error_code error;
+        if (!std::filesystem::exists(m_cachePath, error))
+        {
+            return std::nullopt;
+        }
+
+        MappedFile file;
+        try
+        {
+            file = MappedFile(m_cachePath);
+        }
+        catch (const std::exception& exception)
+        {
+            spdlog::warn("Mesh cache '{}' could not be mapped: {}", m_cachePath, exception.what());
+            return std::nullopt;
+        }
+
+        if (file.GetSize() < sizeof(MeshCacheHeader))
+        {
+            spdlog::warn("Mesh cache '{}' is truncated, it will be rebuilt", m_cachePath);
+            return std::nullopt;
+        }
+
+        MeshCacheHeader header;
+        memcpy(&header, file.GetData(), sizeof(header));
+
+        VertexFormat vertexFormat;
+        vertexFormat.hasNormals = (header.vertexAttributes & MESH_CACHE_NORMALS_BIT) != 0;
+        vertexFormat.hasColors = (header.vertexAttributes & MESH_CACHE_COLORS_BIT) != 0;
+        vertexFormat.constants = header.constantVertexAttributes;
+
+        if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION || header.vertexStride != vertexFormat.GetStride())
+        {
+            spdlog::info("Mesh cache '{}' has an incompatible format, it will be rebuilt", m_cachePath);
+            return std::nullopt;
+        }
+
+        if (header.sourceHash != m_sourceHash)
+        {
+            spdlog::info("Mesh cache '{}' is out of date, it will be rebuilt", m_cachePath);
+            return std::nullopt;
+        }
+
+        if (header.indexSize != sizeof(uint16_t) && header.indexSize != sizeof(uint32_t))
+        {
+            spdlog::warn("Mesh cache '{}' is corrupted, it will be rebuilt", m_cachePath);
+            return std::nullopt;
+        }
+
+        // Vertices come first, then indices, each at an aligned offset
+        const uint64_t vertexDataSize = static_cast<uint64_t>(header.vertexCount) * header.vertexStride;
+        const uint64_t indexDataSize = static_cast<uint64_t>(header.indexCount) * header.indexSize;
+        const bool isVertexDataValid = header.vertexDataOffset >= sizeof(MeshCacheHeader) && IsBlobOffsetAligned(header.vertexDataOffset)
+            && IsBlobInFile(header.vertexDataOffset, vertexDataSize, file.GetSize());
+        const bool isIndexDataValid = isVertexDataValid && header.indexDataOffset >= header.vertexDataOffset + vertexDataSize
+            && IsBlobOffsetAligned(header.indexDataOffset) && IsBlobInFile(header.indexDataOffset, indexDataSize, file.GetSize());
+        if (!isVertexDataValid || !isIndexDataValid)
+        {
+            spdlog::warn("Mesh cache '{}' is corrupted, it will be rebuilt", m_cachePath);
+            return std::nullopt;
+        }
+
+        // Indices go straight to the GPU, so a cache referencing vertices it does not have is never used
+        const auto* indexData = file.GetData() + header.indexDataOffset;
+        const auto maxIndex = header.indexSize == sizeof(uint16_t)
+            ? FindMaxIndex<uint16_t>(indexData, header.indexCount)
+            : FindMaxIndex<uint32_t>(indexData, header.indexCount);
+        if (header.indexCount > 0 && maxIndex >= header.vertexCount)
+        {
+            spdlog::warn("Mesh cache '{}' is corrupted, it will be rebuilt", m_cachePath);
+            return std::nullopt;
+        }
+
+        BoundingBox bounds;
+        bounds.min = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+        bounds.max = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+
+        BoundingSphere boundingSphere;
+        boundingSphere.center = glm::vec3(header.boundingSphere[0], header.boundingSphere[1], header.boundingSphere[2]);
+        boundingSphere.radius = header.boundingSphere[3];
+
+        return Mesh(
+            std::move(file),
+            static_cast<size_t>(header.vertexDataOffset),
+            header.vertexCount,
+            vertexFormat,
+            static_cast<size_t>(header.indexDataOffset),
+            header.indexCount,
+            header.indexSize == sizeof(uint16_t) ? vk::IndexType::eUint16 : vk::IndexType::eUint32,
+            bounds,
+            boundingSphere);
+    }
+
+    void MeshCache::Store(const Mesh& mesh) const
+    {
+        MeshCacheHeader header = {};
+        header.magic = MESH_CACHE_MAGIC;
+        header.version = MESH_CACHE_VERSION;
+        header.sourceHash = m_sourceHash;
+        const auto& vertexFormat = mesh.GetVertexFormat();
+        header.vertexStride = vertexFormat.GetStride();
+        header.vertexCount = mesh.GetVertexCount();
+        header.vertexDataOffset = AlignBlobOffset(sizeof(MeshCacheHeader));
+        header.vertexAttributes = (vertexFormat.hasNormals ? MESH_CACHE_NORMALS_BIT : 0) | (vertexFormat.hasColors ? MESH_CACHE_COLORS_BIT : 0);
+        header.constantVertexAttributes = vertexFormat.constants;
+        header.indexSize = static_cast<uint32_t>(Mesh::GetIndexSize(mesh.GetIndexType()));
+        header.indexCount = mesh.GetIndexCount();
+        header.indexDataOffset = AlignBlobOffset(header.vertexDataOffset + mesh.GetVertexDataSize());
+
+        const auto& bounds = mesh.GetBounds();
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            header.boundsMin[axis] = bounds.min[axis];
+            header.boundsMax[axis] = bounds.max[axis];
+        }
+
+        const auto& boundingSphere = mesh.GetBoundingSphere();
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            header.boundingSphere[axis] = boundingSphere.center[axis];
+        }
+        header.boundingSphere[3] = boundingSphere.radius;
+
+        // The cache is written under a temporary name first, so an interrupted write never leaves a valid looking file behind
+        const std::string temporaryPath = m_cachePath + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                spdlog::warn("Failed to create mesh cache '{}'", temporaryPath);
+                return;
+            }
+
+            const char padding[MESH_CACHE_BLOB_ALIGNMENT] = {};
+            const auto writePadding = [&](uint64_t offset) {
+                file.write(padding, static_cast<std::streamsize>(offset - static_cast<uint64_t>(file.tellp())));
+            };
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            writePadding(header.vertexDataOffset);
+            file.write(static_cast<const char*>(mesh.GetVertexData()), static_cast<std::streamsize>(mesh.GetVertexDataSize()));
+            writePadding(header.indexDataOffset);
+            file.write(static_cast<const char*>(mesh.GetIndexData()), static_cast<std::streamsize>(mesh.GetIndexDataSize()));
+
+            if (!file.good())
+            {
+                spdlog::warn("Failed to write mesh cache '{}'", temporaryPath);
+                file.close();
+
+                std::error_code error;
+                std::filesystem::remove(temporaryPath, error);
+                return;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, m_cachePath, error);
+        if (error)
+        {
+            spdlog::warn("Failed to move mesh cache into place at '{}': {}", m_cachePath, error.message());
+            std::filesystem::remove(temporaryPath, error);
+            return;
+        }
+
+        spdlog::info("Mesh cache written to '{}'", m_cachePath);
+    }
+
+    const std::string& MeshCache::GetCachePath() const
+    {
+        return m_cachePath;
+    }
+} // namespace vr
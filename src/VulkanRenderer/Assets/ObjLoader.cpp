@@ -0,0 +1,655 @@
+#include "VulkanRenderer/Assets/ObjLoader.h"
+#include "VulkanRenderer/Utils/MappedFile.h"
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <VulkanRenderer/Vendors/tiny_obj_loader.h>
+
+namespace vr
+{
+    namespace
+    {
+        using real_t = tinyobj::real_t;
+
+        /** Face index components referring to elements relative to the end of the attribute arrays ('f -1 -2 -3') */
+        enum RelativeComponent : uint8_t
+        {
+            RELATIVE_VERTEX = 1 << 0,
+            RELATIVE_TEXCOORD = 1 << 1,
+            RELATIVE_NORMAL = 1 << 2
+        };
+
+        struct RelativeIndexFixup
+        {
+            size_t indexPosition;
+            uint8_t components;
+        };
+
+        /** Start of a new shape ('g' or 'o' statement), placed before the index at the given position */
+        struct ShapeMark
+        {
+            size_t indexPosition;
+            std::string name;
+        };
+
+        /**
+         * Output of a single chunk. Relative face indices cannot be resolved until the number of attributes
+         * in preceding chunks is known, so they are stored relative to the chunk start and listed as fixups.
+         */
+        struct ChunkResult
+        {
+            std::vector<real_t> vertices;
+            std::vector<real_t> colors;
+            std::vector<real_t> normals;
+            std::vector<real_t> texcoords;
+            std::vector<tinyobj::index_t> indices;
+
+            std::vector<RelativeIndexFixup> fixups;
+            std::vector<ShapeMark> shapeMarks;
+
+            /** Offsets of this chunk's elements in the merged arrays */
+            size_t vertexOffset = 0;
+            size_t normalOffset = 0;
+            size_t texcoordOffset = 0;
+        };
+
+        inline bool IsSpace(char character)
+        {
+            return character == ' ' || character == '\t' || character == '\r';
+        }
+
+        inline bool IsDigit(char character)
+        {
+            return static_cast<unsigned char>(character - '0') < 10;
+        }
+
+        inline const char* SkipSpaces(const char* cursor, const char* end)
+        {
+            while (cursor < end && IsSpace(*cursor))
+            {
+                ++cursor;
+            }
+
+            return cursor;
+        }
+
+        inline const char* SkipToken(const char* cursor, const char* end)
+        {
+            while (cursor < end && !IsSpace(*cursor))
+            {
+                ++cursor;
+            }
+
+            return cursor;
+        }
+
+        /** Slow path for inputs the fast path cannot represent exactly, e.g. very long mantissas, 'inf' or 'nan' */
+        const char* ParseFloatFallback(const char* cursor, const char* end, real_t& value)
+        {
+            const char* tokenEnd = SkipToken(cursor, end);
+
+            char buffer[128];
+            const size_t length = std::min(static_cast<size_t>(tokenEnd - cursor), sizeof(buffer) - 1);
+            memcpy(buffer, cursor, length);
+            buffer[length] = '\0';
+
+            value = static_cast<real_t>(strtod(buffer, nullptr));
+
+            return tokenEnd;
+        }
+
+        /**
+         * Parses a decimal floating point number. Mantissas of up to 19 digits are accumulated as an integer
+         * and scaled by an exactly representable power of ten, which yields correctly rounded doubles
+         * for every number written by common exporters. Anything else falls back to strtod.
+         * Leaves the value at zero if there is no number, like tinyobj does.
+         */
+        const char* ParseFloat(const char* cursor, const char* end, real_t& value)
+        {
+            static constexpr double POWERS_OF_TEN[] = {
+                1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+            static constexpr uint64_t MAX_EXACT_MANTISSA = 1ull << 53;
+            static constexpr int MAX_MANTISSA_DIGITS = 19;
+
+            value = 0;
+            cursor = SkipSpaces(cursor, end);
+            const char* start = cursor;
+
+            bool isNegative = false;
+            if (cursor < end && (*cursor == '-' || *cursor == '+'))
+            {
+                isNegative = *cursor == '-';
+                ++cursor;
+            }
+
+            uint64_t mantissa = 0;
+            int digitsCount = 0;
+            int exponent = 0;
+            bool hasDigits = false;
+
+            for (; cursor < end && IsDigit(*cursor); ++cursor)
+            {
+                hasDigits = true;
+                if (digitsCount < MAX_MANTISSA_DIGITS)
+                {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+                    digitsCount += mantissa != 0 ? 1 : 0;
+                }
+                else
+                {
+                    ++exponent;
+                }
+            }
+
+            if (cursor < end && *cursor == '.')
+            {
+                ++cursor;
+                for (; cursor < end && IsDigit(*cursor); ++cursor)
+                {
+                    hasDigits = true;
+                    if (digitsCount < MAX_MANTISSA_DIGITS)
+                    {
+                        mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+                        digitsCount += mantissa != 0 ? 1 : 0;
+                        --exponent;
+                    }
+                }
+            }
+
+            if (!hasDigits)
+            {
+                return ParseFloatFallback(start, end, value);
+            }
+
+            if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+            {
+                const char* exponentCursor = cursor + 1;
+                bool isExponentNegative = false;
+                if (exponentCursor < end && (*exponentCursor == '-' || *exponentCursor == '+'))
+                {
+                    isExponentNegative = *exponentCursor == '-';
+                    ++exponentCursor;
+                }
+
+                if (exponentCursor < end && IsDigit(*exponentCursor))
+                {
+                    int explicitExponent = 0;
+                    for (; exponentCursor < end && IsDigit(*exponentCursor); ++exponentCursor)
+                    {
+                        explicitExponent = std::min(explicitExponent * 10 + (*exponentCursor - '0'), 100000);
+                    }
+
+                    exponent += isExponentNegative ? -explicitExponent : explicitExponent;
+                    cursor = exponentCursor;
+                }
+            }
+
+            // Digits dropped from the mantissa or trailing garbage mean the fast path is not exact
+            if (digitsCount >= MAX_MANTISSA_DIGITS || mantissa > MAX_EXACT_MANTISSA || exponent < -22 || exponent > 22 ||
+                (cursor < end && !IsSpace(*cursor)))
+            {
+                return ParseFloatFallback(start, end, value);
+            }
+
+            double result = static_cast<double>(mantissa);
+            result = exponent < 0 ? result / POWERS_OF_TEN[-exponent] : result * POWERS_OF_TEN[exponent];
+
+            value = static_cast<real_t>(isNegative ? -result : result);
+
+            return cursor;
+        }
+
+        /** Returns false if there is no integer at the cursor */
+        inline bool ParseInt(const char*& cursor, const char* end, int& value)
+        {
+            bool isNegative = false;
+            if (cursor < end && (*cursor == '-' || *cursor == '+'))
+            {
+                isNegative = *cursor == '-';
+                ++cursor;
+            }
+
+            if (cursor >= end || !IsDigit(*cursor))
+            {
+                return false;
+            }
+
+            int64_t result = 0;
+            for (; cursor < end && IsDigit(*cursor); ++cursor)
+            {
+                result = std::min<int64_t>(result * 10 + (*cursor - '0'), std::numeric_limits<int>::max());
+            }
+
+            value = static_cast<int>(isNegative ? -result : result);
+
+            return true;
+        }
+
+        /**
+         * Parses a 'v', 'v/vt', 'v//vn' or 'v/vt/vn' face corner. Absolute indices are converted to zero based ones,
+         * relative indices are resolved against the attribute counts of the chunk and flagged for a fixup.
+         * Missing components are set to -1.
+         */
+        bool ParseFaceCorner(const char*& cursor, const char* end, const ChunkResult& chunk, tinyobj::index_t& index, uint8_t& relativeComponents)
+        {
+            const auto resolve = [&](int rawIndex, size_t count, RelativeComponent component, int& resolved) {
+                if (rawIndex == 0)
+                {
+                    return false;
+                }
+
+                if (rawIndex > 0)
+                {
+                    resolved = rawIndex - 1;
+                }
+                else
+                {
+                    resolved = static_cast<int>(count) + rawIndex;
+                    relativeComponents |= component;
+                }
+
+                return true;
+            };
+
+            index.vertex_index = -1;
+            index.texcoord_index = -1;
+            index.normal_index = -1;
+            relativeComponents = 0;
+
+            int rawIndex = 0;
+            if (!ParseInt(cursor, end, rawIndex) || !resolve(rawIndex, chunk.vertices.size() / 3, RELATIVE_VERTEX, index.vertex_index))
+            {
+                return false;
+            }
+
+            if (cursor >= end || *cursor != '/')
+            {
+                return true;
+            }
+            ++cursor;
+
+            if (cursor < end && *cursor != '/')
+            {
+                if (!ParseInt(cursor, end, rawIndex) || !resolve(rawIndex, chunk.texcoords.size() / 2, RELATIVE_TEXCOORD, index.texcoord_index))
+                {
+                    return false;
+                }
+            }
+
+            if (cursor >= end || *cursor != '/')
+            {
+                return true;
+            }
+            ++cursor;
+
+            return ParseInt(cursor, end, rawIndex) && resolve(rawIndex, chunk.normals.size() / 3, RELATIVE_NORMAL, index.normal_index);
+        }
+
+        void ParseFace(const char* cursor, const char* end, ChunkResult& chunk, std::vector<tinyobj::index_t>& corners, std::vector<uint8_t>& cornerFlags)
+        {
+            corners.clear();
+            cornerFlags.clear();
+
+            const char* faceBegin = cursor;
+            cursor = SkipSpaces(cursor, end);
+            while (cursor < end)
+            {
+                tinyobj::index_t corner;
+                uint8_t relativeComponents;
+                if (!ParseFaceCorner(cursor, end, chunk, corner, relativeComponents))
+                {
+                    throw std::runtime_error(fmt::format("Failed to parse face 'f{}' (e.g. zero value for face index)!", std::string(faceBegin, end)));
+                }
+
+                corners.push_back(corner);
+                cornerFlags.push_back(relativeComponents);
+
+                cursor = SkipSpaces(cursor, end);
+            }
+
+            // Faces with less than three corners are dropped, as in tinyobj
+            if (corners.size() < 3)
+            {
+                return;
+            }
+
+            const auto emit = [&](size_t corner) {
+                if (cornerFlags[corner] != 0)
+                {
+                    chunk.fixups.push_back({chunk.indices.size(), cornerFlags[corner]});
+                }
+                chunk.indices.push_back(corners[corner]);
+            };
+
+            for (size_t corner = 1; corner + 1 < corners.size(); ++corner)
+            {
+                emit(0);
+                emit(corner);
+                emit(corner + 1);
+            }
+        }
+
+        std::string ParseGroupName(const char* cursor, const char* end)
+        {
+            // Multiple group names are joined with a space, as in tinyobj
+            std::string name;
+            cursor = SkipSpaces(cursor, end);
+            while (cursor < end)
+            {
+                const char* tokenEnd = SkipToken(cursor, end);
+                if (!name.empty())
+                {
+                    name += ' ';
+                }
+                name.append(cursor, tokenEnd);
+
+                cursor = SkipSpaces(tokenEnd, end);
+            }
+
+            return name;
+        }
+
+        void ParseChunk(const char* begin, const char* end, ChunkResult& chunk)
+        {
+            // Rough reservation based on the typical line length, so most chunks never reallocate
+            const size_t estimatedLines = static_cast<size_t>(end - begin) / 32;
+            chunk.vertices.reserve(estimatedLines);
+            chunk.indices.reserve(estimatedLines);
+
+            std::vector<tinyobj::index_t> corners;
+            std::vector<uint8_t> cornerFlags;
+
+            const char* lineBegin = begin;
+            while (lineBegin < end)
+            {
+                const char* lineEnd = static_cast<const char*>(memchr(lineBegin, '\n', static_cast<size_t>(end - lineBegin)));
+                lineEnd = lineEnd != nullptr ? lineEnd : end;
+
+                const char* nextLine = lineEnd + (lineEnd < end ? 1 : 0);
+                if (lineEnd > lineBegin && lineEnd[-1] == '\r')
+                {
+                    --lineEnd;
+                }
+
+                const char* cursor = SkipSpaces(lineBegin, lineEnd);
+                const size_t length = static_cast<size_t>(lineEnd - cursor);
+                lineBegin = nextLine;
+
+                if (length < 2)
+                {
+                    continue;
+                }
+
+                if (cursor[0] == 'v' && IsSpace(cursor[1]))
+                {
+                    real_t x, y, z;
+                    cursor = ParseFloat(cursor + 2, lineEnd, x);
+                    cursor = ParseFloat(cursor, lineEnd, y);
+                    cursor = ParseFloat(cursor, lineEnd, z);
+                    chunk.vertices.insert(chunk.vertices.end(), {x, y, z});
+
+                    // Vertex colors default to white, as with tinyobj's default_vcols_fallback
+                    real_t r = 1, g = 1, b = 1;
+                    if (SkipSpaces(cursor, lineEnd) < lineEnd)
+                    {
+                        cursor = ParseFloat(cursor, lineEnd, r);
+                        cursor = ParseFloat(cursor, lineEnd, g);
+                        cursor = ParseFloat(cursor, lineEnd, b);
+                    }
+                    chunk.colors.insert(chunk.colors.end(), {r, g, b});
+                }
+                else if (length > 2 && cursor[0] == 'v' && cursor[1] == 't' && IsSpace(cursor[2]))
+                {
+                    real_t u, v;
+                    cursor = ParseFloat(cursor + 3, lineEnd, u);
+                    cursor = ParseFloat(cursor, lineEnd, v);
+                    chunk.texcoords.insert(chunk.texcoords.end(), {u, v});
+                }
+                else if (length > 2 && cursor[0] == 'v' && cursor[1] == 'n' && IsSpace(cursor[2]))
+                {
+                    real_t x, y, z;
+                    cursor = ParseFloat(cursor + 3, lineEnd, x);
+                    cursor = ParseFloat(cursor, lineEnd, y);
+                    cursor = ParseFloat(cursor, lineEnd, z);
+                    chunk.normals.insert(chunk.normals.end(), {x, y, z});
+                }
+                else if (cursor[0] == 'f' && IsSpace(cursor[1]))
+                {
+                    ParseFace(cursor + 2, lineEnd, chunk, corners, cornerFlags);
+                }
+                else if (cursor[0] == 'g' && IsSpace(cursor[1]))
+                {
+                    chunk.shapeMarks.push_back({chunk.indices.size(), ParseGroupName(cursor + 2, lineEnd)});
+                }
+                else if (cursor[0] == 'o' && IsSpace(cursor[1]))
+                {
+                    // Object names span the whole rest of the line, as in tinyobj
+                    chunk.shapeMarks.push_back({chunk.indices.size(), std::string(cursor + 2, lineEnd)});
+                }
+            }
+        }
+
+        /** Splits the range into chunks which begin right after a line break */
+        std::vector<std::pair<const char*, const char*>> SplitIntoChunks(const char* begin, const char* end, size_t chunksCount)
+        {
+            std::vector<std::pair<const char*, const char*>> chunks;
+
+            const size_t chunkSize = static_cast<size_t>(end - begin) / chunksCount;
+            const char* chunkBegin = begin;
+            for (size_t chunk = 1; chunk <= chunksCount && chunkBegin < end; ++chunk)
+            {
+                const char* chunkEnd = end;
+                if (chunk < chunksCount)
+                {
+                    const char* splitPoint = std::max(chunkBegin, begin + chunk * chunkSize);
+                    const auto* lineBreak = static_cast<const char*>(memchr(splitPoint, '\n', static_cast<size_t>(end - splitPoint)));
+                    chunkEnd = lineBreak != nullptr ? lineBreak + 1 : end;
+                }
+
+                chunks.emplace_back(chunkBegin, chunkEnd);
+                chunkBegin = chunkEnd;
+            }
+
+            return chunks;
+        }
+
+        /** Runs the function for every index in [0, count) on up to threadCount threads, rethrowing the first exception */
+        template<typename Function>
+        void ParallelFor(size_t count, uint32_t threadCount, const Function& function)
+        {
+            std::atomic<size_t> nextIndex = 0;
+            std::exception_ptr exception;
+            std::mutex exceptionMutex;
+
+            const auto worker = [&]() {
+                for (size_t index = nextIndex++; index < count; index = nextIndex++)
+                {
+                    try
+                    {
+                        function(index);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard lock(exceptionMutex);
+                        if (!exception)
+                        {
+                            exception = std::current_exception();
+                        }
+                    }
+                }
+            };
+
+            const auto workersCount = static_cast<uint32_t>(std::min<size_t>(threadCount, count));
+            std::vector<std::thread> workers;
+            for (uint32_t thread = 1; thread < workersCount; ++thread)
+            {
+                workers.emplace_back(worker);
+            }
+
+            // The calling thread takes part in the work as well
+            worker();
+
+            for (auto& thread : workers)
+            {
+                thread.join();
+            }
+
+            if (exception)
+            {
+                std::rethrow_exception(exception);
+            }
+        }
+
+        template<typename T>
+        void AppendChunkData(std::vector<T>& destination, size_t offset, const std::vector<T>& source)
+        {
+            if (!source.empty())
+            {
+                memcpy(destination.data() + offset, source.data(), source.size() * sizeof(T));
+            }
+        }
+    } // namespace
+
+    ObjLoader::ObjLoader(uint32_t threadCount)
+        : m_threadCount(threadCount != 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency()))
+    {
+    }
+
+    void ObjLoader::Load(const std::string& path, tinyobj::attrib_t& attrib, std::vector<tinyobj::shape_t>& shapes) const
+    {
+        const MappedFile file(path);
+        const auto* begin = reinterpret_cast<const char*>(file.GetData());
+        const auto* end = begin + file.GetSize();
+
+        const size_t maxChunksCount = std::max<size_t>(1, file.GetSize() / MIN_CHUNK_SIZE);
+        const auto ranges = SplitIntoChunks(begin, end, std::min<size_t>(maxChunksCount, static_cast<size_t>(m_threadCount) * CHUNKS_PER_THREAD));
+
+        std::vector<ChunkResult> chunks(ranges.size());
+        ParallelFor(chunks.size(), m_threadCount, [&](size_t chunk) { ParseChunk(ranges[chunk].first, ranges[chunk].second, chunks[chunk]); });
+
+        /** Attributes */
+        size_t verticesCount = 0;
+        size_t normalsCount = 0;
+        size_t texcoordsCount = 0;
+        for (auto& chunk : chunks)
+        {
+            chunk.vertexOffset = verticesCount;
+            chunk.normalOffset = normalsCount;
+            chunk.texcoordOffset = texcoordsCount;
+
+            verticesCount += chunk.vertices.size();
+            normalsCount += chunk.normals.size();
+            texcoordsCount += chunk.texcoords.size();
+        }
+
+        attrib = tinyobj::attrib_t();
+        attrib.vertices.resize(verticesCount);
+        attrib.colors.resize(verticesCount);
+        attrib.normals.resize(normalsCount);
+        attrib.texcoords.resize(texcoordsCount);
+
+        ParallelFor(chunks.size(), m_threadCount, [&](size_t chunkIndex) {
+            auto& chunk = chunks[chunkIndex];
+            AppendChunkData(attrib.vertices, chunk.vertexOffset, chunk.vertices);
+            AppendChunkData(attrib.colors, chunk.vertexOffset, chunk.colors);
+            AppendChunkData(attrib.normals, chunk.normalOffset, chunk.normals);
+            AppendChunkData(attrib.texcoords, chunk.texcoordOffset, chunk.texcoords);
+
+            for (const auto& fixup : chunk.fixups)
+            {
+                auto& index = chunk.indices[fixup.indexPosition];
+                index.vertex_index += (fixup.components & RELATIVE_VERTEX) ? static_cast<int>(chunk.vertexOffset / 3) : 0;
+                index.texcoord_index += (fixup.components & RELATIVE_TEXCOORD) ? static_cast<int>(chunk.texcoordOffset / 2) : 0;
+                index.normal_index += (fixup.components & RELATIVE_NORMAL) ? static_cast<int>(chunk.normalOffset / 3) : 0;
+            }
+        });
+
+        /** Shapes */
+        struct IndexRange
+        {
+            size_t chunk;
+            size_t begin;
+            size_t end;
+        };
+
+        struct ShapeRanges
+        {
+            std::string name;
+            std::vector<IndexRange> ranges;
+            size_t indicesCount = 0;
+        };
+
+        // Shapes may span several chunks. A shape is emitted only if it has faces, as in tinyobj
+        std::vector<ShapeRanges> shapeRanges(1);
+        const auto addRange = [&](size_t chunk, size_t rangeBegin, size_t rangeEnd) {
+            if (rangeEnd > rangeBegin)
+            {
+                shapeRanges.back().ranges.push_back({chunk, rangeBegin, rangeEnd});
+                shapeRanges.back().indicesCount += rangeEnd - rangeBegin;
+            }
+        };
+
+        for (size_t chunk = 0; chunk < chunks.size(); ++chunk)
+        {
+            size_t rangeBegin = 0;
+            for (const auto& mark : chunks[chunk].shapeMarks)
+            {
+                addRange(chunk, rangeBegin, mark.indexPosition);
+                rangeBegin = mark.indexPosition;
+
+                if (shapeRanges.back().indicesCount > 0)
+                {
+                    shapeRanges.emplace_back();
+                }
+                shapeRanges.back().name = mark.name;
+            }
+
+            addRange(chunk, rangeBegin, chunks[chunk].indices.size());
+        }
+
+        if (shapeRanges.back().indicesCount == 0)
+        {
+            shapeRanges.pop_back();
+        }
+
+        shapes.clear();
+        shapes.resize(shapeRanges.size());
+        ParallelFor(shapes.size(), m_threadCount, [&](size_t shapeIndex) {
+            const auto& source = shapeRanges[shapeIndex];
+            auto& shape = shapes[shapeIndex];
+
+            shape.name = source.name;
+            shape.mesh.indices.reserve(source.indicesCount);
+            for (const auto& range : source.ranges)
+            {
+                const auto& chunkIndices = chunks[range.chunk].indices;
+                shape.mesh.indices.insert(shape.mesh.indices.end(), chunkIndices.begin() + range.begin, chunkIndices.begin() + range.end);
+            }
+
+            const size_t facesCount = source.indicesCount / 3;
+            shape.mesh.num_face_vertices.assign(facesCount, 3);
+            shape.mesh.material_ids.assign(facesCount, -1);
+            shape.mesh.smoothing_group_ids.assign(facesCount, 0);
+        });
+
+        spdlog::info(
+            "Parsed '{}' ({:.1f} MiB) in {} chunks on {} threads: {} vertices, {} shapes",
+            path,
+            file.GetSize() / (1024.0 * 1024.0),
+            chunks.size(),
+            std::min<size_t>(m_threadCount, chunks.size()),
+            verticesCount / 3,
+            shapes.size());
+    }
+} // namespace vr
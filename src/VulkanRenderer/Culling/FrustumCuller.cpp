@@ -0,0 +1,311 @@
+#include "VulkanRenderer/Culling/FrustumCuller.h"
+
+#include <fmt/format.h>
+#include <limits>
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define VR_CULLING_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        // MSVC emits any intrinsic without target flags
+        #define VR_TARGET_AVX2
+    #else
+        #define VR_TARGET_AVX2 __attribute__((target("avx2,fma")))
+    #endif
+#endif
+
+namespace vr
+{
+    namespace
+    {
+        /** Padding spheres fail every plane test, as no distance is greater than or equal to the lowest float */
+        const float PADDING_RADIUS = -std::numeric_limits<float>::max();
+
+        uint32_t CountTrailingZeros(uint32_t mask)
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long index = 0;
+            _BitScanForward(&index, mask);
+            return static_cast<uint32_t>(index);
+#else
+            return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+        }
+
+        /** Appends the index of every set bit of the batch's visibility mask */
+        std::size_t AppendVisible(uint32_t mask, uint32_t batchBegin, uint32_t* visibleIndices, std::size_t visibleCount)
+        {
+            while (mask != 0)
+            {
+                visibleIndices[visibleCount++] = batchBegin + CountTrailingZeros(mask);
+                mask &= mask - 1;
+            }
+
+            return visibleCount;
+        }
+
+#ifdef VR_CULLING_X86
+        bool IsAvx2Supported()
+        {
+    #if defined(_MSC_VER) && !defined(__clang__)
+            int registers[4];
+            __cpuid(registers, 1);
+            const bool isFmaSupported = (registers[2] & (1 << 12)) != 0;
+            const bool isOsXsaveSupported = (registers[2] & (1 << 27)) != 0;
+            const bool isAvxSupported = (registers[2] & (1 << 28)) != 0;
+            if (!isFmaSupported || !isOsXsaveSupported || !isAvxSupported)
+            {
+                return false;
+            }
+
+            // The OS has to save the YMM registers on context switches
+            if ((_xgetbv(0) & 0x6) != 0x6)
+            {
+                return false;
+            }
+
+            __cpuidex(registers, 7, 0);
+            return (registers[1] & (1 << 5)) != 0;
+    #else
+            // Checks the OS support of the YMM registers as well
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    #endif
+        }
+#endif
+    } // namespace
+
+    FrustumCuller::FrustumCuller()
+        : m_backend(GetBestSupportedBackend())
+    {
+    }
+
+    FrustumCuller::FrustumCuller(CullingBackend backend)
+        : m_backend(backend)
+    {
+        if (!IsBackendSupported(backend))
+        {
+            throw std::runtime_error(fmt::format("{} frustum culling is not supported by this CPU!", GetBackendName(backend)));
+        }
+    }
+
+    bool FrustumCuller::IsBackendSupported(CullingBackend backend)
+    {
+        switch (backend)
+        {
+            case CullingBackend::Scalar:
+                return true;
+#ifdef VR_CULLING_X86
+            case CullingBackend::Sse:
+                // SSE2 is a part of the x86-64 baseline and required by 32-bit MSVC builds by default
+                return true;
+            case CullingBackend::Avx2:
+            {
+                static const bool isAvx2Supported = IsAvx2Supported();
+                return isAvx2Supported;
+            }
+#endif
+            default:
+                return false;
+        }
+    }
+
+    CullingBackend FrustumCuller::GetBestSupportedBackend()
+    {
+        for (const auto backend : {CullingBackend::Avx2, CullingBackend::Sse})
+        {
+            if (IsBackendSupported(backend))
+            {
+                return backend;
+            }
+        }
+
+        return CullingBackend::Scalar;
+    }
+
+    const char* FrustumCuller::GetBackendName(CullingBackend backend)
+    {
+        switch (backend)
+        {
+            case CullingBackend::Scalar:
+                return "Scalar";
+            case CullingBackend::Sse:
+                return "SSE";
+            case CullingBackend::Avx2:
+                return "AVX2";
+            default:
+                return "Unknown";
+        }
+    }
+
+    CullingBackend FrustumCuller::GetBackend() const
+    {
+        return m_backend;
+    }
+
+    void FrustumCuller::Clear()
+    {
+        m_objectCount = 0;
+        m_centersX.clear();
+        m_centersY.clear();
+        m_centersZ.clear();
+        m_radii.clear();
+    }
+
+    void FrustumCuller::Reserve(std::size_t objectCount)
+    {
+        const auto paddedCount = (objectCount + BATCH_SIZE - 1) / BATCH_SIZE * BATCH_SIZE;
+        m_centersX.reserve(paddedCount);
+        m_centersY.reserve(paddedCount);
+        m_centersZ.reserve(paddedCount);
+        m_radii.reserve(paddedCount);
+    }
+
+    uint32_t FrustumCuller::AddSphere(const glm::vec3& center, float radius)
+    {
+        // A whole batch of padding is added at once, and filled with objects one by one
+        if (m_objectCount == m_radii.size())
+        {
+            m_centersX.resize(m_objectCount + BATCH_SIZE, 0.0f);
+            m_centersY.resize(m_objectCount + BATCH_SIZE, 0.0f);
+            m_centersZ.resize(m_objectCount + BATCH_SIZE, 0.0f);
+            m_radii.resize(m_objectCount + BATCH_SIZE, PADDING_RADIUS);
+        }
+
+        m_centersX[m_objectCount] = center.x;
+        m_centersY[m_objectCount] = center.y;
+        m_centersZ[m_objectCount] = center.z;
+        m_radii[m_objectCount] = radius;
+
+        return static_cast<uint32_t>(m_objectCount++);
+    }
+
+    std::size_t FrustumCuller::GetObjectCount() const
+    {
+        return m_objectCount;
+    }
+
+    void FrustumCuller::Cull(const Frustum& frustum, std::vector<uint32_t>& visibleIndices) const
+    {
+        // Every padded slot could be written by the batch compaction, even though padding is never visible
+        visibleIndices.resize(m_radii.size());
+
+        std::size_t visibleCount = 0;
+        switch (m_backend)
+        {
+            case CullingBackend::Avx2:
+                visibleCount = CullAvx2(frustum, visibleIndices.data());
+                break;
+            case CullingBackend::Sse:
+                visibleCount = CullSse(frustum, visibleIndices.data());
+                break;
+            default:
+                visibleCount = CullScalar(frustum, visibleIndices.data());
+                break;
+        }
+
+        visibleIndices.resize(visibleCount);
+    }
+
+    std::size_t FrustumCuller::CullScalar(const Frustum& frustum, uint32_t* visibleIndices) const
+    {
+        std::size_t visibleCount = 0;
+        for (std::size_t object = 0; object < m_objectCount; ++object)
+        {
+            bool isVisible = true;
+            for (const auto& plane : frustum.planes)
+            {
+                // Summed in the same order as the SSE backend, so both of them give exactly the same results
+                const float distance = plane.w + m_radii[object] + plane.x * m_centersX[object] + plane.y * m_centersY[object] + plane.z * m_centersZ[object];
+                if (distance < 0.0f)
+                {
+                    isVisible = false;
+                    break;
+                }
+            }
+
+            if (isVisible)
+            {
+                visibleIndices[visibleCount++] = static_cast<uint32_t>(object);
+            }
+        }
+
+        return visibleCount;
+    }
+
+#ifdef VR_CULLING_X86
+    std::size_t FrustumCuller::CullSse(const Frustum& frustum, uint32_t* visibleIndices) const
+    {
+        const std::size_t batchSize = 4;
+        const __m128 zero = _mm_setzero_ps();
+
+        std::size_t visibleCount = 0;
+        for (std::size_t batch = 0; batch < m_objectCount; batch += batchSize)
+        {
+            const __m128 centersX = _mm_loadu_ps(m_centersX.data() + batch);
+            const __m128 centersY = _mm_loadu_ps(m_centersY.data() + batch);
+            const __m128 centersZ = _mm_loadu_ps(m_centersZ.data() + batch);
+            const __m128 radii = _mm_loadu_ps(m_radii.data() + batch);
+
+            __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const auto& plane : frustum.planes)
+            {
+                // Signed distance of the sphere's center plus its radius: negative means the sphere is fully outside
+                __m128 distance = _mm_add_ps(_mm_set1_ps(plane.w), radii);
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.x), centersX));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.y), centersY));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.z), centersZ));
+
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, zero));
+            }
+
+            const auto mask = static_cast<uint32_t>(_mm_movemask_ps(visible));
+            visibleCount = AppendVisible(mask, static_cast<uint32_t>(batch), visibleIndices, visibleCount);
+        }
+
+        return visibleCount;
+    }
+
+    VR_TARGET_AVX2 std::size_t FrustumCuller::CullAvx2(const Frustum& frustum, uint32_t* visibleIndices) const
+    {
+        const __m256 zero = _mm256_setzero_ps();
+
+        std::size_t visibleCount = 0;
+        for (std::size_t batch = 0; batch < m_objectCount; batch += BATCH_SIZE)
+        {
+            const __m256 centersX = _mm256_loadu_ps(m_centersX.data() + batch);
+            const __m256 centersY = _mm256_loadu_ps(m_centersY.data() + batch);
+            const __m256 centersZ = _mm256_loadu_ps(m_centersZ.data() + batch);
+            const __m256 radii = _mm256_loadu_ps(m_radii.data() + batch);
+
+            __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (const auto& plane : frustum.planes)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_set1_ps(plane.w), radii);
+                distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.x), centersX, distance);
+                distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.y), centersY, distance);
+                distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.z), centersZ, distance);
+
+                visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+            }
+
+            const auto mask = static_cast<uint32_t>(_mm256_movemask_ps(visible));
+            visibleCount = AppendVisible(mask, static_cast<uint32_t>(batch), visibleIndices, visibleCount);
+        }
+
+        return visibleCount;
+    }
+#else
+    std::size_t FrustumCuller::CullSse(const Frustum& frustum, uint32_t* visibleIndices) const
+    {
+        return CullScalar(frustum, visibleIndices);
+    }
+
+    std::size_t FrustumCuller::CullAvx2(const Frustum& frustum, uint32_t* visibleIndices) const
+    {
+        return CullScalar(frustum, visibleIndices);
+    }
+#endif
+} // namespace vr
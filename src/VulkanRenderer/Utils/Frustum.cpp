@@ -0,0 +1,42 @@
+#include "VulkanRenderer/Utils/Frustum.h"
+
+namespace vr
+{
+    Frustum Frustum::FromViewProjection(const glm::mat4& viewProjection)
+    {
+        // glm matrices are column major, so the rows have to be gathered from the columns
+        std::array<glm::vec4, 4> rows;
+        for (int row = 0; row < 4; ++row)
+        {
+            rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row]);
+        }
+
+        Frustum frustum;
+        frustum.planes[0] = rows[3] + rows[0];
+        frustum.planes[1] = rows[3] - rows[0];
+        frustum.planes[2] = rows[3] + rows[1];
+        frustum.planes[3] = rows[3] - rows[1];
+        frustum.planes[4] = rows[2];
+        frustum.planes[5] = rows[3] - rows[2];
+
+        for (auto& plane : frustum.planes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+
+        return frustum;
+    }
+
+    bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const
+    {
+        for (const auto& plane : planes)
+        {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+} // namespace vr
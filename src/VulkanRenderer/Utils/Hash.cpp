@@ -0,0 +1,30 @@
+#include "VulkanRenderer/Utils/Hash.h"
+
+#include <cstring>
+
+namespace vr
+{
+    uint64_t HashBytes(const void* data, size_t size)
+    {
+        constexpr uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325ull;
+        constexpr uint64_t FNV_PRIME = 0x100000001B3ull;
+
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        uint64_t hash = FNV_OFFSET_BASIS;
+        size_t position = 0;
+        for (; position + sizeof(uint64_t) <= size; position += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, bytes + position, sizeof(word));
+            hash = (hash ^ word) * FNV_PRIME;
+        }
+
+        for (; position < size; ++position)
+        {
+            hash = (hash ^ bytes[position]) * FNV_PRIME;
+        }
+
+        // Inputs differing only in the number of trailing zeroes must not collide
+        return (hash ^ static_cast<uint64_t>(size)) * FNV_PRIME;
+    }
+} // namespace vr
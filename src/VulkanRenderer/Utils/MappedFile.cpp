@@ -0,0 +1,185 @@
+#include "VulkanRenderer/Utils/MappedFile.h"
+
+#include <fmt/format.h>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace vr
+{
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string& path)
+    {
+        m_fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_fileHandle == INVALID_HANDLE_VALUE)
+        {
+            m_fileHandle = nullptr;
+            throw std::runtime_error(fmt::format("Failed to open '{}' for mapping!", path));
+        }
+        m_isOpen = true;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(m_fileHandle, &fileSize))
+        {
+            Close();
+            throw std::runtime_error(fmt::format("Failed to query the size of '{}'!", path));
+        }
+        m_size = static_cast<size_t>(fileSize.QuadPart);
+
+        // Empty files cannot be mapped, they are represented by an open file without data
+        if (m_size == 0)
+        {
+            return;
+        }
+
+        m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mappingHandle == nullptr)
+        {
+            Close();
+            throw std::runtime_error(fmt::format("Failed to create file mapping of '{}'!", path));
+        }
+
+        m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        if (m_data == nullptr)
+        {
+            Close();
+            throw std::runtime_error(fmt::format("Failed to map view of '{}'!", path));
+        }
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data != nullptr)
+        {
+            UnmapViewOfFile(m_data);
+        }
+
+        if (m_mappingHandle != nullptr)
+        {
+            CloseHandle(m_mappingHandle);
+        }
+
+        if (m_fileHandle != nullptr)
+        {
+            CloseHandle(m_fileHandle);
+        }
+
+        m_data = nullptr;
+        m_size = 0;
+        m_isOpen = false;
+        m_mappingHandle = nullptr;
+        m_fileHandle = nullptr;
+    }
+#else
+    MappedFile::MappedFile(const std::string& path)
+    {
+        m_fileDescriptor = open(path.c_str(), O_RDONLY);
+        if (m_fileDescriptor < 0)
+        {
+            throw std::runtime_error(fmt::format("Failed to open '{}' for mapping!", path));
+        }
+        m_isOpen = true;
+
+        struct stat fileStat;
+        if (fstat(m_fileDescriptor, &fileStat) != 0)
+        {
+            Close();
+            throw std::runtime_error(fmt::format("Failed to query the size of '{}'!", path));
+        }
+        m_size = static_cast<size_t>(fileStat.st_size);
+
+        // Empty files cannot be mapped, they are represented by an open file without data
+        if (m_size == 0)
+        {
+            return;
+        }
+
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+        if (data == MAP_FAILED)
+        {
+            Close();
+            throw std::runtime_error(fmt::format("Failed to map '{}'!", path));
+        }
+
+        madvise(data, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const uint8_t*>(data);
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data != nullptr)
+        {
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+        }
+
+        if (m_fileDescriptor >= 0)
+        {
+            close(m_fileDescriptor);
+        }
+
+        m_data = nullptr;
+        m_size = 0;
+        m_isOpen = false;
+        m_fileDescriptor = -1;
+    }
+#endif
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Close();
+
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_isOpen = std::exchange(other.m_isOpen, false);
+#ifdef _WIN32
+            m_fileHandle = std::exchange(other.m_fileHandle, nullptr);
+            m_mappingHandle = std::exchange(other.m_mappingHandle, nullptr);
+#else
+            m_fileDescriptor = std::exchange(other.m_fileDescriptor, -1);
+#endif
+        }
+
+        return *this;
+    }
+
+    bool MappedFile::IsOpen() const
+    {
+        return m_isOpen;
+    }
+
+    const uint8_t* MappedFile::GetData() const
+    {
+        return m_data;
+    }
+
+    size_t MappedFile::GetSize() const
+    {
+        return m_size;
+    }
+} // namespace vr
@@ -0,0 +1,108 @@
+#include "VulkanRenderer/Vulkan/BindlessTextureTable.h"
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <array>
+
+namespace vr
+{
+    BindlessTextureTable::BindlessTextureTable(const vk::PhysicalDevice& physicalDevice, const vk::UniqueDevice& device)
+        : m_device(device.get())
+    {
+        spdlog::info("BINDLESS TEXTURE TABLE CREATION STARTED");
+        {
+            const auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+            const auto& vulkan12Properties = properties.get<vk::PhysicalDeviceVulkan12Properties>();
+            m_capacity = std::min(
+                {MAX_TEXTURE_COUNT,
+                 vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                 vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages});
+
+            std::array<vk::DescriptorSetLayoutBinding, 2> bindings;
+            bindings[SAMPLER_BINDING] = vk::DescriptorSetLayoutBinding(SAMPLER_BINDING, vk::DescriptorType::eSampler, 1, vk::ShaderStageFlagBits::eFragment);
+            bindings[TEXTURES_BINDING] = vk::DescriptorSetLayoutBinding(TEXTURES_BINDING, vk::DescriptorType::eSampledImage, m_capacity, vk::ShaderStageFlagBits::eFragment);
+
+            // The sampler is written once before the set is used, only the textures are written while it is bound
+            std::array<vk::DescriptorBindingFlags, 2> bindingFlags;
+            bindingFlags[TEXTURES_BINDING] =
+                vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+            const vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo(bindingFlags);
+
+            vk::DescriptorSetLayoutCreateInfo layoutCreateInfo({}, bindings);
+            layoutCreateInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool);
+            layoutCreateInfo.setPNext(&bindingFlagsCreateInfo);
+            m_descriptorSetLayout = m_device.createDescriptorSetLayout(layoutCreateInfo);
+
+            const std::array<vk::DescriptorPoolSize, 2> poolSizes = {
+                vk::DescriptorPoolSize(vk::DescriptorType::eSampler, 1),
+                vk::DescriptorPoolSize(vk::DescriptorType::eSampledImage, m_capacity)};
+            m_descriptorPool = m_device.createDescriptorPool(vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind, 1, poolSizes));
+
+            m_descriptorSet = m_device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_descriptorPool, m_descriptorSetLayout)).front();
+
+            spdlog::info("Textures are sampled from a bindless array of {} textures", m_capacity);
+        }
+        spdlog::info("BINDLESS TEXTURE TABLE CREATION ENDED");
+    }
+
+    BindlessTextureTable::~BindlessTextureTable()
+    {
+        m_device.destroyDescriptorPool(m_descriptorPool);
+        m_device.destroyDescriptorSetLayout(m_descriptorSetLayout);
+    }
+
+    bool BindlessTextureTable::IsSupported(const vk::PhysicalDeviceFeatures& features, const vk::PhysicalDeviceVulkan12Features& vulkan12Features)
+    {
+        return features.shaderSampledImageArrayDynamicIndexing == VK_TRUE
+            && vulkan12Features.runtimeDescriptorArray == VK_TRUE
+            && vulkan12Features.descriptorBindingPartiallyBound == VK_TRUE
+            && vulkan12Features.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE
+            && vulkan12Features.descriptorBindingUpdateUnusedWhilePending == VK_TRUE;
+    }
+
+    vk::DescriptorSetLayout BindlessTextureTable::GetDescriptorSetLayout() const
+    {
+        return m_descriptorSetLayout;
+    }
+
+    vk::DescriptorSet BindlessTextureTable::GetDescriptorSet() const
+    {
+        return m_descriptorSet;
+    }
+
+    uint32_t BindlessTextureTable::GetCapacity() const
+    {
+        return m_capacity;
+    }
+
+    void BindlessTextureTable::SetSampler(vk::Sampler sampler)
+    {
+        vk::DescriptorImageInfo imageInfo;
+        imageInfo.setSampler(sampler);
+
+        vk::WriteDescriptorSet descriptorWrite;
+        descriptorWrite.setDstSet(m_descriptorSet);
+        descriptorWrite.setDstBinding(SAMPLER_BINDING);
+        descriptorWrite.setDstArrayElement(0);
+        descriptorWrite.setDescriptorType(vk::DescriptorType::eSampler);
+        descriptorWrite.setImageInfo(imageInfo);
+
+        m_device.updateDescriptorSets(descriptorWrite, {});
+    }
+
+    void BindlessTextureTable::Write(uint32_t index, vk::ImageView view)
+    {
+        vk::DescriptorImageInfo imageInfo;
+        imageInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        imageInfo.setImageView(view);
+
+        vk::WriteDescriptorSet descriptorWrite;
+        descriptorWrite.setDstSet(m_descriptorSet);
+        descriptorWrite.setDstBinding(TEXTURES_BINDING);
+        descriptorWrite.setDstArrayElement(index);
+        descriptorWrite.setDescriptorType(vk::DescriptorType::eSampledImage);
+        descriptorWrite.setImageInfo(imageInfo);
+
+        m_device.updateDescriptorSets(descriptorWrite, {});
+    }
+} // namespace vr
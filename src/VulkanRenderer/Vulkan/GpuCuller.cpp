@@ -0,0 +1,188 @@
+#include "VulkanRenderer/Vulkan/GpuCuller.h"
+#include "VulkanRenderer/Vulkan/Shader.h"
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace vr
+{
+    /** Instances, bounds, draw commands and draw count */
+    static const uint32_t CULLING_BINDINGS_COUNT = 4;
+
+    GpuCuller::GpuCuller(
+        const vk::PhysicalDevice& physicalDevice,
+        const vk::UniqueDevice& device,
+        MemoryAllocator& allocator,
+        vk::PipelineCache pipelineCache,
+        uint32_t frameCount,
+        bool isDrawIndirectCountEnabled,
+        bool isMultiDrawIndirectEnabled,
+        bool isDrawIndirectFirstInstanceEnabled)
+        : m_device(device.get()),
+          m_allocator(allocator),
+          m_pipelineCache(pipelineCache),
+          m_isDrawIndirectCountEnabled(isDrawIndirectCountEnabled),
+          m_isMultiDrawIndirectEnabled(isMultiDrawIndirectEnabled),
+          m_isDrawIndirectFirstInstanceEnabled(isDrawIndirectFirstInstanceEnabled),
+          m_maxDrawIndirectCount(physicalDevice.getProperties().limits.maxDrawIndirectCount),
+          m_frames(frameCount)
+    {
+        CreateComputePipeline();
+
+        const vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageBuffer, CULLING_BINDINGS_COUNT * frameCount);
+        m_descriptorPool = m_device.createDescriptorPool(vk::DescriptorPoolCreateInfo({}, frameCount, poolSize));
+
+        const std::vector<vk::DescriptorSetLayout> descriptorSetLayouts(frameCount, m_descriptorSetLayout);
+        const auto descriptorSets = m_device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_descriptorPool, descriptorSetLayouts));
+        for (uint32_t frame = 0; frame < frameCount; ++frame)
+        {
+            m_frames[frame].descriptorSet = descriptorSets[frame];
+        }
+
+        spdlog::info(
+            "Culled objects will be drawn with {}",
+            m_isDrawIndirectCountEnabled ? "drawIndexedIndirectCount" : "drawIndexedIndirect, as drawIndirectCount is not supported");
+    }
+
+    GpuCuller::~GpuCuller()
+    {
+        DestroyFrameBuffers();
+
+        m_device.destroyDescriptorPool(m_descriptorPool);
+        m_device.destroyPipeline(m_pipeline);
+        m_device.destroyPipelineLayout(m_pipelineLayout);
+        m_device.destroyDescriptorSetLayout(m_descriptorSetLayout);
+    }
+
+    bool GpuCuller::CanDraw(uint32_t objectCount) const
+    {
+        // Without the count buffer, every object takes a draw of the multi-draw
+        const bool isMultiDrawAvailable = m_isDrawIndirectCountEnabled || m_isMultiDrawIndirectEnabled || objectCount <= 1;
+        // Every object but the first one is drawn with a non-zero first instance
+        const bool isFirstInstanceAvailable = m_isDrawIndirectFirstInstanceEnabled || objectCount <= 1;
+        return isMultiDrawAvailable && isFirstInstanceAvailable && objectCount <= m_maxDrawIndirectCount;
+    }
+
+    void GpuCuller::SetObjects(vk::Buffer instanceBuffer, vk::Buffer boundsBuffer, uint32_t objectCount)
+    {
+        DestroyFrameBuffers();
+        m_objectCount = objectCount;
+
+        const vk::DeviceSize commandsSize = std::max(objectCount, 1u) * sizeof(vk::DrawIndexedIndirectCommand);
+        for (auto& frame : m_frames)
+        {
+            vk::BufferCreateInfo bufferCreateInfo;
+            bufferCreateInfo.setSharingMode(vk::SharingMode::eExclusive);
+
+            bufferCreateInfo.setSize(commandsSize);
+            bufferCreateInfo.setUsage(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer);
+            frame.commandsBuffer = m_device.createBuffer(bufferCreateInfo);
+            frame.commandsAllocation = m_allocator.AllocateForBuffer(frame.commandsBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+            bufferCreateInfo.setSize(sizeof(uint32_t));
+            bufferCreateInfo.setUsage(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst);
+            frame.countBuffer = m_device.createBuffer(bufferCreateInfo);
+            frame.countAllocation = m_allocator.AllocateForBuffer(frame.countBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+            const std::array<vk::DescriptorBufferInfo, CULLING_BINDINGS_COUNT> bufferInfos = {
+                vk::DescriptorBufferInfo(instanceBuffer, 0, VK_WHOLE_SIZE),
+                vk::DescriptorBufferInfo(boundsBuffer, 0, VK_WHOLE_SIZE),
+                vk::DescriptorBufferInfo(frame.commandsBuffer, 0, VK_WHOLE_SIZE),
+                vk::DescriptorBufferInfo(frame.countBuffer, 0, VK_WHOLE_SIZE)};
+
+            std::array<vk::WriteDescriptorSet, CULLING_BINDINGS_COUNT> descriptorWrites;
+            for (uint32_t binding = 0; binding < CULLING_BINDINGS_COUNT; ++binding)
+            {
+                descriptorWrites[binding].setDstSet(frame.descriptorSet);
+                descriptorWrites[binding].setDstBinding(binding);
+                descriptorWrites[binding].setDescriptorType(vk::DescriptorType::eStorageBuffer);
+                descriptorWrites[binding].setBufferInfo(bufferInfos[binding]);
+            }
+            m_device.updateDescriptorSets(descriptorWrites, {});
+        }
+    }
+
+    void GpuCuller::RecordCulling(vk::CommandBuffer commandBuffer, uint32_t frameIndex, const Frustum& frustum, const vk::DrawIndexedIndirectCommand& meshDraw)
+    {
+        const auto& frame = m_frames[frameIndex];
+
+        // The previous use of the frame's buffers has completed, as its fence has been waited for
+        commandBuffer.fillBuffer(frame.countBuffer, 0, sizeof(uint32_t), 0);
+
+        vk::MemoryBarrier clearBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, clearBarrier, {}, {});
+
+        PushConstants pushConstants;
+        std::copy(frustum.planes.begin(), frustum.planes.end(), pushConstants.frustumPlanes);
+        pushConstants.objectCount = m_objectCount;
+        pushConstants.indexCount = meshDraw.indexCount;
+        pushConstants.firstIndex = meshDraw.firstIndex;
+        pushConstants.vertexOffset = meshDraw.vertexOffset;
+        pushConstants.compactCommands = m_isDrawIndirectCountEnabled ? 1 : 0;
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, frame.descriptorSet, {});
+        commandBuffer.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushConstants), &pushConstants);
+        commandBuffer.dispatch((m_objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+        vk::MemoryBarrier commandsBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect, {}, commandsBarrier, {}, {});
+    }
+
+    void GpuCuller::RecordDraws(vk::CommandBuffer commandBuffer, uint32_t frameIndex) const
+    {
+        const auto& frame = m_frames[frameIndex];
+        const auto stride = static_cast<uint32_t>(sizeof(vk::DrawIndexedIndirectCommand));
+
+        if (m_isDrawIndirectCountEnabled)
+        {
+            commandBuffer.drawIndexedIndirectCount(frame.commandsBuffer, 0, frame.countBuffer, 0, m_objectCount, stride);
+        }
+        else
+        {
+            commandBuffer.drawIndexedIndirect(frame.commandsBuffer, 0, m_objectCount, stride);
+        }
+    }
+
+    void GpuCuller::CreateComputePipeline()
+    {
+        spdlog::info("CULLING COMPUTE PIPELINE CREATION STARTED");
+        {
+            std::array<vk::DescriptorSetLayoutBinding, CULLING_BINDINGS_COUNT> bindings;
+            for (uint32_t binding = 0; binding < CULLING_BINDINGS_COUNT; ++binding)
+            {
+                bindings[binding] = vk::DescriptorSetLayoutBinding(binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+            }
+            m_descriptorSetLayout = m_device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, bindings));
+
+            const vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushConstants));
+            m_pipelineLayout = m_device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, m_descriptorSetLayout, pushConstantRange));
+
+            const auto computeShader = Shader("cull.spv", m_device, ShaderType::VR_COMPUTE_SHADER);
+
+            vk::ComputePipelineCreateInfo pipelineCreateInfo;
+            pipelineCreateInfo.setStage(computeShader.GetPipelineShaderStageInfo());
+            pipelineCreateInfo.setLayout(m_pipelineLayout);
+
+            m_pipeline = m_device.createComputePipeline(m_pipelineCache, pipelineCreateInfo).value;
+        }
+        spdlog::info("CULLING COMPUTE PIPELINE CREATION ENDED\n");
+    }
+
+    void GpuCuller::DestroyFrameBuffers()
+    {
+        for (auto& frame : m_frames)
+        {
+            if (frame.commandsBuffer)
+            {
+                m_device.destroyBuffer(frame.commandsBuffer);
+                m_allocator.Free(frame.commandsAllocation);
+                m_device.destroyBuffer(frame.countBuffer);
+                m_allocator.Free(frame.countAllocation);
+
+                frame.commandsBuffer = vk::Buffer();
+                frame.countBuffer = vk::Buffer();
+            }
+        }
+    }
+} // namespace vr
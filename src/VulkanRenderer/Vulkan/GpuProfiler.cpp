@@ -0,0 +1,250 @@
+#include "VulkanRenderer/Vulkan/GpuProfiler.h"
+
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace vr
+{
+    /** Every scope takes two queries: its begin and end timestamps */
+    static const uint32_t QUERIES_PER_SCOPE = 2;
+
+    double ProfilerScopeStatistics::GetAverageMilliseconds() const
+    {
+        return sampleCount > 0 ? totalMilliseconds / static_cast<double>(sampleCount) : 0.0;
+    }
+
+    GpuProfiler::GpuProfiler(const vk::PhysicalDevice& physicalDevice, const vk::UniqueDevice& device, bool isHostQueryResetEnabled)
+        : m_device(device.get()), m_slots(MAX_SLOTS)
+    {
+        spdlog::info("GPU PROFILER CREATION STARTED");
+        {
+            for (const auto& family : physicalDevice.getQueueFamilyProperties())
+            {
+                m_timestampValidBits.push_back(family.timestampValidBits);
+            }
+
+            // Nanoseconds per timestamp tick
+            m_timestampPeriod = static_cast<double>(physicalDevice.getProperties().limits.timestampPeriod);
+
+            const bool areTimestampsSupported = std::any_of(m_timestampValidBits.begin(), m_timestampValidBits.end(), [](uint32_t bits) { return bits > 0; });
+            m_isEnabled = isHostQueryResetEnabled && areTimestampsSupported && m_timestampPeriod > 0.0;
+
+            if (m_isEnabled)
+            {
+                const uint32_t queryCount = MAX_SLOTS * MAX_SCOPES_PER_SLOT * QUERIES_PER_SCOPE;
+                m_queryPool = m_device.createQueryPool(vk::QueryPoolCreateInfo({}, vk::QueryType::eTimestamp, queryCount));
+                m_device.resetQueryPool(m_queryPool, 0, queryCount);
+            }
+            else
+            {
+                spdlog::warn("GPU timestamps are not supported by the device, only CPU timings will be collected");
+            }
+        }
+        spdlog::info("GPU PROFILER CREATION ENDED\n");
+    }
+
+    GpuProfiler::~GpuProfiler()
+    {
+        if (m_queryPool)
+        {
+            m_device.destroyQueryPool(m_queryPool);
+        }
+    }
+
+    bool GpuProfiler::IsEnabled() const
+    {
+        return m_isEnabled;
+    }
+
+    bool GpuProfiler::IsQueueFamilySupported(uint32_t queueFamilyIndex) const
+    {
+        return m_isEnabled && queueFamilyIndex < m_timestampValidBits.size() && m_timestampValidBits[queueFamilyIndex] > 0;
+    }
+
+    uint32_t GpuProfiler::AcquireSlot()
+    {
+        if (!m_isEnabled)
+        {
+            return INVALID_SLOT;
+        }
+
+        for (uint32_t slot = 0; slot < MAX_SLOTS; ++slot)
+        {
+            if (!m_slots[slot].isUsed)
+            {
+                m_slots[slot].isUsed = true;
+                return slot;
+            }
+        }
+
+        return INVALID_SLOT;
+    }
+
+    void GpuProfiler::ReleaseSlot(uint32_t slot)
+    {
+        if (slot == INVALID_SLOT)
+        {
+            return;
+        }
+
+        auto& releasedSlot = m_slots[slot];
+        if (!releasedSlot.scopes.empty())
+        {
+            // The slot might have never been resolved, so it is reset for its next owner
+            m_device.resetQueryPool(m_queryPool, GetFirstQuery(slot), static_cast<uint32_t>(releasedSlot.scopes.size()) * QUERIES_PER_SCOPE);
+        }
+
+        releasedSlot = Slot();
+    }
+
+    void GpuProfiler::BeginScope(vk::CommandBuffer commandBuffer, uint32_t slot, const std::string& name)
+    {
+        if (slot == INVALID_SLOT)
+        {
+            return;
+        }
+
+        auto& profiledSlot = m_slots[slot];
+        if (profiledSlot.scopes.size() == MAX_SCOPES_PER_SLOT)
+        {
+            throw std::runtime_error(fmt::format("GPU profiler slot can hold up to {} scopes!", MAX_SCOPES_PER_SLOT));
+        }
+
+        Scope scope;
+        scope.name = name;
+        scope.beginQuery = GetFirstQuery(slot) + static_cast<uint32_t>(profiledSlot.scopes.size()) * QUERIES_PER_SCOPE;
+
+        commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, m_queryPool, scope.beginQuery);
+
+        profiledSlot.openScopes.push_back(profiledSlot.scopes.size());
+        profiledSlot.scopes.push_back(std::move(scope));
+    }
+
+    void GpuProfiler::EndScope(vk::CommandBuffer commandBuffer, uint32_t slot)
+    {
+        if (slot == INVALID_SLOT)
+        {
+            return;
+        }
+
+        auto& profiledSlot = m_slots[slot];
+        if (profiledSlot.openScopes.empty())
+        {
+            throw std::runtime_error("There is no GPU profiler scope to end!");
+        }
+
+        auto& scope = profiledSlot.scopes[profiledSlot.openScopes.back()];
+        profiledSlot.openScopes.pop_back();
+
+        commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, m_queryPool, scope.beginQuery + 1);
+        scope.isClosed = true;
+    }
+
+    void GpuProfiler::Resolve(uint32_t slot)
+    {
+        if (slot == INVALID_SLOT || m_slots[slot].scopes.empty())
+        {
+            return;
+        }
+
+        auto& profiledSlot = m_slots[slot];
+        const auto firstQuery = GetFirstQuery(slot);
+        const auto queryCount = static_cast<uint32_t>(profiledSlot.scopes.size()) * QUERIES_PER_SCOPE;
+
+        // Without the wait flag, eNotReady is returned if any of the queries has not been written, e.g. because the recording was never submitted
+        std::vector<uint64_t> timestamps(queryCount);
+        const auto result = m_device.getQueryPoolResults(
+            m_queryPool,
+            firstQuery,
+            queryCount,
+            timestamps.size() * sizeof(uint64_t),
+            timestamps.data(),
+            sizeof(uint64_t),
+            vk::QueryResultFlagBits::e64);
+
+        if (result == vk::Result::eSuccess)
+        {
+            const double millisecondsPerTick = m_timestampPeriod / 1'000'000.0;
+            for (std::size_t i = 0; i < profiledSlot.scopes.size(); ++i)
+            {
+                const auto& scope = profiledSlot.scopes[i];
+                const auto begin = timestamps[i * QUERIES_PER_SCOPE];
+                const auto end = timestamps[i * QUERIES_PER_SCOPE + 1];
+                if (scope.isClosed && end >= begin)
+                {
+                    AddSample(scope.name, true, static_cast<double>(end - begin) * millisecondsPerTick);
+                }
+            }
+        }
+
+        m_device.resetQueryPool(m_queryPool, firstQuery, queryCount);
+        profiledSlot.scopes.clear();
+        profiledSlot.openScopes.clear();
+    }
+
+    void GpuProfiler::AddCpuSample(const std::string& name, double milliseconds)
+    {
+        AddSample(name, false, milliseconds);
+    }
+
+    const std::vector<ProfilerScopeStatistics>& GpuProfiler::GetStatistics() const
+    {
+        return m_statistics;
+    }
+
+    const ProfilerScopeStatistics* GpuProfiler::FindStatistics(const std::string& name, bool isGpu) const
+    {
+        const auto foundIt = std::find_if(m_statistics.begin(), m_statistics.end(), [&](const ProfilerScopeStatistics& statistics) {
+            return statistics.isGpu == isGpu && statistics.name == name;
+        });
+
+        return foundIt != m_statistics.end() ? &(*foundIt) : nullptr;
+    }
+
+    void GpuProfiler::ResetStatistics()
+    {
+        m_statistics.clear();
+    }
+
+    void GpuProfiler::LogStatistics() const
+    {
+        spdlog::info("PROFILER STATISTICS");
+        for (const auto& statistics : m_statistics)
+        {
+            spdlog::info(
+                "{} ({}): avg {:.3f} ms, max {:.3f} ms, {} samples",
+                statistics.name,
+                statistics.isGpu ? "GPU" : "CPU",
+                statistics.GetAverageMilliseconds(),
+                statistics.maxMilliseconds,
+                statistics.sampleCount);
+        }
+    }
+
+    uint32_t GpuProfiler::GetFirstQuery(uint32_t slot) const
+    {
+        return slot * MAX_SCOPES_PER_SLOT * QUERIES_PER_SCOPE;
+    }
+
+    void GpuProfiler::AddSample(const std::string& name, bool isGpu, double milliseconds)
+    {
+        auto foundIt = std::find_if(m_statistics.begin(), m_statistics.end(), [&](const ProfilerScopeStatistics& statistics) {
+            return statistics.isGpu == isGpu && statistics.name == name;
+        });
+
+        if (foundIt == m_statistics.end())
+        {
+            ProfilerScopeStatistics newStatistics;
+            newStatistics.name = name;
+            newStatistics.isGpu = isGpu;
+
+            foundIt = m_statistics.insert(m_statistics.end(), std::move(newStatistics));
+        }
+
+        ++foundIt->sampleCount;
+        foundIt->totalMilliseconds += milliseconds;
+        foundIt->maxMilliseconds = std::max(foundIt->maxMilliseconds, milliseconds);
+    }
+} // namespace vr
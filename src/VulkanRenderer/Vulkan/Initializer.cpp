@@ -21,4 +21,9 @@ namespace vr
     {
         return std::make_unique<Vulkan>(appName, window);
     }
+
+    std::unique_ptr<Vulkan> VulkanInitializer::Init(const std::string& appName, vk::Extent2D offscreenExtent)
+    {
+        return std::make_unique<Vulkan>(appName, offscreenExtent);
+    }
 } // namespace vr
\ No newline at end of file
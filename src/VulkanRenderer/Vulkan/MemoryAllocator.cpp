@@ -0,0 +1,496 @@
+#include "VulkanRenderer/Vulkan/MemoryAllocator.h"
+
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+#include <algorithm>
+
+namespace vr
+{
+    struct MemoryBlock
+    {
+        vk::DeviceMemory memory;
+        vk::DeviceSize size = 0;
+        uint32_t memoryTypeIndex = 0;
+        AllocationStrategy strategy = AllocationStrategy::Buddy;
+        void* mappedData = nullptr;
+
+        uint32_t allocationCount = 0;
+        vk::DeviceSize bytesUsed = 0;
+
+        /** Buddy strategy. Level 0 is the whole block, every next level halves the node size */
+        std::vector<std::set<vk::DeviceSize>> freeNodes;
+        std::unordered_map<vk::DeviceSize, uint32_t> allocatedNodes;
+
+        /** Linear strategy */
+        vk::DeviceSize linearOffset = 0;
+
+        bool Allocate(vk::DeviceSize allocationSize, vk::DeviceSize alignment, vk::DeviceSize& outOffset)
+        {
+            const auto allocated = strategy == AllocationStrategy::Buddy
+                ? AllocateBuddy(allocationSize, alignment, outOffset)
+                : AllocateLinear(allocationSize, alignment, outOffset);
+
+            if (allocated)
+            {
+                ++allocationCount;
+                bytesUsed += allocationSize;
+            }
+
+            return allocated;
+        }
+
+        void Free(vk::DeviceSize offset, vk::DeviceSize allocationSize)
+        {
+            --allocationCount;
+            bytesUsed -= allocationSize;
+
+            if (strategy == AllocationStrategy::Buddy)
+            {
+                FreeBuddy(offset);
+            }
+            else if (allocationCount == 0)
+            {
+                // Everything allocated from the block is gone, so it can be reused from the start
+                linearOffset = 0;
+            }
+        }
+
+        bool IsEmpty() const
+        {
+            return allocationCount == 0;
+        }
+
+    private:
+        bool AllocateBuddy(vk::DeviceSize allocationSize, vk::DeviceSize alignment, vk::DeviceSize& outOffset)
+        {
+            // Nodes are aligned to their own size, so a node big enough for both size and alignment satisfies both
+            const auto requiredSize = std::max({allocationSize, alignment, freeNodes.empty() ? size : (size >> (freeNodes.size() - 1))});
+
+            int32_t requiredLevel = static_cast<int32_t>(freeNodes.size()) - 1;
+            while (requiredLevel >= 0 && (size >> requiredLevel) < requiredSize)
+            {
+                --requiredLevel;
+            }
+
+            if (requiredLevel < 0)
+            {
+                return false;
+            }
+
+            int32_t level = requiredLevel;
+            while (level >= 0 && freeNodes[level].empty())
+            {
+                --level;
+            }
+
+            if (level < 0)
+            {
+                return false;
+            }
+
+            auto nodeIt = freeNodes[level].begin();
+            const auto offset = *nodeIt;
+            freeNodes[level].erase(nodeIt);
+
+            // Split the found node until it has the required size, putting the right halves on the free lists
+            for (; level < requiredLevel; ++level)
+            {
+                freeNodes[level + 1].insert(offset + (size >> (level + 1)));
+            }
+
+            allocatedNodes[offset] = static_cast<uint32_t>(requiredLevel);
+            outOffset = offset;
+
+            return true;
+        }
+
+        void FreeBuddy(vk::DeviceSize offset)
+        {
+            const auto nodeIt = allocatedNodes.find(offset);
+            auto level = nodeIt->second;
+            allocatedNodes.erase(nodeIt);
+
+            while (level > 0)
+            {
+                const auto buddyOffset = offset ^ (size >> level);
+                const auto buddyIt = freeNodes[level].find(buddyOffset);
+                if (buddyIt == freeNodes[level].end())
+                {
+                    break;
+                }
+
+                freeNodes[level].erase(buddyIt);
+                offset = std::min(offset, buddyOffset);
+                --level;
+            }
+
+            freeNodes[level].insert(offset);
+        }
+
+        bool AllocateLinear(vk::DeviceSize allocationSize, vk::DeviceSize alignment, vk::DeviceSize& outOffset)
+        {
+            const auto offset = (linearOffset + alignment - 1) & ~(alignment - 1);
+            if (offset + allocationSize > size)
+            {
+                return false;
+            }
+
+            linearOffset = offset + allocationSize;
+            outOffset = offset;
+
+            return true;
+        }
+    };
+
+    MemoryAllocator::MemoryAllocator(const vk::PhysicalDevice& physicalDevice, const vk::UniqueDevice& device)
+        : m_device(device.get()), m_memoryProperties(physicalDevice.getMemoryProperties())
+    {
+        const auto properties = physicalDevice.getProperties();
+        m_maxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+        // Dedicated allocation queries are core since Vulkan 1.1
+        m_supportsDedicatedAllocation = properties.apiVersion >= VK_API_VERSION_1_1;
+
+        m_statistics.resize(m_memoryProperties.memoryTypeCount);
+    }
+
+    MemoryAllocator::~MemoryAllocator()
+    {
+        for (auto& pool : m_pools)
+        {
+            for (auto& block : pool.blocks)
+            {
+                if (!block->IsEmpty())
+                {
+                    spdlog::warn("Memory block of type {} destroyed with {} live allocations", block->memoryTypeIndex, block->allocationCount);
+                }
+                DestroyBlock(*block);
+            }
+        }
+    }
+
+    Allocation MemoryAllocator::AllocateForBuffer(vk::Buffer buffer, vk::MemoryPropertyFlags properties, AllocationStrategy strategy)
+    {
+        vk::MemoryRequirements requirements;
+        bool dedicated = false;
+        if (m_supportsDedicatedAllocation)
+        {
+            const auto requirementsChain = m_device.getBufferMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(vk::BufferMemoryRequirementsInfo2(buffer));
+            requirements = requirementsChain.get<vk::MemoryRequirements2>().memoryRequirements;
+            dedicated = requirementsChain.get<vk::MemoryDedicatedRequirements>().requiresDedicatedAllocation;
+        }
+        else
+        {
+            requirements = m_device.getBufferMemoryRequirements(buffer);
+        }
+
+        const vk::MemoryDedicatedAllocateInfo dedicatedInfo({}, buffer);
+        auto allocation = Allocate(requirements, properties, ResourceType::Linear, strategy, dedicated, m_supportsDedicatedAllocation ? &dedicatedInfo : nullptr);
+        m_device.bindBufferMemory(buffer, allocation.memory, allocation.offset);
+
+        return allocation;
+    }
+
+    Allocation MemoryAllocator::AllocateForImage(vk::Image image, vk::MemoryPropertyFlags properties)
+    {
+        vk::MemoryRequirements requirements;
+        bool dedicated = false;
+        if (m_supportsDedicatedAllocation)
+        {
+            const auto requirementsChain = m_device.getImageMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(vk::ImageMemoryRequirementsInfo2(image));
+            requirements = requirementsChain.get<vk::MemoryRequirements2>().memoryRequirements;
+
+            const auto& dedicatedRequirements = requirementsChain.get<vk::MemoryDedicatedRequirements>();
+            dedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+        }
+        else
+        {
+            requirements = m_device.getImageMemoryRequirements(image);
+        }
+
+        const vk::MemoryDedicatedAllocateInfo dedicatedInfo(image, {});
+        auto allocation = Allocate(requirements, properties, ResourceType::Optimal, AllocationStrategy::Buddy, dedicated, m_supportsDedicatedAllocation ? &dedicatedInfo : nullptr);
+        m_device.bindImageMemory(image, allocation.memory, allocation.offset);
+
+        return allocation;
+    }
+
+    void MemoryAllocator::Free(Allocation& allocation)
+    {
+        if (!allocation.memory)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto& statistics = m_statistics[allocation.memoryTypeIndex];
+        --statistics.allocationCount;
+        statistics.bytesUsed -= allocation.size;
+
+        if (allocation.block == nullptr)
+        {
+            if (allocation.mappedData != nullptr)
+            {
+                m_device.unmapMemory(allocation.memory);
+            }
+            m_device.freeMemory(allocation.memory);
+
+            --statistics.dedicatedAllocationCount;
+            statistics.bytesReserved -= allocation.size;
+            --m_deviceMemoryAllocationCount;
+        }
+        else
+        {
+            auto* block = allocation.block;
+            block->Free(allocation.offset, allocation.size);
+
+            // Keep a single empty block around per pool, so that alloc/free patterns do not hit the driver every time
+            if (block->IsEmpty())
+            {
+                for (auto& pool : m_pools)
+                {
+                    if (pool.blocks.size() <= 1)
+                    {
+                        continue;
+                    }
+
+                    const auto blockIt = std::find_if(pool.blocks.begin(), pool.blocks.end(), [&](const auto& poolBlock) { return poolBlock.get() == block; });
+                    if (blockIt != pool.blocks.end())
+                    {
+                        DestroyBlock(**blockIt);
+                        pool.blocks.erase(blockIt);
+                        break;
+                    }
+                }
+            }
+        }
+
+        allocation = Allocation();
+    }
+
+    AllocatorStatistics MemoryAllocator::GetStatistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        AllocatorStatistics statistics;
+        statistics.memoryTypes = m_statistics;
+        statistics.deviceMemoryAllocationCount = m_deviceMemoryAllocationCount;
+        statistics.maxDeviceMemoryAllocationCount = m_maxAllocationCount;
+        for (const auto& typeStatistics : m_statistics)
+        {
+            statistics.totalBytesReserved += typeStatistics.bytesReserved;
+            statistics.totalBytesUsed += typeStatistics.bytesUsed;
+        }
+
+        return statistics;
+    }
+
+    void MemoryAllocator::LogStatistics() const
+    {
+        const auto statistics = GetStatistics();
+
+        spdlog::info(
+            "GPU memory: {} device allocations (limit {}), {:.2f} MiB reserved, {:.2f} MiB used",
+            statistics.deviceMemoryAllocationCount,
+            statistics.maxDeviceMemoryAllocationCount,
+            statistics.totalBytesReserved / (1024.0 * 1024.0),
+            statistics.totalBytesUsed / (1024.0 * 1024.0));
+
+        for (std::size_t memoryType = 0; memoryType < statistics.memoryTypes.size(); ++memoryType)
+        {
+            const auto& typeStatistics = statistics.memoryTypes[memoryType];
+            if (typeStatistics.bytesReserved == 0)
+            {
+                continue;
+            }
+
+            spdlog::info(
+                "    Memory type {}: {} blocks, {} dedicated, {} allocations, {:.2f} / {:.2f} MiB used",
+                memoryType,
+                typeStatistics.blockCount,
+                typeStatistics.dedicatedAllocationCount,
+                typeStatistics.allocationCount,
+                typeStatistics.bytesUsed / (1024.0 * 1024.0),
+                typeStatistics.bytesReserved / (1024.0 * 1024.0));
+        }
+    }
+
+    Allocation MemoryAllocator::Allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, ResourceType resourceType, AllocationStrategy strategy, bool dedicated, const void* dedicatedInfo)
+    {
+        const auto memoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, properties);
+        const auto blockSize = GetBlockSize(memoryTypeIndex);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Resources taking a considerable part of a block would only fragment it
+        if (dedicated || requirements.size > blockSize / 2)
+        {
+            return AllocateDedicated(requirements, memoryTypeIndex, dedicatedInfo);
+        }
+
+        auto& pool = GetPool(memoryTypeIndex, resourceType, strategy);
+
+        Allocation allocation;
+        allocation.size = requirements.size;
+        allocation.memoryTypeIndex = memoryTypeIndex;
+
+        for (auto& block : pool.blocks)
+        {
+            if (block->Allocate(requirements.size, requirements.alignment, allocation.offset))
+            {
+                allocation.block = block.get();
+                break;
+            }
+        }
+
+        if (allocation.block == nullptr)
+        {
+            auto& block = CreateBlock(pool);
+            if (!block.Allocate(requirements.size, requirements.alignment, allocation.offset))
+            {
+                throw std::runtime_error(fmt::format("Failed to sub-allocate {} bytes from a fresh memory block!", requirements.size));
+            }
+            allocation.block = &block;
+        }
+
+        allocation.memory = allocation.block->memory;
+        if (allocation.block->mappedData != nullptr)
+        {
+            allocation.mappedData = static_cast<uint8_t*>(allocation.block->mappedData) + allocation.offset;
+        }
+
+        auto& statistics = m_statistics[memoryTypeIndex];
+        ++statistics.allocationCount;
+        statistics.bytesUsed += allocation.size;
+
+        return allocation;
+    }
+
+    Allocation MemoryAllocator::AllocateDedicated(const vk::MemoryRequirements& requirements, uint32_t memoryTypeIndex, const void* dedicatedInfo)
+    {
+        vk::MemoryAllocateInfo allocateInfo(requirements.size, memoryTypeIndex);
+        allocateInfo.setPNext(dedicatedInfo);
+
+        Allocation allocation;
+        allocation.memory = m_device.allocateMemory(allocateInfo);
+        allocation.size = requirements.size;
+        allocation.memoryTypeIndex = memoryTypeIndex;
+        if (IsHostVisible(memoryTypeIndex))
+        {
+            allocation.mappedData = m_device.mapMemory(allocation.memory, 0, VK_WHOLE_SIZE);
+        }
+
+        auto& statistics = m_statistics[memoryTypeIndex];
+        ++statistics.dedicatedAllocationCount;
+        ++statistics.allocationCount;
+        statistics.bytesReserved += allocation.size;
+        statistics.bytesUsed += allocation.size;
+        ++m_deviceMemoryAllocationCount;
+
+        return allocation;
+    }
+
+    MemoryBlock& MemoryAllocator::CreateBlock(MemoryPool& pool)
+    {
+        auto block = std::make_unique<MemoryBlock>();
+        block->size = GetBlockSize(pool.memoryTypeIndex);
+        block->memoryTypeIndex = pool.memoryTypeIndex;
+        block->strategy = pool.strategy;
+        block->memory = m_device.allocateMemory(vk::MemoryAllocateInfo(block->size, pool.memoryTypeIndex));
+
+        if (IsHostVisible(pool.memoryTypeIndex))
+        {
+            // Host visible blocks stay mapped for their whole life time
+            block->mappedData = m_device.mapMemory(block->memory, 0, VK_WHOLE_SIZE);
+        }
+
+        if (pool.strategy == AllocationStrategy::Buddy)
+        {
+            uint32_t levelCount = 1;
+            while ((block->size >> levelCount) >= MIN_BUDDY_ALLOCATION_SIZE)
+            {
+                ++levelCount;
+            }
+
+            block->freeNodes.resize(levelCount);
+            block->freeNodes[0].insert(0);
+        }
+
+        auto& statistics = m_statistics[pool.memoryTypeIndex];
+        ++statistics.blockCount;
+        statistics.bytesReserved += block->size;
+        ++m_deviceMemoryAllocationCount;
+
+        pool.blocks.push_back(std::move(block));
+        return *pool.blocks.back();
+    }
+
+    void MemoryAllocator::DestroyBlock(MemoryBlock& block)
+    {
+        if (block.mappedData != nullptr)
+        {
+            m_device.unmapMemory(block.memory);
+        }
+        m_device.freeMemory(block.memory);
+
+        auto& statistics = m_statistics[block.memoryTypeIndex];
+        --statistics.blockCount;
+        statistics.bytesReserved -= block.size;
+        --m_deviceMemoryAllocationCount;
+    }
+
+    MemoryAllocator::MemoryPool& MemoryAllocator::GetPool(uint32_t memoryTypeIndex, ResourceType resourceType, AllocationStrategy strategy)
+    {
+        // Buffers and optimal images live in separate pools, so bufferImageGranularity never has to be taken into account
+        for (auto& pool : m_pools)
+        {
+            if (pool.memoryTypeIndex == memoryTypeIndex && pool.resourceType == resourceType && pool.strategy == strategy)
+            {
+                return pool;
+            }
+        }
+
+        MemoryPool pool;
+        pool.memoryTypeIndex = memoryTypeIndex;
+        pool.resourceType = resourceType;
+        pool.strategy = strategy;
+        m_pools.push_back(std::move(pool));
+
+        return m_pools.back();
+    }
+
+    uint32_t MemoryAllocator::FindMemoryType(uint32_t requiredType, vk::MemoryPropertyFlags requiredProperties) const
+    {
+        for (uint32_t memoryIndex = 0; memoryIndex < m_memoryProperties.memoryTypeCount; ++memoryIndex)
+        {
+            const auto memoryTypeBit = (1 << memoryIndex);
+            if ((requiredType & memoryTypeBit) && (m_memoryProperties.memoryTypes[memoryIndex].propertyFlags & requiredProperties) == requiredProperties)
+            {
+                return memoryIndex;
+            }
+        }
+
+        throw std::runtime_error("Failed to find suitable memory type!");
+    }
+
+    vk::DeviceSize MemoryAllocator::GetBlockSize(uint32_t memoryTypeIndex) const
+    {
+        const auto heapIndex = m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+        const auto heapSize = m_memoryProperties.memoryHeaps[heapIndex].size;
+
+        // Small heaps (e.g. the 256MiB device local + host visible one) get smaller blocks. Buddy blocks must be a power of two
+        vk::DeviceSize blockSize = DEFAULT_BLOCK_SIZE;
+        while (blockSize > MIN_BUDDY_ALLOCATION_SIZE && blockSize > heapSize / 8)
+        {
+            blockSize >>= 1;
+        }
+
+        return blockSize;
+    }
+
+    bool MemoryAllocator::IsHostVisible(uint32_t memoryTypeIndex) const
+    {
+        return static_cast<bool>(m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible);
+    }
+} // namespace vr
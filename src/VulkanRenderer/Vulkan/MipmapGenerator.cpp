@@ -0,0 +1,289 @@
+#include "VulkanRenderer/Vulkan/MipmapGenerator.h"
+#include "VulkanRenderer/Vulkan/Shader.h"
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+
+namespace vr
+{
+    MipmapGenerator::MipmapGenerator(const vk::PhysicalDevice& physicalDevice, const vk::UniqueDevice& device, vk::PipelineCache pipelineCache)
+        : m_physicalDevice(physicalDevice), m_device(device.get()), m_pipelineCache(pipelineCache)
+    {
+    }
+
+    MipmapGenerator::~MipmapGenerator()
+    {
+        if (m_pipeline)
+        {
+            m_device.destroyPipeline(m_pipeline);
+            m_device.destroyPipelineLayout(m_pipelineLayout);
+            m_device.destroyDescriptorSetLayout(m_descriptorSetLayout);
+            m_device.destroySampler(m_sampler);
+        }
+    }
+
+    uint32_t MipmapGenerator::GetMipLevelsCount(uint32_t width, uint32_t height)
+    {
+        return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+    }
+
+    vk::ImageUsageFlags MipmapGenerator::GetRequiredImageUsage(vk::Format format) const
+    {
+        if (SupportsLinearBlit(format))
+        {
+            return vk::ImageUsageFlagBits::eTransferSrc;
+        }
+
+        return vk::ImageUsageFlagBits::eStorage;
+    }
+
+    vk::ImageCreateFlags MipmapGenerator::GetRequiredImageFlags(vk::Format format) const
+    {
+        // Storage views use the UNORM equivalent of sRGB formats, so the storage usage is validated against the view format only
+        if (!SupportsLinearBlit(format) && GetStorageFormat(format) != format)
+        {
+            return vk::ImageCreateFlagBits::eMutableFormat | vk::ImageCreateFlagBits::eExtendedUsage;
+        }
+
+        return {};
+    }
+
+    void MipmapGenerator::Generate(UploadBatcher& uploadBatcher, vk::Image image, vk::Format format, uint32_t width, uint32_t height, uint32_t mipLevels)
+    {
+        if (SupportsLinearBlit(format))
+        {
+            uploadBatcher.RecordOnGraphicsQueue(image, mipLevels, [=](vk::CommandBuffer commandBuffer) {
+                RecordBlits(commandBuffer, image, width, height, mipLevels);
+            });
+
+            return;
+        }
+
+        if (!m_pipeline)
+        {
+            CreateComputePipeline();
+        }
+
+        const auto storageFormat = GetStorageFormat(format);
+        const auto descriptorSetsCount = mipLevels - 1;
+
+        // One set per generated level: the previous level is sampled and the generated one is written
+        const std::array<vk::DescriptorPoolSize, 2> poolSizes = {
+            vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, descriptorSetsCount),
+            vk::DescriptorPoolSize(vk::DescriptorType::eStorageImage, descriptorSetsCount)};
+        const auto descriptorPool = m_device.createDescriptorPool(vk::DescriptorPoolCreateInfo({}, descriptorSetsCount, poolSizes));
+
+        const std::vector<vk::DescriptorSetLayout> layouts(descriptorSetsCount, m_descriptorSetLayout);
+        const auto descriptorSets = m_device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(descriptorPool, layouts));
+
+        // The image has the storage usage, which its own format may not support, so views with that format are only sampled
+        const vk::ImageViewUsageCreateInfo sampledUsageInfo(vk::ImageUsageFlagBits::eSampled);
+
+        std::vector<vk::ImageView> imageViews;
+        for (uint32_t level = 1; level < mipLevels; ++level)
+        {
+            vk::ImageViewCreateInfo viewInfo;
+            viewInfo.setImage(image);
+            viewInfo.setViewType(vk::ImageViewType::e2D);
+
+            viewInfo.setPNext(&sampledUsageInfo);
+            viewInfo.setFormat(format);
+            viewInfo.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, level - 1, 1, 0, 1));
+            const auto sampledView = imageViews.emplace_back(m_device.createImageView(viewInfo));
+
+            viewInfo.setPNext(nullptr);
+            viewInfo.setFormat(storageFormat);
+            viewInfo.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, level, 1, 0, 1));
+            const auto storageView = imageViews.emplace_back(m_device.createImageView(viewInfo));
+
+            const vk::DescriptorImageInfo sourceInfo(m_sampler, sampledView, vk::ImageLayout::eShaderReadOnlyOptimal);
+            const vk::DescriptorImageInfo destinationInfo({}, storageView, vk::ImageLayout::eGeneral);
+
+            std::array<vk::WriteDescriptorSet, 2> writes;
+            writes[0].setDstSet(descriptorSets[level - 1]).setDstBinding(0).setDescriptorType(vk::DescriptorType::eCombinedImageSampler).setImageInfo(sourceInfo);
+            writes[1].setDstSet(descriptorSets[level - 1]).setDstBinding(1).setDescriptorType(vk::DescriptorType::eStorageImage).setImageInfo(destinationInfo);
+
+            m_device.updateDescriptorSets(writes, {});
+        }
+
+        const bool isSrgb = storageFormat != format;
+        uploadBatcher.RecordOnGraphicsQueue(image, mipLevels, [=](vk::CommandBuffer commandBuffer) {
+            RecordComputeDownsample(commandBuffer, image, isSrgb, width, height, descriptorSets);
+        });
+
+        const auto device = m_device;
+        uploadBatcher.DeferUntilComplete([device, descriptorPool, imageViews]() {
+            for (const auto& imageView : imageViews)
+            {
+                device.destroyImageView(imageView);
+            }
+
+            // Destroying the pool frees its sets as well
+            device.destroyDescriptorPool(descriptorPool);
+        });
+    }
+
+    bool MipmapGenerator::SupportsLinearBlit(vk::Format format) const
+    {
+        const auto requiredFeatures = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+        const auto features = m_physicalDevice.getFormatProperties(format).optimalTilingFeatures;
+
+        return (features & requiredFeatures) == requiredFeatures;
+    }
+
+    void MipmapGenerator::RecordBlits(vk::CommandBuffer commandBuffer, vk::Image image, uint32_t width, uint32_t height, uint32_t mipLevels) const
+    {
+        vk::ImageMemoryBarrier barrier;
+        barrier.setImage(image);
+        barrier.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+        barrier.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+        barrier.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
+
+        auto mipWidth = static_cast<int32_t>(width);
+        auto mipHeight = static_cast<int32_t>(height);
+
+        for (uint32_t level = 1; level < mipLevels; ++level)
+        {
+            // The previous level becomes the blit source
+            barrier.subresourceRange.setBaseMipLevel(level - 1);
+            barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+            barrier.setNewLayout(vk::ImageLayout::eTransferSrcOptimal);
+            barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+            barrier.setDstAccessMask(vk::AccessFlagBits::eTransferRead);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, barrier);
+
+            const int32_t nextWidth = std::max(mipWidth / 2, 1);
+            const int32_t nextHeight = std::max(mipHeight / 2, 1);
+
+            vk::ImageBlit blit;
+            blit.setSrcOffsets({vk::Offset3D(0, 0, 0), vk::Offset3D(mipWidth, mipHeight, 1)});
+            blit.setSrcSubresource(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level - 1, 0, 1));
+            blit.setDstOffsets({vk::Offset3D(0, 0, 0), vk::Offset3D(nextWidth, nextHeight, 1)});
+            blit.setDstSubresource(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level, 0, 1));
+
+            commandBuffer.blitImage(image, vk::ImageLayout::eTransferSrcOptimal, image, vk::ImageLayout::eTransferDstOptimal, blit, vk::Filter::eLinear);
+
+            // The previous level is final now
+            barrier.setOldLayout(vk::ImageLayout::eTransferSrcOptimal);
+            barrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+            barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferRead);
+            barrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, barrier);
+
+            mipWidth = nextWidth;
+            mipHeight = nextHeight;
+        }
+
+        barrier.subresourceRange.setBaseMipLevel(mipLevels - 1);
+        barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+        barrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+        barrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, barrier);
+    }
+
+    void MipmapGenerator::RecordComputeDownsample(
+        vk::CommandBuffer commandBuffer,
+        vk::Image image,
+        bool isSrgb,
+        uint32_t width,
+        uint32_t height,
+        const std::vector<vk::DescriptorSet>& descriptorSets) const
+    {
+        const auto mipLevels = static_cast<uint32_t>(descriptorSets.size()) + 1;
+
+        vk::ImageMemoryBarrier barrier;
+        barrier.setImage(image);
+        barrier.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+        barrier.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+
+        // Every generated level is written as a storage image
+        barrier.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 1, mipLevels - 1, 0, 1));
+        barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+        barrier.setNewLayout(vk::ImageLayout::eGeneral);
+        barrier.setSrcAccessMask({});
+        barrier.setDstAccessMask(vk::AccessFlagBits::eShaderWrite);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, {}, {}, barrier);
+
+        // The uploaded level is read by the first dispatch
+        barrier.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
+        barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+        barrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+        barrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, barrier);
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+
+        uint32_t mipWidth = width;
+        uint32_t mipHeight = height;
+        for (uint32_t level = 1; level < mipLevels; ++level)
+        {
+            mipWidth = std::max(mipWidth / 2, 1u);
+            mipHeight = std::max(mipHeight / 2, 1u);
+
+            PushConstants pushConstants;
+            pushConstants.destinationWidth = static_cast<int32_t>(mipWidth);
+            pushConstants.destinationHeight = static_cast<int32_t>(mipHeight);
+            pushConstants.encodeSrgb = isSrgb ? 1 : 0;
+
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, descriptorSets[level - 1], {});
+            commandBuffer.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushConstants), &pushConstants);
+            commandBuffer.dispatch((mipWidth + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, (mipHeight + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+
+            // The generated level is the source of the next dispatch and final afterwards
+            barrier.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, level, 1, 0, 1));
+            barrier.setOldLayout(vk::ImageLayout::eGeneral);
+            barrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+            barrier.setSrcAccessMask(vk::AccessFlagBits::eShaderWrite);
+            barrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, barrier);
+        }
+    }
+
+    void MipmapGenerator::CreateComputePipeline()
+    {
+        spdlog::info("MIPMAP COMPUTE PIPELINE CREATION STARTED");
+        {
+            vk::SamplerCreateInfo samplerInfo;
+            samplerInfo.setMagFilter(vk::Filter::eNearest);
+            samplerInfo.setMinFilter(vk::Filter::eNearest);
+            samplerInfo.setMipmapMode(vk::SamplerMipmapMode::eNearest);
+            samplerInfo.setAddressModeU(vk::SamplerAddressMode::eClampToEdge);
+            samplerInfo.setAddressModeV(vk::SamplerAddressMode::eClampToEdge);
+            samplerInfo.setAddressModeW(vk::SamplerAddressMode::eClampToEdge);
+            m_sampler = m_device.createSampler(samplerInfo);
+
+            const std::array<vk::DescriptorSetLayoutBinding, 2> bindings = {
+                vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute),
+                vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute)};
+            m_descriptorSetLayout = m_device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, bindings));
+
+            const vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushConstants));
+            m_pipelineLayout = m_device.createPipelineLayout(vk::PipelineLayoutCreateInfo({}, m_descriptorSetLayout, pushConstantRange));
+
+            const auto computeShader = Shader("downsample.spv", m_device, ShaderType::VR_COMPUTE_SHADER);
+
+            vk::ComputePipelineCreateInfo pipelineCreateInfo;
+            pipelineCreateInfo.setStage(computeShader.GetPipelineShaderStageInfo());
+            pipelineCreateInfo.setLayout(m_pipelineLayout);
+
+            m_pipeline = m_device.createComputePipeline(m_pipelineCache, pipelineCreateInfo).value;
+        }
+        spdlog::info("MIPMAP COMPUTE PIPELINE CREATION ENDED\n");
+    }
+
+    vk::Format MipmapGenerator::GetStorageFormat(vk::Format format)
+    {
+        switch (format)
+        {
+            case vk::Format::eR8G8B8A8Unorm:
+            case vk::Format::eR8G8B8A8Srgb:
+                return vk::Format::eR8G8B8A8Unorm;
+            default:
+                throw std::runtime_error(fmt::format("Mipmap generation is not supported for the {} format!", vk::to_string(format)));
+        }
+    }
+} // namespace vr
@@ -0,0 +1,155 @@
+#include "VulkanRenderer/Vulkan/PipelineCache.h"
+#include "VulkanRenderer/Utils/Hash.h"
+#include "VulkanRenderer/Utils/MappedFile.h"
+
+#include <spdlog/spdlog.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace vr
+{
+    PipelineCache::PipelineCache(const vk::PhysicalDevice& physicalDevice, const vk::UniqueDevice& device, std::string filePath)
+        : m_physicalDevice(physicalDevice), m_device(device.get()), m_filePath(std::move(filePath))
+    {
+        spdlog::info("PIPELINE CACHE CREATION STARTED");
+        {
+            const auto initialData = LoadData();
+
+            vk::PipelineCacheCreateInfo createInfo;
+            createInfo.setInitialDataSize(initialData.size());
+            createInfo.setPInitialData(initialData.empty() ? nullptr : initialData.data());
+
+            m_pipelineCache = m_device.createPipelineCache(createInfo);
+        }
+        spdlog::info("PIPELINE CACHE CREATION ENDED\n");
+    }
+
+    PipelineCache::~PipelineCache()
+    {
+        Save();
+        m_device.destroyPipelineCache(m_pipelineCache);
+    }
+
+    vk::PipelineCache PipelineCache::Get() const
+    {
+        return m_pipelineCache;
+    }
+
+    void PipelineCache::Save() const
+    {
+        std::vector<uint8_t> data;
+        try
+        {
+            data = m_device.getPipelineCacheData(m_pipelineCache);
+        }
+        catch (const std::exception& exception)
+        {
+            spdlog::warn("Failed to retrieve the pipeline cache data: {}", exception.what());
+            return;
+        }
+
+        auto header = CreateHeader();
+        header.dataSize = data.size();
+        header.dataHash = HashBytes(data.data(), data.size());
+
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(m_filePath).parent_path(), error);
+
+        // Written under a temporary name first, so an interrupted write never leaves a valid looking file behind
+        const std::string temporaryPath = m_filePath + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+            if (!file.good())
+            {
+                spdlog::warn("Failed to write the pipeline cache to '{}'", temporaryPath);
+                file.close();
+
+                std::filesystem::remove(temporaryPath, error);
+                return;
+            }
+        }
+
+        std::filesystem::rename(temporaryPath, m_filePath, error);
+        if (error)
+        {
+            spdlog::warn("Failed to move the pipeline cache into place at '{}': {}", m_filePath, error.message());
+            std::filesystem::remove(temporaryPath, error);
+            return;
+        }
+
+        spdlog::info("Pipeline cache of {} bytes saved to '{}'", data.size(), m_filePath);
+    }
+
+    std::vector<uint8_t> PipelineCache::LoadData() const
+    {
+        std::error_code error;
+        if (!std::filesystem::exists(m_filePath, error))
+        {
+            spdlog::info("No pipeline cache found at '{}', pipelines will be compiled from scratch", m_filePath);
+            return {};
+        }
+
+        MappedFile file;
+        try
+        {
+            file = MappedFile(m_filePath);
+        }
+        catch (const std::exception& exception)
+        {
+            spdlog::warn("Pipeline cache '{}' could not be mapped: {}", m_filePath, exception.what());
+            return {};
+        }
+
+        FileHeader header;
+        if (file.GetSize() < sizeof(header))
+        {
+            spdlog::warn("Pipeline cache '{}' is truncated, it will be rebuilt", m_filePath);
+            return {};
+        }
+        memcpy(&header, file.GetData(), sizeof(header));
+
+        // Drivers are supposed to reject foreign data on their own, but not all of them do it gracefully
+        const auto expectedHeader = CreateHeader();
+        if (header.magic != expectedHeader.magic || header.version != expectedHeader.version || header.vendorID != expectedHeader.vendorID ||
+            header.deviceID != expectedHeader.deviceID || header.driverVersion != expectedHeader.driverVersion ||
+            memcmp(header.pipelineCacheUUID, expectedHeader.pipelineCacheUUID, VK_UUID_SIZE) != 0 ||
+            memcmp(header.driverUUID, expectedHeader.driverUUID, VK_UUID_SIZE) != 0)
+        {
+            spdlog::info("Pipeline cache '{}' was created by a different device or driver, it will be rebuilt", m_filePath);
+            return {};
+        }
+
+        const uint8_t* data = file.GetData() + sizeof(header);
+        if (header.dataSize != file.GetSize() - sizeof(header) || header.dataHash != HashBytes(data, static_cast<size_t>(header.dataSize)))
+        {
+            spdlog::warn("Pipeline cache '{}' is corrupted, it will be rebuilt", m_filePath);
+            return {};
+        }
+
+        spdlog::info("Pipeline cache of {} bytes loaded from '{}'", header.dataSize, m_filePath);
+
+        return std::vector<uint8_t>(data, data + header.dataSize);
+    }
+
+    PipelineCache::FileHeader PipelineCache::CreateHeader() const
+    {
+        const auto propertiesChain = m_physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>();
+        const auto& properties = propertiesChain.get<vk::PhysicalDeviceProperties2>().properties;
+        const auto& idProperties = propertiesChain.get<vk::PhysicalDeviceIDProperties>();
+
+        FileHeader header = {};
+        header.magic = FILE_MAGIC;
+        header.version = FILE_VERSION;
+        header.vendorID = properties.vendorID;
+        header.deviceID = properties.deviceID;
+        header.driverVersion = properties.driverVersion;
+        memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE);
+        memcpy(header.driverUUID, idProperties.driverUUID.data(), VK_UUID_SIZE);
+
+        return header;
+    }
+} // namespace vr
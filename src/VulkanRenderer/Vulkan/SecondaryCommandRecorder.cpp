@@ -0,0 +1,172 @@
+#include "VulkanRenderer/Vulkan/SecondaryCommandRecorder.h"
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace vr
+{
+    SecondaryCommandRecorder::SecondaryCommandRecorder(const vk::UniqueDevice& device, uint32_t queueFamilyIndex, uint32_t frameCount, uint32_t workerCount)
+        : m_device(device.get())
+    {
+        if (workerCount == 0)
+        {
+            workerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // Pools are reset as a whole every time their frame is recorded again
+        const vk::CommandPoolCreateInfo commandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eTransient, queueFamilyIndex);
+
+        m_workers.resize(workerCount);
+        for (auto& worker : m_workers)
+        {
+            for (uint32_t frame = 0; frame < frameCount; ++frame)
+            {
+                const auto commandPool = m_device.createCommandPool(commandPoolCreateInfo);
+                const vk::CommandBufferAllocateInfo allocateInfo(commandPool, vk::CommandBufferLevel::eSecondary, 1);
+
+                worker.commandPools.push_back(commandPool);
+                worker.commandBuffers.push_back(m_device.allocateCommandBuffers(allocateInfo)[0]);
+            }
+        }
+
+        // Threads are started once all of the workers exist, as they access the workers vector
+        for (uint32_t workerIndex = 0; workerIndex < workerCount; ++workerIndex)
+        {
+            m_workers[workerIndex].thread = std::thread(&SecondaryCommandRecorder::WorkerLoop, this, workerIndex);
+        }
+
+        spdlog::info("Secondary command buffers will be recorded by {} worker threads", workerCount);
+    }
+
+    SecondaryCommandRecorder::~SecondaryCommandRecorder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isStopping = true;
+        }
+        m_jobReadyCondition.notify_all();
+
+        for (auto& worker : m_workers)
+        {
+            worker.thread.join();
+
+            // Destroying the pools frees all of the command buffers allocated from them
+            for (const auto commandPool : worker.commandPools)
+            {
+                m_device.destroyCommandPool(commandPool);
+            }
+        }
+    }
+
+    uint32_t SecondaryCommandRecorder::GetWorkerCount() const
+    {
+        return static_cast<uint32_t>(m_workers.size());
+    }
+
+    std::vector<vk::CommandBuffer> SecondaryCommandRecorder::Record(
+        uint32_t frameIndex,
+        const vk::CommandBufferInheritanceInfo& inheritanceInfo,
+        std::size_t itemCount,
+        const RecordFunction& recordFunction)
+    {
+        const auto maxSliceCount = std::max<std::size_t>(1, itemCount / MIN_ITEMS_PER_WORKER);
+        const auto sliceCount = static_cast<uint32_t>(std::min<std::size_t>(maxSliceCount, m_workers.size()));
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_job.frameIndex = frameIndex;
+            m_job.inheritanceInfo = &inheritanceInfo;
+            m_job.itemCount = itemCount;
+            m_job.sliceCount = sliceCount;
+            m_job.recordFunction = &recordFunction;
+            m_exception = nullptr;
+
+            m_busyWorkersCount = sliceCount;
+            ++m_jobGeneration;
+            m_jobReadyCondition.notify_all();
+
+            m_jobDoneCondition.wait(lock, [this]() { return m_busyWorkersCount == 0; });
+
+            if (m_exception)
+            {
+                std::rethrow_exception(m_exception);
+            }
+        }
+
+        std::vector<vk::CommandBuffer> commandBuffers;
+        commandBuffers.reserve(sliceCount);
+        for (uint32_t workerIndex = 0; workerIndex < sliceCount; ++workerIndex)
+        {
+            commandBuffers.push_back(m_workers[workerIndex].commandBuffers[frameIndex]);
+        }
+
+        return commandBuffers;
+    }
+
+    void SecondaryCommandRecorder::WorkerLoop(uint32_t workerIndex)
+    {
+        uint64_t lastJobGeneration = 0;
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_jobReadyCondition.wait(lock, [&]() { return m_isStopping || m_jobGeneration != lastJobGeneration; });
+
+                if (m_isStopping)
+                {
+                    return;
+                }
+
+                lastJobGeneration = m_jobGeneration;
+                job = m_job;
+            }
+
+            // Workers without a slice have nothing to report back
+            if (workerIndex >= job.sliceCount)
+            {
+                continue;
+            }
+
+            std::exception_ptr exception;
+            try
+            {
+                RecordSlice(workerIndex, job);
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (exception && !m_exception)
+            {
+                m_exception = exception;
+            }
+
+            if (--m_busyWorkersCount == 0)
+            {
+                m_jobDoneCondition.notify_one();
+            }
+        }
+    }
+
+    void SecondaryCommandRecorder::RecordSlice(uint32_t workerIndex, const Job& job)
+    {
+        const auto first = job.itemCount * workerIndex / job.sliceCount;
+        const auto last = job.itemCount * (workerIndex + 1) / job.sliceCount;
+
+        auto& worker = m_workers[workerIndex];
+        m_device.resetCommandPool(worker.commandPools[job.frameIndex], {});
+
+        const auto commandBuffer = worker.commandBuffers[job.frameIndex];
+        const vk::CommandBufferBeginInfo beginInfo(
+            vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+            job.inheritanceInfo);
+
+        commandBuffer.begin(beginInfo);
+        (*job.recordFunction)(commandBuffer, first, last);
+        commandBuffer.end();
+    }
+} // namespace vr
@@ -6,13 +6,13 @@
 
 namespace vr
 {
-    Shader::Shader(const std::string& shaderName, const vk::UniqueDevice& device, ShaderType type)
+    Shader::Shader(const std::string& shaderName, vk::Device device, ShaderType type)
         : m_shaderType(SHADER_TYPES_MAP.at(type))
     {
         spdlog::info("{} SHADER CREATION STARTED", shaderName);
         {
             const auto byteCode = LoadCode(VK_GET_SHADER_PATH(shaderName));
-            m_shaderModule = device->createShaderModuleUnique(CreateShaderModule(byteCode));
+            m_shaderModule = device.createShaderModuleUnique(CreateShaderModule(byteCode));
         }
         spdlog::info("{} SHADER CREATION ENDED\n", shaderName);
     }
@@ -0,0 +1,63 @@
+#include "VulkanRenderer/Vulkan/StagingRing.h"
+
+namespace vr
+{
+    StagingRing::StagingRing(const vk::UniqueDevice& device, MemoryAllocator& allocator, UploadBatcher& uploadBatcher, vk::DeviceSize size)
+        : m_device(device.get()), m_allocator(allocator), m_uploadBatcher(uploadBatcher), m_size(size)
+    {
+        vk::BufferCreateInfo bufferCreateInfo;
+        bufferCreateInfo.setSize(m_size);
+        bufferCreateInfo.setUsage(vk::BufferUsageFlagBits::eTransferSrc);
+        bufferCreateInfo.setSharingMode(vk::SharingMode::eExclusive);
+
+        m_buffer = m_device.createBuffer(bufferCreateInfo);
+        m_allocation = m_allocator.AllocateForBuffer(m_buffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+    }
+
+    StagingRing::~StagingRing()
+    {
+        // Release callbacks of the pending batches refer to the ring
+        m_uploadBatcher.WaitAll();
+
+        m_device.destroyBuffer(m_buffer);
+        m_allocator.Free(m_allocation);
+    }
+
+    std::optional<StagingAllocation> StagingRing::Allocate(vk::DeviceSize size, vk::DeviceSize alignment)
+    {
+        if (m_usedSize == 0)
+        {
+            // Nothing is in flight, so the whole ring is available from its beginning
+            m_head = 0;
+        }
+
+        auto offset = (m_head + alignment - 1) & ~(alignment - 1);
+        if (offset + size > m_size)
+        {
+            // Allocations never wrap around, the rest of the ring is skipped instead
+            offset = 0;
+        }
+
+        const auto reservedSize = offset >= m_head ? offset + size - m_head : m_size - m_head + size;
+        if (m_usedSize + reservedSize > m_size)
+        {
+            return std::nullopt;
+        }
+
+        m_head = offset + size;
+        m_usedSize += reservedSize;
+        m_uploadBatcher.DeferUntilComplete([this, reservedSize]() { m_usedSize -= reservedSize; });
+
+        StagingAllocation allocation;
+        allocation.buffer = m_buffer;
+        allocation.offset = offset;
+        allocation.data = static_cast<uint8_t*>(m_allocation.mappedData) + offset;
+
+        return allocation;
+    }
+
+    vk::DeviceSize StagingRing::GetSize() const
+    {
+        return m_size;
+    }
+} // namespace vr
@@ -0,0 +1,249 @@
+#include "VulkanRenderer/Vulkan/TextureCache.h"
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <filesystem>
+#include <stdexcept>
+
+namespace vr
+{
+    TextureCache::TextureCache(TextureStreamer& textureStreamer, BindlessTextureTable* bindlessTextureTable, vk::DeviceSize budget)
+        : m_textureStreamer(textureStreamer), m_bindlessTextureTable(bindlessTextureTable)
+    {
+        m_statistics.budget = budget;
+
+        if (m_bindlessTextureTable)
+        {
+            m_bindlessTextureTable->Write(PLACEHOLDER_DESCRIPTOR_INDEX, m_textureStreamer.GetPlaceholder().view);
+        }
+    }
+
+    TextureCache::~TextureCache()
+    {
+        // Hands over every requested texture, so no callback outlives the cache
+        m_textureStreamer.WaitIdle();
+
+        for (auto& entry : m_entries)
+        {
+            if (entry.texture.image)
+            {
+                m_textureStreamer.Destroy(entry.texture);
+            }
+        }
+    }
+
+    TextureId TextureCache::Acquire(const std::string& path)
+    {
+        // Different spellings of the same path share the entry
+        const auto normalizedPath = std::filesystem::path(path).lexically_normal().generic_string();
+
+        TextureId id;
+        const auto pathId = m_pathIds.find(normalizedPath);
+        if (pathId != m_pathIds.end())
+        {
+            id = pathId->second;
+            ++m_statistics.hitCount;
+        }
+        else
+        {
+            id = CreateEntry(normalizedPath);
+            ++m_statistics.missCount;
+
+            m_textureStreamer.Request(normalizedPath, [this, id](StreamedTexture texture) { OnTextureReady(id, texture); });
+        }
+
+        ++m_entries[id].referenceCount;
+
+        return id;
+    }
+
+    void TextureCache::Release(TextureId id)
+    {
+        auto& entry = m_entries[Resolve(id)];
+        if (entry.referenceCount == 0)
+        {
+            throw std::runtime_error(fmt::format("Texture '{}' released more times than acquired!", entry.paths.front()));
+        }
+
+        --entry.referenceCount;
+    }
+
+    bool TextureCache::IsLoaded(TextureId id) const
+    {
+        return static_cast<bool>(m_entries[Resolve(id)].texture.view);
+    }
+
+    vk::ImageView TextureCache::GetView(TextureId id) const
+    {
+        const auto& entry = m_entries[Resolve(id)];
+        return entry.texture.view ? entry.texture.view : m_textureStreamer.GetPlaceholder().view;
+    }
+
+    uint32_t TextureCache::GetDescriptorIndex(TextureId id) const
+    {
+        const auto resolvedId = Resolve(id);
+        return m_entries[resolvedId].texture.view && IsInBindlessTable(resolvedId) ? resolvedId + 1 : PLACEHOLDER_DESCRIPTOR_INDEX;
+    }
+
+    void TextureCache::Touch(TextureId id, uint64_t submissionNumber)
+    {
+        auto& entry = m_entries[Resolve(id)];
+        entry.lastSubmissionNumber = submissionNumber;
+
+        if (entry.texture.view)
+        {
+            m_lruIds.splice(m_lruIds.end(), m_lruIds, entry.lruPosition);
+        }
+    }
+
+    void TextureCache::Collect(uint64_t completedSubmissionNumber)
+    {
+        auto lruId = m_lruIds.begin();
+        while (lruId != m_lruIds.end() && m_statistics.bytesUsed > m_statistics.budget)
+        {
+            const auto id = *lruId++;
+
+            const auto& entry = m_entries[id];
+            if (entry.referenceCount == 0 && entry.lastSubmissionNumber <= completedSubmissionNumber)
+            {
+                Evict(id);
+            }
+        }
+    }
+
+    void TextureCache::SetBudget(vk::DeviceSize budget)
+    {
+        m_statistics.budget = budget;
+    }
+
+    TextureCacheStatistics TextureCache::GetStatistics() const
+    {
+        return m_statistics;
+    }
+
+    TextureId TextureCache::CreateEntry(const std::string& path)
+    {
+        TextureId id;
+        if (!m_freeIds.empty())
+        {
+            id = m_freeIds.back();
+            m_freeIds.pop_back();
+        }
+        else
+        {
+            id = static_cast<TextureId>(m_entries.size());
+            m_entries.emplace_back();
+        }
+
+        auto& entry = m_entries[id];
+        entry.paths.push_back(path);
+        m_pathIds[path] = id;
+
+        return id;
+    }
+
+    TextureId TextureCache::Resolve(TextureId id) const
+    {
+        // Duplicates always forward to an entry holding a texture, never to another duplicate
+        const auto duplicateOf = m_entries[id].duplicateOf;
+        return duplicateOf != INVALID_ID ? duplicateOf : id;
+    }
+
+    bool TextureCache::IsSameContent(const StreamedTexture& texture, const StreamedTexture& otherTexture)
+    {
+        return texture.contentHash == otherTexture.contentHash
+            && texture.contentSize == otherTexture.contentSize
+            && texture.format == otherTexture.format
+            && texture.width == otherTexture.width
+            && texture.height == otherTexture.height
+            && texture.mipLevels == otherTexture.mipLevels;
+    }
+
+    bool TextureCache::IsInBindlessTable(TextureId id) const
+    {
+        // The placeholder takes the first index, so entries are shifted by one
+        return m_bindlessTextureTable && id + 1 < m_bindlessTextureTable->GetCapacity();
+    }
+
+    void TextureCache::OnTextureReady(TextureId id, StreamedTexture texture)
+    {
+        auto& entry = m_entries[id];
+
+        const auto contentId = m_contentIds.find(texture.contentHash);
+        if (contentId != m_contentIds.end() && IsSameContent(m_entries[contentId->second].texture, texture))
+        {
+            // The duplicate has never been bound, so it can be destroyed right away
+            m_textureStreamer.Destroy(texture);
+
+            const auto originalId = contentId->second;
+            auto& original = m_entries[originalId];
+            for (const auto& path : entry.paths)
+            {
+                m_pathIds[path] = originalId;
+                original.paths.push_back(path);
+            }
+            original.referenceCount += entry.referenceCount;
+            original.duplicates.push_back(id);
+
+            entry.paths.clear();
+            entry.referenceCount = 0;
+            entry.duplicateOf = originalId;
+
+            ++m_statistics.duplicateCount;
+            spdlog::info("Texture '{}' is identical to '{}', which is shared instead", original.paths.back(), original.paths.front());
+
+            return;
+        }
+
+        entry.texture = texture;
+        entry.lruPosition = m_lruIds.insert(m_lruIds.end(), id);
+        // On a hash collision, the texture loaded first stays the one duplicates are matched against
+        m_contentIds.emplace(texture.contentHash, id);
+
+        if (IsInBindlessTable(id))
+        {
+            m_bindlessTextureTable->Write(id + 1, texture.view);
+        }
+        else if (m_bindlessTextureTable)
+        {
+            spdlog::warn("Texture '{}' does not fit in the bindless texture table, the placeholder is sampled instead", entry.paths.front());
+        }
+
+        ++m_statistics.loadedTextureCount;
+        m_statistics.bytesUsed += texture.allocation.size;
+    }
+
+    void TextureCache::Evict(TextureId id)
+    {
+        auto& entry = m_entries[id];
+
+        spdlog::debug("Evicting texture '{}' ({} bytes)", entry.paths.front(), entry.texture.allocation.size);
+
+        --m_statistics.loadedTextureCount;
+        m_statistics.bytesUsed -= entry.texture.allocation.size;
+        ++m_statistics.evictionCount;
+
+        const auto contentId = m_contentIds.find(entry.texture.contentHash);
+        if (contentId != m_contentIds.end() && contentId->second == id)
+        {
+            m_contentIds.erase(contentId);
+        }
+        m_lruIds.erase(entry.lruPosition);
+        m_textureStreamer.Destroy(entry.texture);
+
+        for (const auto& path : entry.paths)
+        {
+            m_pathIds.erase(path);
+        }
+
+        // No reference is left to the duplicates either, their references were moved to this entry
+        for (const auto duplicateId : entry.duplicates)
+        {
+            m_entries[duplicateId] = Entry();
+            m_freeIds.push_back(duplicateId);
+        }
+
+        entry = Entry();
+        m_freeIds.push_back(id);
+    }
+} // namespace vr
@@ -0,0 +1,437 @@
+#include "VulkanRenderer/Vulkan/TextureStreamer.h"
+#include "VulkanRenderer/Assets/BasisTranscoder.h"
+#include "VulkanRenderer/Utils/Hash.h"
+#include "VulkanRenderer/Utils/MappedFile.h"
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+namespace vr
+{
+    /** Copies into compressed images need offsets aligned to the block size, which is at most 16 bytes */
+    static const vk::DeviceSize STAGING_ALIGNMENT = 16;
+
+    static const vk::FormatFeatureFlags SAMPLED_FORMAT_FEATURES = vk::FormatFeatureFlagBits::eSampledImage | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+
+    TextureStreamer::TextureStreamer(
+        const vk::PhysicalDevice& physicalDevice,
+        const vk::UniqueDevice& device,
+        MemoryAllocator& allocator,
+        UploadBatcher& uploadBatcher,
+        MipmapGenerator& mipmapGenerator,
+        uint32_t workerCount,
+        vk::DeviceSize stagingRingSize)
+        : m_physicalDevice(physicalDevice),
+          m_device(device.get()),
+          m_allocator(allocator),
+          m_uploadBatcher(uploadBatcher),
+          m_mipmapGenerator(mipmapGenerator),
+          m_stagingRing(device, allocator, uploadBatcher, stagingRingSize)
+    {
+        CreatePlaceholder();
+
+        if (workerCount == 0)
+        {
+            workerCount = std::max(1u, std::thread::hardware_concurrency() / 2);
+        }
+
+        m_workers.reserve(workerCount);
+        for (uint32_t worker = 0; worker < workerCount; ++worker)
+        {
+            m_workers.emplace_back(&TextureStreamer::WorkerLoop, this);
+        }
+    }
+
+    TextureStreamer::~TextureStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isStopping = true;
+        }
+        m_requestCondition.notify_all();
+
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+
+        // Textures which have not been handed over yet may still be uploading
+        m_uploadBatcher.WaitAll();
+        for (auto& pendingTexture : m_pendingTextures)
+        {
+            Destroy(pendingTexture->texture);
+        }
+        Destroy(m_placeholder);
+    }
+
+    const StreamedTexture& TextureStreamer::GetPlaceholder() const
+    {
+        return m_placeholder;
+    }
+
+    void TextureStreamer::Request(const std::string& path, ReadyCallback onReady)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_requests.push_back({path, std::move(onReady)});
+        }
+        m_requestCondition.notify_one();
+    }
+
+    void TextureStreamer::Update()
+    {
+        // Marks the textures of the completed batches as uploaded
+        m_uploadBatcher.Collect();
+
+        while (!m_pendingTextures.empty() && m_pendingTextures.front()->isUploaded)
+        {
+            const auto pendingTexture = std::move(m_pendingTextures.front());
+            m_pendingTextures.pop_front();
+
+            pendingTexture->onReady(pendingTexture->texture);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::move(m_decodedTextures.begin(), m_decodedTextures.end(), std::back_inserter(m_uploadQueue));
+            m_decodedTextures.clear();
+        }
+
+        // Textures are uploaded in order, so a large one waiting for the ring is not starved by the smaller ones behind it
+        while (!m_uploadQueue.empty() && Upload(m_uploadQueue.front()))
+        {
+            m_uploadQueue.pop_front();
+        }
+    }
+
+    bool TextureStreamer::IsIdle() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_requests.empty() && m_decodingCount == 0 && m_decodedTextures.empty() && m_uploadQueue.empty() && m_pendingTextures.empty();
+    }
+
+    void TextureStreamer::WaitIdle()
+    {
+        while (true)
+        {
+            Update();
+            m_uploadBatcher.WaitAll();
+            Update();
+
+            // Nothing left for the render thread to do until the workers decode more textures
+            std::unique_lock<std::mutex> lock(m_mutex);
+            const auto isDecodingDone = [this]() { return m_requests.empty() && m_decodingCount == 0; };
+            const auto hasUploads = [this]() { return !m_decodedTextures.empty() || !m_uploadQueue.empty() || !m_pendingTextures.empty(); };
+            if (isDecodingDone() && !hasUploads())
+            {
+                return;
+            }
+
+            m_decodedCondition.wait(lock, [&]() { return isDecodingDone() || hasUploads(); });
+        }
+    }
+
+    void TextureStreamer::Destroy(StreamedTexture& texture)
+    {
+        m_device.destroyImageView(texture.view);
+        m_device.destroyImage(texture.image);
+        m_allocator.Free(texture.allocation);
+
+        texture = StreamedTexture();
+    }
+
+    void TextureStreamer::WorkerLoop()
+    {
+        while (true)
+        {
+            LoadRequest request;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_requestCondition.wait(lock, [this]() { return m_isStopping || !m_requests.empty(); });
+                if (m_isStopping)
+                {
+                    return;
+                }
+
+                request = std::move(m_requests.front());
+                m_requests.pop_front();
+                ++m_decodingCount;
+            }
+
+            Decode(request);
+        }
+    }
+
+    void TextureStreamer::Decode(LoadRequest& request)
+    {
+        DecodedTexture decoded;
+        decoded.path = request.path;
+        decoded.onReady = std::move(request.onReady);
+
+        bool isDecoded = false;
+        try
+        {
+            const auto compressedPath = std::filesystem::path(request.path).replace_extension(".ktx2").string();
+
+            std::error_code error;
+            if (!(std::filesystem::exists(compressedPath, error) && DecodeCompressed(compressedPath, decoded)))
+            {
+                DecodeImage(request.path, decoded);
+            }
+            isDecoded = true;
+        }
+        catch (const std::exception& exception)
+        {
+            spdlog::error("Texture '{}' could not be loaded: {}", request.path, exception.what());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_decodingCount;
+            if (isDecoded)
+            {
+                m_decodedTextures.push_back(std::move(decoded));
+            }
+        }
+        m_decodedCondition.notify_all();
+    }
+
+    bool TextureStreamer::DecodeCompressed(const std::string& path, DecodedTexture& decoded) const
+    {
+        try
+        {
+            const Ktx2Texture texture(path);
+            const auto& levels = texture.GetLevels();
+            decoded.contentHash = HashBytes(texture.GetFileData(), texture.GetFileSize());
+            decoded.contentSize = texture.GetFileSize();
+
+            if (texture.IsBasisUniversal())
+            {
+                if (!BasisTranscoder::IsAvailable())
+                {
+                    spdlog::warn("Texture '{}' needs transcoding, but the renderer was built without Basis Universal", path);
+                    return false;
+                }
+
+                // 4x4 blocks of 16 bytes in all of them, BC7 and ASTC keep the most quality
+                const auto targets = texture.IsSrgb()
+                    ? std::array<vk::Format, 3>{vk::Format::eBc7SrgbBlock, vk::Format::eAstc4x4SrgbBlock, vk::Format::eEtc2R8G8B8A8SrgbBlock}
+                    : std::array<vk::Format, 3>{vk::Format::eBc7UnormBlock, vk::Format::eAstc4x4UnormBlock, vk::Format::eEtc2R8G8B8A8UnormBlock};
+                const auto target = std::find_if(targets.begin(), targets.end(), [this](vk::Format format) { return IsSampleable(format); });
+                if (target == targets.end())
+                {
+                    spdlog::warn("Texture '{}' needs transcoding, but the device can sample none of BC7, ASTC 4x4 and ETC2", path);
+                    return false;
+                }
+
+                // Transcoded levels are already stored next to each other, with block aligned offsets
+                auto transcodedTexture = BasisTranscoder::Transcode(texture, *target);
+                decoded.data = std::move(transcodedTexture.data);
+                decoded.levels = std::move(transcodedTexture.levels);
+                decoded.format = *target;
+            }
+            else
+            {
+                if (!IsSampleable(texture.GetFormat()))
+                {
+                    spdlog::warn("Texture '{}' has format {}, which the device cannot sample", path, vk::to_string(texture.GetFormat()));
+                    return false;
+                }
+
+                // Levels are stored from the smallest one in the file, they are packed from the largest one here
+                const auto alignment = static_cast<size_t>(STAGING_ALIGNMENT);
+                decoded.levels = levels;
+                size_t dataSize = 0;
+                for (auto& level : decoded.levels)
+                {
+                    level.offset = dataSize;
+                    dataSize = (dataSize + level.size + alignment - 1) & ~(alignment - 1);
+                }
+
+                decoded.data.resize(dataSize);
+                for (size_t level = 0; level < levels.size(); ++level)
+                {
+                    memcpy(decoded.data.data() + decoded.levels[level].offset, texture.GetFileData() + levels[level].offset, levels[level].size);
+                }
+                decoded.format = texture.GetFormat();
+            }
+
+            decoded.mipLevels = static_cast<uint32_t>(decoded.levels.size());
+        }
+        catch (const std::exception& exception)
+        {
+            spdlog::warn("Compressed texture '{}' could not be loaded: {}", path, exception.what());
+            return false;
+        }
+
+        return true;
+    }
+
+    void TextureStreamer::DecodeImage(const std::string& path, DecodedTexture& decoded) const
+    {
+        // The file is read once, for both the hash and the decoding
+        const MappedFile file(path);
+        decoded.contentHash = HashBytes(file.GetData(), file.GetSize());
+        decoded.contentSize = file.GetSize();
+
+        int width, height, channels;
+        stbi_uc* pixels = stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &width, &height, &channels, STBI_rgb_alpha);
+        if (!pixels)
+        {
+            throw std::runtime_error(fmt::format("Failed to decode '{}': {}", path, stbi_failure_reason()));
+        }
+
+        const auto size = static_cast<size_t>(width) * height * 4;
+        decoded.data.assign(pixels, pixels + size);
+        stbi_image_free(pixels);
+
+        TextureLevel level;
+        level.size = size;
+        level.width = static_cast<uint32_t>(width);
+        level.height = static_cast<uint32_t>(height);
+
+        decoded.levels = {level};
+        decoded.format = IMAGE_FORMAT;
+        decoded.mipLevels = MipmapGenerator::GetMipLevelsCount(level.width, level.height);
+    }
+
+    bool TextureStreamer::Upload(DecodedTexture& decoded)
+    {
+        const auto size = static_cast<vk::DeviceSize>(decoded.data.size());
+
+        vk::Buffer stagingBuffer;
+        vk::DeviceSize stagingOffset = 0;
+        if (size > m_stagingRing.GetSize())
+        {
+            // It would never fit into the ring, so it gets a staging buffer of its own
+            stagingBuffer = m_uploadBatcher.Stage(decoded.data.data(), size);
+        }
+        else
+        {
+            const auto allocation = m_stagingRing.Allocate(size, STAGING_ALIGNMENT);
+            if (!allocation)
+            {
+                return false;
+            }
+
+            memcpy(allocation->data, decoded.data.data(), static_cast<size_t>(size));
+            stagingBuffer = allocation->buffer;
+            stagingOffset = allocation->offset;
+        }
+
+        const auto& baseLevel = decoded.levels.front();
+        const bool generatesMips = decoded.mipLevels > decoded.levels.size();
+
+        auto pendingTexture = std::make_unique<PendingTexture>();
+        pendingTexture->texture = CreateTexture(decoded.format, baseLevel.width, baseLevel.height, decoded.mipLevels, generatesMips);
+        pendingTexture->texture.contentHash = decoded.contentHash;
+        pendingTexture->texture.contentSize = decoded.contentSize;
+        pendingTexture->onReady = std::move(decoded.onReady);
+
+        const auto image = pendingTexture->texture.image;
+        m_uploadBatcher.TransitionImageLayout(image, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, decoded.mipLevels);
+        for (uint32_t level = 0; level < decoded.levels.size(); ++level)
+        {
+            const auto& textureLevel = decoded.levels[level];
+            m_uploadBatcher.CopyBufferToImage(stagingBuffer, image, textureLevel.width, textureLevel.height, level, stagingOffset + textureLevel.offset);
+        }
+
+        if (generatesMips)
+        {
+            m_mipmapGenerator.Generate(m_uploadBatcher, image, decoded.format, baseLevel.width, baseLevel.height, decoded.mipLevels);
+        }
+        else
+        {
+            m_uploadBatcher.TransitionImageLayout(image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, decoded.mipLevels);
+        }
+
+        auto* uploadedTexture = pendingTexture.get();
+        m_uploadBatcher.DeferUntilComplete([uploadedTexture]() { uploadedTexture->isUploaded = true; });
+        m_pendingTextures.push_back(std::move(pendingTexture));
+
+        spdlog::info(
+            "Texture '{}' streamed in: {}x{}, {} levels, {}",
+            decoded.path,
+            baseLevel.width,
+            baseLevel.height,
+            decoded.mipLevels,
+            vk::to_string(decoded.format));
+
+        return true;
+    }
+
+    StreamedTexture TextureStreamer::CreateTexture(vk::Format format, uint32_t width, uint32_t height, uint32_t mipLevels, bool generatesMips)
+    {
+        StreamedTexture texture;
+        texture.format = format;
+        texture.width = width;
+        texture.height = height;
+        texture.mipLevels = mipLevels;
+
+        vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+        vk::ImageCreateFlags flags;
+        if (generatesMips)
+        {
+            usage |= m_mipmapGenerator.GetRequiredImageUsage(format);
+            flags |= m_mipmapGenerator.GetRequiredImageFlags(format);
+        }
+
+        vk::ImageCreateInfo imageInfo;
+        imageInfo.setImageType(vk::ImageType::e2D);
+        imageInfo.setExtent(vk::Extent3D(width, height, 1));
+        imageInfo.setFlags(flags);
+        imageInfo.setMipLevels(mipLevels);
+        imageInfo.setArrayLayers(1);
+        imageInfo.setFormat(format);
+        imageInfo.setTiling(vk::ImageTiling::eOptimal);
+        imageInfo.setInitialLayout(vk::ImageLayout::eUndefined);
+        imageInfo.setUsage(usage);
+        imageInfo.setSharingMode(vk::SharingMode::eExclusive);
+        imageInfo.setSamples(vk::SampleCountFlagBits::e1);
+
+        texture.image = m_device.createImage(imageInfo);
+        texture.allocation = m_allocator.AllocateForImage(texture.image, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+        // The view is only sampled, even when the image also has the storage usage for the mip generation
+        const vk::ImageViewUsageCreateInfo viewUsageInfo(vk::ImageUsageFlagBits::eSampled);
+
+        vk::ImageViewCreateInfo viewInfo;
+        viewInfo.setImage(texture.image);
+        viewInfo.setViewType(vk::ImageViewType::e2D);
+        viewInfo.setFormat(format);
+        viewInfo.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1));
+        if (generatesMips)
+        {
+            viewInfo.setPNext(&viewUsageInfo);
+        }
+        texture.view = m_device.createImageView(viewInfo);
+
+        return texture;
+    }
+
+    void TextureStreamer::CreatePlaceholder()
+    {
+        // Uploaded with the initialization, every frame is submitted after it
+        const std::array<uint8_t, 4> whiteTexel = {255, 255, 255, 255};
+        const auto stagingBuffer = m_uploadBatcher.Stage(whiteTexel.data(), whiteTexel.size());
+
+        m_placeholder = CreateTexture(IMAGE_FORMAT, 1, 1, 1, false);
+        m_uploadBatcher.TransitionImageLayout(m_placeholder.image, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+        m_uploadBatcher.CopyBufferToImage(stagingBuffer, m_placeholder.image, 1, 1);
+        m_uploadBatcher.TransitionImageLayout(m_placeholder.image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+    }
+
+    bool TextureStreamer::IsSampleable(vk::Format format) const
+    {
+        const auto properties = m_physicalDevice.getFormatProperties(format);
+        return (properties.optimalTilingFeatures & SAMPLED_FORMAT_FEATURES) == SAMPLED_FORMAT_FEATURES;
+    }
+} // namespace vr
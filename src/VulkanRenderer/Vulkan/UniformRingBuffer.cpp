@@ -0,0 +1,66 @@
+#include "VulkanRenderer/Vulkan/UniformRingBuffer.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+
+namespace vr
+{
+    UniformRingBuffer::UniformRingBuffer(const vk::UniqueDevice& device, MemoryAllocator& allocator, vk::DeviceSize minOffsetAlignment, uint32_t frameCount, vk::DeviceSize frameSize)
+        : m_device(device.get()), m_allocator(allocator), m_alignment(std::max<vk::DeviceSize>(minOffsetAlignment, 1)), m_frameCount(frameCount)
+    {
+        // Every frame region has to start on an aligned offset as well
+        m_frameSize = AlignUp(frameSize);
+
+        vk::BufferCreateInfo bufferCreateInfo;
+        bufferCreateInfo.setSize(m_frameSize * m_frameCount);
+        bufferCreateInfo.setUsage(vk::BufferUsageFlagBits::eUniformBuffer);
+        bufferCreateInfo.setSharingMode(vk::SharingMode::eExclusive);
+
+        m_buffer = m_device.createBuffer(bufferCreateInfo);
+        m_allocation = m_allocator.AllocateForBuffer(m_buffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+    }
+
+    UniformRingBuffer::~UniformRingBuffer()
+    {
+        m_device.destroyBuffer(m_buffer);
+        m_allocator.Free(m_allocation);
+    }
+
+    void UniformRingBuffer::BeginFrame(uint32_t frameIndex)
+    {
+        m_frameBegin = GetFrameOffset(frameIndex);
+        m_frameOffset = 0;
+    }
+
+    RingAllocation UniformRingBuffer::Allocate(vk::DeviceSize size)
+    {
+        if (m_frameOffset + size > m_frameSize)
+        {
+            throw std::runtime_error(fmt::format("Uniform ring buffer frame region of {} bytes exhausted!", m_frameSize));
+        }
+
+        RingAllocation allocation;
+        allocation.offset = m_frameBegin + m_frameOffset;
+        allocation.data = static_cast<uint8_t*>(m_allocation.mappedData) + allocation.offset;
+
+        m_frameOffset = AlignUp(m_frameOffset + size);
+
+        return allocation;
+    }
+
+    vk::Buffer UniformRingBuffer::GetBuffer() const
+    {
+        return m_buffer;
+    }
+
+    vk::DeviceSize UniformRingBuffer::GetFrameOffset(uint32_t frameIndex) const
+    {
+        return m_frameSize * frameIndex;
+    }
+
+    vk::DeviceSize UniformRingBuffer::AlignUp(vk::DeviceSize value) const
+    {
+        // minUniformBufferOffsetAlignment is guaranteed to be a power of two
+        return (value + m_alignment - 1) & ~(m_alignment - 1);
+    }
+} // namespace vr
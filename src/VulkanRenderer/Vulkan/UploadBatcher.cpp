@@ -0,0 +1,453 @@
+#include "VulkanRenderer/Vulkan/UploadBatcher.h"
+#include "VulkanRenderer/Vulkan/Utils.h"
+
+#include <cstring>
+
+namespace vr
+{
+    /** Every stage and access type uploaded data can be consumed with */
+    static const vk::PipelineStageFlags UPLOAD_CONSUMER_STAGES = vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader;
+    static const vk::AccessFlags UPLOAD_CONSUMER_ACCESS = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead;
+
+    /** Stages and access types of the processing recorded with RecordOnGraphicsQueue */
+    static const vk::PipelineStageFlags GRAPHICS_WORK_STAGES = vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader;
+    static const vk::AccessFlags GRAPHICS_WORK_ACCESS = vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+
+    UploadBatcher::UploadBatcher(
+        const vk::UniqueDevice& device,
+        MemoryAllocator& allocator,
+        uint32_t transferQueueFamilyIndex,
+        vk::Queue transferQueue,
+        uint32_t graphicsQueueFamilyIndex,
+        vk::Queue graphicsQueue,
+        GpuProfiler* profiler)
+        : m_device(device.get()),
+          m_allocator(allocator),
+          m_transferQueueFamilyIndex(transferQueueFamilyIndex),
+          m_transferQueue(transferQueue),
+          m_graphicsQueueFamilyIndex(graphicsQueueFamilyIndex),
+          m_graphicsQueue(graphicsQueue),
+          m_profiler(profiler)
+    {
+        // Batches are only profiled if both of the queues they use can write timestamps
+        if (m_profiler != nullptr && !(m_profiler->IsQueueFamilySupported(m_transferQueueFamilyIndex) && m_profiler->IsQueueFamilySupported(m_graphicsQueueFamilyIndex)))
+        {
+            m_profiler = nullptr;
+        }
+
+        const auto poolFlags = vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+        m_transferCommandPool = m_device.createCommandPool(vk::CommandPoolCreateInfo(poolFlags, m_transferQueueFamilyIndex));
+
+        if (IsOwnershipTransferRequired())
+        {
+            m_graphicsCommandPool = m_device.createCommandPool(vk::CommandPoolCreateInfo(poolFlags, m_graphicsQueueFamilyIndex));
+        }
+    }
+
+    UploadBatcher::~UploadBatcher()
+    {
+        WaitAll();
+
+        for (const auto& batch : m_freeBatches)
+        {
+            m_device.destroyFence(batch.fence);
+            if (batch.transferFinishedSemaphore)
+            {
+                m_device.destroySemaphore(batch.transferFinishedSemaphore);
+            }
+        }
+
+        // Destroying the pools frees all of the command buffers allocated from them
+        m_device.destroyCommandPool(m_transferCommandPool);
+        if (m_graphicsCommandPool)
+        {
+            m_device.destroyCommandPool(m_graphicsCommandPool);
+        }
+    }
+
+    vk::Buffer UploadBatcher::Stage(const void* data, vk::DeviceSize size)
+    {
+        vk::BufferCreateInfo bufferCreateInfo;
+        bufferCreateInfo.setSize(size);
+        bufferCreateInfo.setUsage(vk::BufferUsageFlagBits::eTransferSrc);
+        bufferCreateInfo.setSharingMode(vk::SharingMode::eExclusive);
+
+        const auto stagingBuffer = m_device.createBuffer(bufferCreateInfo);
+        auto stagingAllocation = m_allocator.AllocateForBuffer(
+            stagingBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            AllocationStrategy::Linear);
+
+        memcpy(stagingAllocation.mappedData, data, static_cast<std::size_t>(size));
+
+        DeferUntilComplete([this, stagingBuffer, stagingAllocation]() mutable {
+            m_device.destroyBuffer(stagingBuffer);
+            m_allocator.Free(stagingAllocation);
+        });
+
+        return stagingBuffer;
+    }
+
+    void UploadBatcher::CopyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size)
+    {
+        vk::BufferCopy copyInfo;
+        copyInfo.setSrcOffset(0);
+        copyInfo.setDstOffset(0);
+        copyInfo.setSize(size);
+
+        GetCommandBuffer().copyBuffer(srcBuffer, dstBuffer, copyInfo);
+
+        if (IsOwnershipTransferRequired())
+        {
+            vk::BufferMemoryBarrier acquireBarrier;
+            acquireBarrier.setDstAccessMask(UPLOAD_CONSUMER_ACCESS);
+            acquireBarrier.setSrcQueueFamilyIndex(m_transferQueueFamilyIndex);
+            acquireBarrier.setDstQueueFamilyIndex(m_graphicsQueueFamilyIndex);
+            acquireBarrier.setBuffer(dstBuffer);
+            acquireBarrier.setOffset(0);
+            acquireBarrier.setSize(VK_WHOLE_SIZE);
+
+            m_recordingBatch.bufferAcquires.push_back(acquireBarrier);
+        }
+    }
+
+    void UploadBatcher::CopyBufferToImage(vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height, uint32_t mipLevel, vk::DeviceSize bufferOffset)
+    {
+        vk::BufferImageCopy region;
+        region.bufferOffset = bufferOffset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+
+        region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+        region.imageSubresource.mipLevel = mipLevel;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+
+        region.imageOffset = vk::Offset3D(0, 0, 0);
+        region.imageExtent = vk::Extent3D(width, height, 1);
+
+        GetCommandBuffer().copyBufferToImage(buffer, image, vk::ImageLayout::eTransferDstOptimal, region);
+    }
+
+    void UploadBatcher::TransitionImageLayout(vk::Image image, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, uint32_t mipLevels)
+    {
+        // Starts the batch first, so the acquire barrier below is stored in the batch being recorded
+        const auto commandBuffer = GetCommandBuffer();
+
+        vk::ImageSubresourceRange subresourceRange;
+        subresourceRange.setAspectMask(vk::ImageAspectFlagBits::eColor);
+        subresourceRange.setBaseMipLevel(0);
+        subresourceRange.setLevelCount(mipLevels);
+        subresourceRange.setBaseArrayLayer(0);
+        subresourceRange.setLayerCount(1);
+
+        vk::ImageMemoryBarrier memoryBarrier;
+        memoryBarrier.setOldLayout(oldLayout);
+        memoryBarrier.setNewLayout(newLayout);
+        memoryBarrier.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+        memoryBarrier.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+        memoryBarrier.setImage(image);
+        memoryBarrier.setSubresourceRange(subresourceRange);
+
+        vk::PipelineStageFlags sourceStage;
+        vk::PipelineStageFlags destinationStage;
+
+        if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eTransferDstOptimal)
+        {
+            memoryBarrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+
+            sourceStage = vk::PipelineStageFlagBits::eTopOfPipe;
+            destinationStage = vk::PipelineStageFlagBits::eTransfer;
+        }
+        else if (oldLayout == vk::ImageLayout::eTransferDstOptimal && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal && IsOwnershipTransferRequired())
+        {
+            // The layout transition is a part of the ownership transfer: the same barrier is released here and acquired by the graphics queue
+            memoryBarrier.setSrcQueueFamilyIndex(m_transferQueueFamilyIndex);
+            memoryBarrier.setDstQueueFamilyIndex(m_graphicsQueueFamilyIndex);
+
+            auto acquireBarrier = memoryBarrier;
+            acquireBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+            m_recordingBatch.imageAcquires.push_back(acquireBarrier);
+
+            memoryBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+
+            sourceStage = vk::PipelineStageFlagBits::eTransfer;
+            destinationStage = vk::PipelineStageFlagBits::eBottomOfPipe;
+        }
+        else if (oldLayout == vk::ImageLayout::eTransferDstOptimal && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal)
+        {
+            memoryBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+            memoryBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+            sourceStage = vk::PipelineStageFlagBits::eTransfer;
+            destinationStage = vk::PipelineStageFlagBits::eFragmentShader;
+        }
+        else
+        {
+            throw std::invalid_argument("Unsupported layout transition!");
+        }
+
+        commandBuffer.pipelineBarrier(sourceStage, destinationStage, {}, {}, {}, memoryBarrier);
+    }
+
+    void UploadBatcher::RecordOnGraphicsQueue(vk::Image image, uint32_t mipLevels, std::function<void(vk::CommandBuffer)> recorder)
+    {
+        const auto commandBuffer = GetCommandBuffer();
+
+        vk::ImageSubresourceRange subresourceRange;
+        subresourceRange.setAspectMask(vk::ImageAspectFlagBits::eColor);
+        subresourceRange.setBaseMipLevel(0);
+        subresourceRange.setLevelCount(mipLevels);
+        subresourceRange.setBaseArrayLayer(0);
+        subresourceRange.setLayerCount(1);
+
+        vk::ImageMemoryBarrier memoryBarrier;
+        memoryBarrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+        memoryBarrier.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
+        memoryBarrier.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+        memoryBarrier.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+        memoryBarrier.setImage(image);
+        memoryBarrier.setSubresourceRange(subresourceRange);
+        memoryBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+
+        if (IsOwnershipTransferRequired())
+        {
+            memoryBarrier.setSrcQueueFamilyIndex(m_transferQueueFamilyIndex);
+            memoryBarrier.setDstQueueFamilyIndex(m_graphicsQueueFamilyIndex);
+
+            auto acquireBarrier = memoryBarrier;
+            acquireBarrier.setSrcAccessMask({});
+            acquireBarrier.setDstAccessMask(GRAPHICS_WORK_ACCESS);
+            m_recordingBatch.imageAcquires.push_back(acquireBarrier);
+
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, {}, memoryBarrier);
+        }
+        else
+        {
+            // The recorder runs in this very command buffer, right after the uploads
+            memoryBarrier.setDstAccessMask(GRAPHICS_WORK_ACCESS);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, GRAPHICS_WORK_STAGES, {}, {}, {}, memoryBarrier);
+        }
+
+        m_recordingBatch.graphicsRecorders.push_back(std::move(recorder));
+    }
+
+    void UploadBatcher::DeferUntilComplete(std::function<void()> callback)
+    {
+        GetCommandBuffer();
+        m_recordingBatch.completionCallbacks.push_back(std::move(callback));
+    }
+
+    UploadToken UploadBatcher::Submit()
+    {
+        if (!m_isRecording)
+        {
+            return m_lastSubmittedToken;
+        }
+
+        if (IsOwnershipTransferRequired())
+        {
+            SubmitWithOwnershipTransfer();
+        }
+        else
+        {
+            // Make all of the copied buffer data visible to the commands submitted after this batch
+            vk::MemoryBarrier memoryBarrier;
+            memoryBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+            memoryBarrier.setDstAccessMask(UPLOAD_CONSUMER_ACCESS);
+            m_recordingBatch.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, UPLOAD_CONSUMER_STAGES, {}, memoryBarrier, {}, {});
+
+            for (const auto& recorder : m_recordingBatch.graphicsRecorders)
+            {
+                recorder(m_recordingBatch.commandBuffer);
+            }
+            m_recordingBatch.graphicsRecorders.clear();
+
+            if (m_profiler != nullptr)
+            {
+                m_profiler->EndScope(m_recordingBatch.commandBuffer, m_recordingBatch.profilerSlot);
+            }
+            m_recordingBatch.commandBuffer.end();
+
+            vk::SubmitInfo submitInfo;
+            submitInfo.setCommandBuffers(m_recordingBatch.commandBuffer);
+            m_transferQueue.submit(submitInfo, m_recordingBatch.fence);
+        }
+
+        m_recordingBatch.token = ++m_lastSubmittedToken;
+        m_submittedBatches.push_back(std::move(m_recordingBatch));
+        m_recordingBatch = Batch();
+        m_isRecording = false;
+
+        return m_lastSubmittedToken;
+    }
+
+    bool UploadBatcher::IsComplete(UploadToken token)
+    {
+        Collect();
+        return token <= m_lastCompletedToken;
+    }
+
+    void UploadBatcher::Wait(UploadToken token)
+    {
+        for (const auto& batch : m_submittedBatches)
+        {
+            if (batch.token > token)
+            {
+                break;
+            }
+
+            VK_CHECK_FENCES_WAIT_RESULT(m_device.waitForFences(batch.fence, VK_TRUE, UINT64_MAX));
+        }
+
+        Collect();
+    }
+
+    void UploadBatcher::WaitAll()
+    {
+        Wait(Submit());
+    }
+
+    void UploadBatcher::Collect()
+    {
+        // Batches are retired in submission order, so a completed token implies all of the previous ones completed as well
+        while (!m_submittedBatches.empty() && m_device.getFenceStatus(m_submittedBatches.front().fence) == vk::Result::eSuccess)
+        {
+            Complete(m_submittedBatches.front());
+            m_submittedBatches.pop_front();
+        }
+    }
+
+    vk::CommandBuffer UploadBatcher::GetCommandBuffer()
+    {
+        if (m_isRecording)
+        {
+            return m_recordingBatch.commandBuffer;
+        }
+
+        if (!m_freeBatches.empty())
+        {
+            m_recordingBatch = std::move(m_freeBatches.back());
+            m_freeBatches.pop_back();
+        }
+        else
+        {
+            const vk::CommandBufferAllocateInfo allocInfo(m_transferCommandPool, vk::CommandBufferLevel::ePrimary, 1);
+            m_recordingBatch.commandBuffer = m_device.allocateCommandBuffers(allocInfo)[0];
+            m_recordingBatch.fence = m_device.createFence(vk::FenceCreateInfo());
+
+            if (IsOwnershipTransferRequired())
+            {
+                const vk::CommandBufferAllocateInfo acquireAllocInfo(m_graphicsCommandPool, vk::CommandBufferLevel::ePrimary, 1);
+                m_recordingBatch.acquireCommandBuffer = m_device.allocateCommandBuffers(acquireAllocInfo)[0];
+                m_recordingBatch.transferFinishedSemaphore = m_device.createSemaphore(vk::SemaphoreCreateInfo());
+            }
+        }
+
+        const vk::CommandBufferBeginInfo beginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+        m_recordingBatch.commandBuffer.begin(beginInfo);
+        m_isRecording = true;
+
+        if (m_profiler != nullptr)
+        {
+            m_recordingBatch.profilerSlot = m_profiler->AcquireSlot();
+            m_profiler->BeginScope(m_recordingBatch.commandBuffer, m_recordingBatch.profilerSlot, UPLOADS_SCOPE);
+        }
+
+        return m_recordingBatch.commandBuffer;
+    }
+
+    void UploadBatcher::Complete(Batch& batch)
+    {
+        for (auto& callback : batch.completionCallbacks)
+        {
+            callback();
+        }
+        batch.completionCallbacks.clear();
+
+        if (m_profiler != nullptr)
+        {
+            m_profiler->Resolve(batch.profilerSlot);
+            m_profiler->ReleaseSlot(batch.profilerSlot);
+            batch.profilerSlot = GpuProfiler::INVALID_SLOT;
+        }
+
+        m_device.resetFences(batch.fence);
+        batch.commandBuffer.reset({});
+        if (batch.acquireCommandBuffer)
+        {
+            batch.acquireCommandBuffer.reset({});
+        }
+        batch.bufferAcquires.clear();
+        batch.imageAcquires.clear();
+        m_lastCompletedToken = batch.token;
+
+        m_freeBatches.push_back(std::move(batch));
+    }
+
+    void UploadBatcher::SubmitWithOwnershipTransfer()
+    {
+        auto& batch = m_recordingBatch;
+
+        // Buffer releases are recorded at the end, image releases were recorded together with their layout transitions
+        std::vector<vk::BufferMemoryBarrier> bufferReleases;
+        for (const auto& acquireBarrier : batch.bufferAcquires)
+        {
+            auto releaseBarrier = acquireBarrier;
+            releaseBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+            releaseBarrier.setDstAccessMask({});
+            bufferReleases.push_back(releaseBarrier);
+        }
+
+        if (!bufferReleases.empty())
+        {
+            batch.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, bufferReleases, {});
+        }
+
+        if (m_profiler != nullptr)
+        {
+            m_profiler->EndScope(batch.commandBuffer, batch.profilerSlot);
+        }
+        batch.commandBuffer.end();
+
+        vk::SubmitInfo transferSubmitInfo;
+        transferSubmitInfo.setCommandBuffers(batch.commandBuffer);
+        transferSubmitInfo.setSignalSemaphores(batch.transferFinishedSemaphore);
+        m_transferQueue.submit(transferSubmitInfo, vk::Fence());
+
+        batch.acquireCommandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+        if (m_profiler != nullptr)
+        {
+            m_profiler->BeginScope(batch.acquireCommandBuffer, batch.profilerSlot, UPLOADS_ACQUIRE_SCOPE);
+        }
+        if (!batch.bufferAcquires.empty() || !batch.imageAcquires.empty())
+        {
+            batch.acquireCommandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, UPLOAD_CONSUMER_STAGES | GRAPHICS_WORK_STAGES, {}, {}, batch.bufferAcquires, batch.imageAcquires);
+        }
+
+        for (const auto& recorder : batch.graphicsRecorders)
+        {
+            recorder(batch.acquireCommandBuffer);
+        }
+        batch.graphicsRecorders.clear();
+
+        if (m_profiler != nullptr)
+        {
+            m_profiler->EndScope(batch.acquireCommandBuffer, batch.profilerSlot);
+        }
+        batch.acquireCommandBuffer.end();
+
+        // The acquiring submission is tiny, so it can simply wait for the transfers with all of its commands
+        const vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
+        vk::SubmitInfo acquireSubmitInfo;
+        acquireSubmitInfo.setWaitSemaphores(batch.transferFinishedSemaphore);
+        acquireSubmitInfo.setWaitDstStageMask(waitStage);
+        acquireSubmitInfo.setCommandBuffers(batch.acquireCommandBuffer);
+        m_graphicsQueue.submit(acquireSubmitInfo, batch.fence);
+    }
+
+    bool UploadBatcher::IsOwnershipTransferRequired() const
+    {
+        return m_transferQueueFamilyIndex != m_graphicsQueueFamilyIndex;
+    }
+} // namespace vr
@@ -1,9 +1,14 @@
 #include "VulkanRenderer/Vulkan/Vulkan.h"
 #include "VulkanRenderer/Paths.h"
+#include "VulkanRenderer/Vulkan/Utils.h"
+#include "VulkanRenderer/Assets/MeshCache.h"
+#include "VulkanRenderer/Assets/ObjLoader.h"
 
 #include <spdlog/spdlog.h>
 #include <glfw/glfw3.h>
+#include <algorithm>
 #include <set>
+#include <unordered_map>
 
 #ifndef GLM_FORCE_RADIANS
     #define GLM_FORCE_RADIANS
@@ -13,23 +18,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <chrono>
-
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <VulkanRenderer/Vendors/tiny_obj_loader.h>
-
-#ifndef VK_CHECK_FENCES_WAIT_RESULT
-    #define VK_CHECK_FENCES_WAIT_RESULT(x)                                                 \
-        {                                                                         \
-            const auto result = x;                                                \
-            if (result != vk::Result::eSuccess && result != vk::Result::eTimeout) \
-            {                                                                     \
-                throw std::runtime_error("Wait for fences error!");               \
-            }                                                                     \
-        }
-#endif
+#include <cmath>
 
 namespace vr
 {
@@ -44,11 +33,16 @@ namespace vr
 #endif
 
     static const std::vector<const char*> VR_REQUIRED_DEVICE_EXTENSIONS = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
         VK_KHR_MAINTENANCE1_EXTENSION_NAME /* Required to be able to set viewport's height to negative value, in order to get NDC with +y facing upwards*/
     };
 
-    static const int MAX_FRAMES_IN_FLIGHT = 2;
+    /** Not required in the headless mode, so that devices and ICDs without presentation support (e.g. lavapipe) can be used */
+    static const std::vector<const char*> VR_PRESENTATION_DEVICE_EXTENSIONS = {
+        VK_KHR_SWAPCHAIN_EXTENSION_NAME
+    };
+
+    /** Size of the uniform ring buffer region available to a single frame */
+    static const vk::DeviceSize UNIFORM_RING_FRAME_SIZE = 64 * 1024;
 
     Vulkan::Vulkan(std::string appName, GLFWwindow* window)
         : m_appName(std::move(appName)), m_window(window)
@@ -67,6 +61,18 @@ namespace vr
         m_dldi.init(vkGetInstanceProcAddr);
     }
 
+    Vulkan::Vulkan(std::string appName, vk::Extent2D offscreenExtent)
+        : Vulkan(std::move(appName), nullptr)
+    {
+        m_isHeadless = true;
+        m_swapChainImagesExtent = offscreenExtent;
+    }
+
+    bool Vulkan::IsHeadless() const
+    {
+        return m_isHeadless;
+    }
+
     void vr::Vulkan::CreateInstance()
     {
         spdlog::info("INSTANCE CREATION STARTED");
@@ -92,6 +98,12 @@ namespace vr
 
     void Vulkan::CreateSurface()
     {
+        if (m_isHeadless)
+        {
+            spdlog::info("SURFACE CREATION SKIPPED IN THE HEADLESS MODE\n");
+            return;
+        }
+
         spdlog::info("SURFACE CREATION STARTED");
         {
             if (glfwCreateWindowSurface(m_instance.get(), m_window, nullptr, reinterpret_cast<VkSurfaceKHR*>(&m_surface)) != VK_SUCCESS)
@@ -113,27 +125,83 @@ namespace vr
             spdlog::info("CHOSING PHYSICAL DEVICE AND QUEUE FAMILIES ENDED\n");
 
             const std::vector<float> queuePriorities = {1.0f};
-            const std::set<uint32_t> queueFamiliesIndices = {m_queueFamilies.graphicsFamily.value(), m_queueFamilies.presentationFamily.value()};
+            const std::set<uint32_t> queueFamiliesIndices = {m_queueFamilies.graphicsFamily.value(), m_queueFamilies.presentationFamily.value(), m_queueFamilies.transferFamily.value()};
             std::vector<vk::DeviceQueueCreateInfo> deviceQueueCreateInfos;
             for (const auto& famillyIndex : queueFamiliesIndices)
             {
                 deviceQueueCreateInfos.push_back(vk::DeviceQueueCreateInfo({}, famillyIndex, queuePriorities));
             }
 
+            // Multi-draw indirect is the GPU-driven rendering fallback for devices without drawIndirectCount.
+            // Indirect draws with a non-zero first instance select the per-instance data of the GPU-driven objects
+            const auto supportedDeviceFeatures = m_physicalDevice.getFeatures();
+            m_isMultiDrawIndirectSupported = supportedDeviceFeatures.multiDrawIndirect == VK_TRUE;
+            m_isDrawIndirectFirstInstanceSupported = supportedDeviceFeatures.drawIndirectFirstInstance == VK_TRUE;
+
             vk::PhysicalDeviceFeatures deviceFeatures;
             deviceFeatures.setSamplerAnisotropy(VK_TRUE);
+            deviceFeatures.setMultiDrawIndirect(m_isMultiDrawIndirectSupported);
+            deviceFeatures.setDrawIndirectFirstInstance(m_isDrawIndirectFirstInstanceSupported);
+            // Compressed textures are uploaded in whichever of the block-compressed format families the device supports
+            deviceFeatures.setTextureCompressionBC(supportedDeviceFeatures.textureCompressionBC);
+            deviceFeatures.setTextureCompressionASTC_LDR(supportedDeviceFeatures.textureCompressionASTC_LDR);
+            deviceFeatures.setTextureCompressionETC2(supportedDeviceFeatures.textureCompressionETC2);
+
+            // Host query reset lets the profiler reset its queries without recording any commands.
+            // Draw indirect count lets the GPU decide how many of the indirect draws are executed.
+            // Descriptor indexing lets every texture be sampled from a single, bindless descriptor array
+            bool isHostQueryResetSupported = false;
+            vk::PhysicalDeviceVulkan12Features vulkan12Features;
+            if (m_physicalDevice.getProperties().apiVersion >= VK_API_VERSION_1_2)
+            {
+                const auto supportedFeatures = m_physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+                const auto& supportedVulkan12Features = supportedFeatures.get<vk::PhysicalDeviceVulkan12Features>();
+                isHostQueryResetSupported = supportedVulkan12Features.hostQueryReset == VK_TRUE;
+                m_isDrawIndirectCountSupported = supportedVulkan12Features.drawIndirectCount == VK_TRUE;
+
+                m_isBindlessSupported = BindlessTextureTable::IsSupported(supportedDeviceFeatures, supportedVulkan12Features);
+
+                vulkan12Features.setHostQueryReset(isHostQueryResetSupported);
+                vulkan12Features.setDrawIndirectCount(m_isDrawIndirectCountSupported);
+                vulkan12Features.setRuntimeDescriptorArray(m_isBindlessSupported);
+                vulkan12Features.setDescriptorBindingPartiallyBound(m_isBindlessSupported);
+                vulkan12Features.setDescriptorBindingSampledImageUpdateAfterBind(m_isBindlessSupported);
+                vulkan12Features.setDescriptorBindingUpdateUnusedWhilePending(m_isBindlessSupported);
+                deviceFeatures.setShaderSampledImageArrayDynamicIndexing(m_isBindlessSupported);
+            }
 
-            const vk::DeviceCreateInfo deviceCreateInfo({}, deviceQueueCreateInfos, {} /*This should be empty*/, VR_REQUIRED_DEVICE_EXTENSIONS, &deviceFeatures);
+            const auto extensions = GetRequiredDeviceExtensions();
+            vk::DeviceCreateInfo deviceCreateInfo({}, deviceQueueCreateInfos, {} /*This should be empty*/, extensions, &deviceFeatures);
+            if (m_physicalDevice.getProperties().apiVersion >= VK_API_VERSION_1_2)
+            {
+                deviceCreateInfo.setPNext(&vulkan12Features);
+            }
             m_logicalDevice = m_physicalDevice.createDeviceUnique(deviceCreateInfo);
 
             m_graphicsQueue = m_logicalDevice->getQueue(m_queueFamilies.graphicsFamily.value(), 0 /* Queue index */);
             m_presentationQueue = m_logicalDevice->getQueue(m_queueFamilies.presentationFamily.value(), 0 /* Queue index */);
+            m_transferQueue = m_logicalDevice->getQueue(m_queueFamilies.transferFamily.value(), 0 /* Queue index */);
+
+            if (m_queueFamilies.transferFamily != m_queueFamilies.graphicsFamily)
+            {
+                spdlog::info("Uploads will use dedicated queue family {}", m_queueFamilies.transferFamily.value());
+            }
+
+            m_allocator = std::make_unique<MemoryAllocator>(m_physicalDevice, m_logicalDevice);
+            m_pipelineCache = std::make_unique<PipelineCache>(m_physicalDevice, m_logicalDevice, PIPELINE_CACHE_PATH);
+            m_gpuProfiler = std::make_unique<GpuProfiler>(m_physicalDevice, m_logicalDevice, isHostQueryResetSupported);
         }
         spdlog::info("DEVICE CREATION ENDED\n");
     }
 
     void Vulkan::CreateSwapChain()
     {
+        if (m_isHeadless)
+        {
+            CreateOffscreenImages();
+            return;
+        }
+
         spdlog::info("SWAP CHAIN CREATION STARTED");
         {
             const auto swapChainSupportDetails = GetSwapChainSupportDetails(m_physicalDevice);
@@ -197,6 +265,8 @@ namespace vr
             swapChainCreateInfo.setPreTransform(swapChainCapabilities.currentTransform);
             swapChainCreateInfo.setPresentMode(presentMode);
             swapChainCreateInfo.setClipped(VK_TRUE);
+            // The presentation engine may reuse the resources of the swap chain being replaced, if any
+            swapChainCreateInfo.setOldSwapchain(m_swapChain);
 
             const auto queueFamilyIndices = m_queueFamilies.List();
             if (m_queueFamilies.graphicsFamily != m_queueFamilies.presentationFamily)
@@ -221,13 +291,42 @@ namespace vr
         spdlog::info("SWAP CHAIN CREATION ENDED\n");
     }
 
+    void Vulkan::CreateOffscreenImages()
+    {
+        spdlog::info("OFFSCREEN IMAGES CREATION STARTED");
+        {
+            m_swapChainImagesFormat = vk::Format::eR8G8B8A8Srgb;
+
+            // Rendered frames can be copied out of the images, e.g. to compare them against reference images
+            const auto usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc;
+
+            m_swapChainImages.resize(OFFSCREEN_IMAGE_COUNT);
+            m_offscreenImageAllocations.resize(OFFSCREEN_IMAGE_COUNT);
+            for (uint32_t i = 0; i < OFFSCREEN_IMAGE_COUNT; ++i)
+            {
+                CreateImage(
+                    m_swapChainImagesExtent.width,
+                    m_swapChainImagesExtent.height,
+                    1,
+                    vk::SampleCountFlagBits::e1,
+                    m_swapChainImagesFormat,
+                    vk::ImageTiling::eOptimal,
+                    usage,
+                    vk::MemoryPropertyFlagBits::eDeviceLocal,
+                    m_swapChainImages[i],
+                    m_offscreenImageAllocations[i]);
+            }
+        }
+        spdlog::info("OFFSCREEN IMAGES CREATION ENDED. CREATED {} {}x{} IMAGES\n", OFFSCREEN_IMAGE_COUNT, m_swapChainImagesExtent.width, m_swapChainImagesExtent.height);
+    }
+
     void Vulkan::CreateImageViews()
     {
         spdlog::info("IMAGE VIEWS CREATION STARTED");
         {
             for (const auto& image : m_swapChainImages)
             {
-                m_swapChainImageViews.push_back(CreateImageView(image, m_swapChainImagesFormat, vk::ImageAspectFlagBits::eColor));
+                m_swapChainImageViews.push_back(CreateImageView(image, m_swapChainImagesFormat, vk::ImageAspectFlagBits::eColor, 1));
             }
         }
         spdlog::info("IMAGE VIEWS CREATION ENDED\n");
@@ -263,7 +362,7 @@ namespace vr
             colorAttachmentResolve.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
             colorAttachmentResolve.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
             colorAttachmentResolve.initialLayout = vk::ImageLayout::eUndefined;
-            colorAttachmentResolve.finalLayout = vk::ImageLayout::ePresentSrcKHR;
+            colorAttachmentResolve.finalLayout = m_isHeadless ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR;
 
             vk::AttachmentReference colorAttachmentResolveRef;
             colorAttachmentResolveRef.attachment = 2;
@@ -299,10 +398,20 @@ namespace vr
 
     void Vulkan::CreateDescriptorSetLayout()
     {
+        /** Textures of the bindless path, in a second set shared by all frames */
+        if (m_isBindlessSupported)
+        {
+            m_bindlessTextureTable = std::make_unique<BindlessTextureTable>(m_physicalDevice, m_logicalDevice);
+        }
+        else
+        {
+            spdlog::info("Descriptor indexing is not supported, textures are bound to every frame's descriptor set");
+        }
+
         /** UBO */
         vk::DescriptorSetLayoutBinding uboLayoutBinding;
         uboLayoutBinding.setBinding(0);
-        uboLayoutBinding.setDescriptorType(vk::DescriptorType::eUniformBuffer);
+        uboLayoutBinding.setDescriptorType(vk::DescriptorType::eUniformBufferDynamic);
         uboLayoutBinding.setDescriptorCount(1);
         uboLayoutBinding.setStageFlags(vk::ShaderStageFlagBits::eVertex);
 
@@ -313,7 +422,12 @@ namespace vr
         samplerLayoutBinding.descriptorType = vk::DescriptorType::eCombinedImageSampler;
         samplerLayoutBinding.stageFlags = vk::ShaderStageFlagBits::eFragment;
 
-        const std::array<vk::DescriptorSetLayoutBinding, 2> bindings = {uboLayoutBinding, samplerLayoutBinding};
+        // The bindless table takes every sampled image the stage may use, so the frame's set has no texture of its own then
+        std::vector<vk::DescriptorSetLayoutBinding> bindings = {uboLayoutBinding};
+        if (!m_bindlessTextureTable)
+        {
+            bindings.push_back(samplerLayoutBinding);
+        }
         vk::DescriptorSetLayoutCreateInfo dslCreateInfo({}, bindings);
 
         m_descriptorSetLayout = m_logicalDevice->createDescriptorSetLayout(dslCreateInfo);
@@ -325,21 +439,31 @@ namespace vr
         {
             spdlog::info("PIPELINE LAYOUT CREATION STARTED");
             {
-                const vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo({}, m_descriptorSetLayout);
+                std::vector<vk::DescriptorSetLayout> setLayouts = {m_descriptorSetLayout};
+                std::vector<vk::PushConstantRange> pushConstantRanges;
+                if (m_bindlessTextureTable)
+                {
+                    setLayouts.push_back(m_bindlessTextureTable->GetDescriptorSetLayout());
+                    pushConstantRanges.emplace_back(vk::ShaderStageFlagBits::eFragment, 0, static_cast<uint32_t>(sizeof(MaterialPushConstants)));
+                }
+
+                const vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo({}, setLayouts, pushConstantRanges);
                 m_pipelineLayout = m_logicalDevice->createPipelineLayout(pipelineLayoutCreateInfo);
             }
             spdlog::info("PIPELINE LAYOUT CREATION ENDED");
 
-            auto bindingDescription = Vertex::getBindingDescription();
-            auto attributeDescriptions = Vertex::getAttributeDescriptions();
+            // The vertex input follows the format of the mesh, which only stores the attributes varying between its vertices
+            const auto& vertexFormat = m_mesh.GetVertexFormat();
+            const auto bindingDescription = vertexFormat.GetBindingDescriptions();
+            const auto attributeDescriptions = vertexFormat.GetAttributeDescriptions();
 
             const vk::PipelineVertexInputStateCreateInfo vertexInputStateInfo({}, bindingDescription, attributeDescriptions);
             const vk::PipelineInputAssemblyStateCreateInfo inputAssemblyStateInfo({}, vk::PrimitiveTopology::eTriangleList, VK_FALSE);
 
-            /** Get viewport state info */
-            m_viewport = vk::Viewport(0.0f, static_cast<float>(m_swapChainImagesExtent.height), static_cast<float>(m_swapChainImagesExtent.width), -static_cast<float>(m_swapChainImagesExtent.height), 0.0f, 1.0f);
-            m_scissors = vk::Rect2D({0, 0}, m_swapChainImagesExtent);
-            const auto viewportState = vk::PipelineViewportStateCreateInfo().setViewports(m_viewport).setScissors(m_scissors);
+            /** Get viewport state info. The viewport and the scissors are set at record time, so the pipeline survives resizes */
+            const auto viewportState = vk::PipelineViewportStateCreateInfo().setViewportCount(1).setScissorCount(1);
+            const std::array<vk::DynamicState, 2> dynamicStates = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+            const vk::PipelineDynamicStateCreateInfo dynamicState({}, dynamicStates);
 
             /** Get resterization state info */
             const auto rasterizationStateInfo =
@@ -378,8 +502,8 @@ namespace vr
                 .setLogicOp(vk::LogicOp::eCopy)
                 .setBlendConstants({0.0f, 0.0f, 0.0f, 0.0f});
 
-            const auto vertexShader = Shader("vert.spv", m_logicalDevice, ShaderType::VR_VERTEX_SHADER);
-            const auto fragmentShader = Shader("frag.spv", m_logicalDevice, ShaderType::VR_FRAGMENT_SHADER);
+            const auto vertexShader = Shader("vert.spv", m_logicalDevice.get(), ShaderType::VR_VERTEX_SHADER);
+            const auto fragmentShader = Shader(m_bindlessTextureTable ? "bindless_frag.spv" : "frag.spv", m_logicalDevice.get(), ShaderType::VR_FRAGMENT_SHADER);
             std::vector<vk::PipelineShaderStageCreateInfo> shaderStagesCreateInfos = {
                 vertexShader.GetPipelineShaderStageInfo(),
                 fragmentShader.GetPipelineShaderStageInfo(),
@@ -401,12 +525,13 @@ namespace vr
                 .setPMultisampleState(&multisampleStateInfo)
                 .setPColorBlendState(&colorBlendState)
                 .setPDepthStencilState(&depthStencilState)
+                .setPDynamicState(&dynamicState)
                 .setStages(shaderStagesCreateInfos)
                 .setLayout(m_pipelineLayout)
                 .setRenderPass(m_renderPass)
                 .setSubpass(0);
 
-            m_pipeline = m_logicalDevice->createGraphicsPipeline({}, pipelineCreateInfo).value;
+            m_pipeline = m_logicalDevice->createGraphicsPipeline(m_pipelineCache->Get(), pipelineCreateInfo).value;
         }
         spdlog::info("PIPELINE CREATION ENDED\n");
     }
@@ -439,134 +564,205 @@ namespace vr
     {
         spdlog::info("COMMAND POOL CREATION STARTED");
         {
-            vk::CommandPoolCreateInfo commandPoolCreateInfo({}, m_queueFamilies.graphicsFamily.value());
-            m_commandPool = m_logicalDevice->createCommandPool(commandPoolCreateInfo);
+            CreateFrameCommandPools();
+
+            m_uploadBatcher = std::make_unique<UploadBatcher>(
+                m_logicalDevice,
+                *m_allocator,
+                m_queueFamilies.transferFamily.value(),
+                m_transferQueue,
+                m_queueFamilies.graphicsFamily.value(),
+                m_graphicsQueue,
+                m_gpuProfiler.get());
+
+            m_mipmapGenerator = std::make_unique<MipmapGenerator>(m_physicalDevice, m_logicalDevice, m_pipelineCache->Get());
+            m_textureStreamer = std::make_unique<TextureStreamer>(m_physicalDevice, m_logicalDevice, *m_allocator, *m_uploadBatcher, *m_mipmapGenerator);
+            m_textureCache = std::make_unique<TextureCache>(*m_textureStreamer, m_bindlessTextureTable.get());
         }
         spdlog::info("COMMAND POOL CREATION ENDED\n");
     }
 
+    void Vulkan::CreateFrameCommandPools()
+    {
+        // Frame command buffers are short lived and never reset one by one, the whole pool is reset instead
+        const vk::CommandPoolCreateInfo commandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eTransient, m_queueFamilies.graphicsFamily.value());
+
+        m_frames.resize(m_framesInFlight);
+        for (auto& frame : m_frames)
+        {
+            frame.commandPool = m_logicalDevice->createCommandPool(commandPoolCreateInfo);
+        }
+    }
+
     void Vulkan::CreateColorResources()
     {
         vk::Format colorFormat = m_swapChainImagesFormat;
 
-        CreateImage(m_swapChainImagesExtent.width, m_swapChainImagesExtent.height, m_msaaSamples, colorFormat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eTransientAttachment | vk::ImageUsageFlagBits::eColorAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, m_colorImage, m_colorImageMemory);
-        m_colorImageView = CreateImageView(m_colorImage, colorFormat, vk::ImageAspectFlagBits::eColor);
+        CreateImage(m_swapChainImagesExtent.width, m_swapChainImagesExtent.height, 1, m_msaaSamples, colorFormat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eTransientAttachment | vk::ImageUsageFlagBits::eColorAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, m_colorImage, m_colorImageAllocation);
+        m_colorImageView = CreateImageView(m_colorImage, colorFormat, vk::ImageAspectFlagBits::eColor, 1);
     }
 
     void Vulkan::CreateDepthResources()
     {
         const auto depthFormat = FindDepthFormat();
-        CreateImage(m_swapChainImagesExtent.width, m_swapChainImagesExtent.height, m_msaaSamples, depthFormat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, m_depthImage, m_depthImageMemory);
-        m_depthImageView = CreateImageView(m_depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth);
+        CreateImage(m_swapChainImagesExtent.width, m_swapChainImagesExtent.height, 1, m_msaaSamples, depthFormat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, m_depthImage, m_depthImageAllocation);
+        m_depthImageView = CreateImageView(m_depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth, 1);
     }
 
     void Vulkan::CreateCommandBuffers()
     {
-        const auto commandBuffersCount = static_cast<uint32_t>(m_swapChainFramebuffers.size());
         spdlog::info("COMMAND BUFFERS CREATION STARTED");
         {
-            const vk::CommandBufferAllocateInfo commandBufferAllocateInfo(m_commandPool, vk::CommandBufferLevel::ePrimary, commandBuffersCount);
-            m_commandBuffers = m_logicalDevice->allocateCommandBuffers(commandBufferAllocateInfo);
+            const bool isGraphicsQueueProfiled = m_gpuProfiler->IsQueueFamilySupported(m_queueFamilies.graphicsFamily.value());
+
+            // Command buffers are recorded every frame, so there is one per frame in flight instead of one per swap chain image
+            for (auto& frame : m_frames)
+            {
+                const vk::CommandBufferAllocateInfo commandBufferAllocateInfo(frame.commandPool, vk::CommandBufferLevel::ePrimary, 1);
+                frame.commandBuffer = m_logicalDevice->allocateCommandBuffers(commandBufferAllocateInfo)[0];
+                frame.profilerSlot = isGraphicsQueueProfiled ? m_gpuProfiler->AcquireSlot() : GpuProfiler::INVALID_SLOT;
+            }
+
+            m_secondaryCommandRecorder = std::make_unique<SecondaryCommandRecorder>(m_logicalDevice, m_queueFamilies.graphicsFamily.value(), m_framesInFlight);
         }
-        spdlog::info("COMMAND BUFFERS CREATION ENDED. CREATED {} CBs\n", commandBuffersCount);
+        spdlog::info("COMMAND BUFFERS CREATION ENDED. CREATED {} CBs\n", m_frames.size());
+    }
 
-        for (uint32_t i = 0; i < commandBuffersCount; ++i)
+    void Vulkan::RecordCommandBuffer(vk::CommandBuffer commandBuffer, uint32_t imageIndex, uint32_t profilerSlot)
+    {
+        const vk::CommandBufferBeginInfo beginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+        commandBuffer.begin(beginInfo);
         {
-            const auto& commandBuffer = m_commandBuffers[i];
+            m_gpuProfiler->BeginScope(commandBuffer, profilerSlot, RENDER_PASS_SCOPE);
+
+            vk::ClearColorValue clearColorValue;
+            clearColorValue.setFloat32({0.0f, 0.0f, 0.0f, 1.0f});
+            vk::ClearDepthStencilValue clearDepthStencilValue(1.0f, 0.0f);
 
-            const vk::CommandBufferBeginInfo beginInfo;
-            commandBuffer.begin(beginInfo);
+            std::array<vk::ClearValue, 2> clearValues = {clearColorValue, clearDepthStencilValue};
+            vk::RenderPassBeginInfo renderPassBeginInfo(
+                m_renderPass,
+                m_swapChainFramebuffers[imageIndex],
+                vk::Rect2D({0, 0}, m_swapChainImagesExtent),
+                clearValues);
+
+            const bool isGpuDriven = IsGpuDrivenRenderingActive();
+            if (isGpuDriven)
             {
-                vk::ClearColorValue clearColorValue;
-                clearColorValue.setFloat32({0.0f, 0.0f, 0.0f, 1.0f});
-                vk::ClearDepthStencilValue clearDepthStencilValue(1.0f, 0.0f);
+                // The whole mesh is drawn once per visible object
+                const vk::DrawIndexedIndirectCommand meshDraw(m_mesh.GetIndexCount(), 1, 0, 0, 0);
+                const auto frustum = Frustum::FromViewProjection(m_mvpUBO.proj * m_mvpUBO.view);
 
-                std::array<vk::ClearValue, 2> clearValues = {clearColorValue, clearDepthStencilValue};
-                vk::RenderPassBeginInfo renderPassBeginInfo(
-                    m_renderPass,
-                    m_swapChainFramebuffers[i],
-                    vk::Rect2D({0, 0}, m_swapChainImagesExtent),
-                    clearValues);
+                m_gpuProfiler->BeginScope(commandBuffer, profilerSlot, CULLING_SCOPE);
+                m_gpuCuller->RecordCulling(commandBuffer, static_cast<uint32_t>(m_currentFrame), frustum, meshDraw);
+                m_gpuProfiler->EndScope(commandBuffer, profilerSlot);
+            }
 
+            const bool isRecordedInParallel = !isGpuDriven && m_isParallelRecordingEnabled && m_drawCommands.size() >= PARALLEL_RECORDING_MIN_DRAWS;
+            if (isGpuDriven)
+            {
                 commandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
-                {
-                    vk::DeviceSize offset = 0;
-
-                    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline);
-                    commandBuffer.bindVertexBuffers(0, m_vertexBuffer, offset);
-                    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout, 0, m_descriptorSets[i], {});
-                    commandBuffer.bindIndexBuffer(m_indexBuffer, 0, vk::IndexType::eUint32);
-                    commandBuffer.drawIndexed(m_indices.size(), 1, 0, 0, 0);
-                }
-                commandBuffer.endRenderPass();
+                BindDrawState(commandBuffer);
+                m_gpuCuller->RecordDraws(commandBuffer, static_cast<uint32_t>(m_currentFrame));
             }
-            commandBuffer.end();
+            else if (isRecordedInParallel)
+            {
+                commandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+
+                const vk::CommandBufferInheritanceInfo inheritanceInfo(m_renderPass, 0, m_swapChainFramebuffers[imageIndex]);
+                const auto secondaryCommandBuffers = m_secondaryCommandRecorder->Record(
+                    static_cast<uint32_t>(m_currentFrame),
+                    inheritanceInfo,
+                    m_drawCommands.size(),
+                    [this](vk::CommandBuffer secondaryCommandBuffer, std::size_t first, std::size_t last) {
+                        RecordDraws(secondaryCommandBuffer, first, last);
+                    });
+
+                commandBuffer.executeCommands(secondaryCommandBuffers);
+            }
+            else
+            {
+                commandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
+                RecordDraws(commandBuffer, 0, m_drawCommands.size());
+            }
+            commandBuffer.endRenderPass();
+
+            m_gpuProfiler->EndScope(commandBuffer, profilerSlot);
         }
+        commandBuffer.end();
     }
 
-    void Vulkan::CreateSyncObjects()
+    void Vulkan::BindDrawState(vk::CommandBuffer commandBuffer) const
     {
-        const vk::SemaphoreCreateInfo semaphoreCreateInfo;
-        const vk::FenceCreateInfo fenceCreateInfo(vk::FenceCreateFlagBits::eSignaled);
-        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+        const auto& frame = m_frames[m_currentFrame];
+
+        // CPU culling copies the visible instances into the frame's own buffer
+        const auto instanceBuffer = IsCpuCullingActive() ? frame.visibleInstanceBuffer : m_instanceBuffer;
+        const std::array<vk::Buffer, 3> vertexBuffers = {m_vertexBuffer, instanceBuffer, m_constantVertexAttributesBuffer};
+        const std::array<vk::DeviceSize, 3> offsets = {0, 0, 0};
+
+        // The viewport is flipped, so that +Y points up as in OpenGL
+        const auto width = static_cast<float>(m_swapChainImagesExtent.width);
+        const auto height = static_cast<float>(m_swapChainImagesExtent.height);
+        const vk::Viewport viewport(0.0f, height, width, -height, 0.0f, 1.0f);
+        const vk::Rect2D scissors({0, 0}, m_swapChainImagesExtent);
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline);
+        commandBuffer.setViewport(0, viewport);
+        commandBuffer.setScissor(0, scissors);
+        commandBuffer.bindVertexBuffers(0, vertexBuffers, offsets);
+        // The UBO has been pushed to the frame's ring buffer region by UpdateUniformBuffer() this very frame
+        const auto uniformOffset = static_cast<uint32_t>(m_mvpUBOOffset);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout, 0, frame.descriptorSet, uniformOffset);
+        commandBuffer.bindIndexBuffer(m_indexBuffer, 0, m_mesh.GetIndexType());
+
+        if (m_bindlessTextureTable)
         {
-            m_imageAvailableSemaphores.push_back(m_logicalDevice->createSemaphore(semaphoreCreateInfo));
-            m_renderFinishedSemaphores.push_back(m_logicalDevice->createSemaphore(semaphoreCreateInfo));
-            m_inFlightFences.push_back(m_logicalDevice->createFence(fenceCreateInfo));
-        }
+            // Every draw samples the model's texture, so the material is pushed once. Draws with other textures only push their own index
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout, 1, m_bindlessTextureTable->GetDescriptorSet(), {});
 
-        m_imagesInFlight.resize(m_swapChainImages.size(), vk::Fence());
+            MaterialPushConstants pushConstants;
+            pushConstants.textureIndex = m_textureCache->GetDescriptorIndex(m_textureId);
+            commandBuffer.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(MaterialPushConstants), &pushConstants);
+        }
     }
 
-    void Vulkan::CreateTextureImage()
+    void Vulkan::RecordDraws(vk::CommandBuffer commandBuffer, std::size_t first, std::size_t last) const
     {
-        int texWidth, texHeight, texChannels;
-        stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-        vk::DeviceSize imageSize = static_cast<vk::DeviceSize>(texWidth) * texHeight * 4;
+        // Secondary command buffers do not inherit any state, so every one of them binds everything on its own
+        BindDrawState(commandBuffer);
 
-        if (!pixels)
+        const bool isCpuCulled = IsCpuCullingActive();
+        if (isCpuCulled && m_visibleInstanceCount == 0)
         {
-            throw std::runtime_error("failed to load texture image!");
+            return;
         }
 
-        vk::Buffer imageStagingBuffer;
-        vk::DeviceMemory imageStagingBufferMemory;
-
-        CreateBuffer(
-            imageSize,
-            vk::BufferUsageFlagBits::eTransferSrc,
-            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-            imageStagingBuffer,
-            imageStagingBufferMemory);
-
-        void* data = m_logicalDevice->mapMemory(imageStagingBufferMemory, 0, imageSize);
-        memcpy(data, pixels, static_cast<std::size_t>(imageSize));
-        m_logicalDevice->unmapMemory(imageStagingBufferMemory);
-
-        stbi_image_free(pixels);
-
-        CreateImage(
-            texWidth,
-            texHeight,
-            vk::SampleCountFlagBits::e1,
-            vk::Format::eR8G8B8A8Srgb,
-            vk::ImageTiling::eOptimal,
-            vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
-            vk::MemoryPropertyFlagBits::eDeviceLocal,
-            m_textureImage,
-            m_textureImageMemory);
-
-        TransitionImageLayout(m_textureImage, vk::Format::eR8G8B8A8Srgb, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
-        CopyBufferToImage(imageStagingBuffer, m_textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-        TransitionImageLayout(m_textureImage, vk::Format::eR8G8B8A8Srgb, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const auto& draw = m_drawCommands[i];
+            const auto instanceCount = isCpuCulled ? m_visibleInstanceCount : draw.instanceCount;
+            commandBuffer.drawIndexed(draw.indexCount, instanceCount, draw.firstIndex, draw.vertexOffset, draw.firstInstance);
+        }
+    }
 
-        m_logicalDevice->freeMemory(imageStagingBufferMemory);
-        m_logicalDevice->destroyBuffer(imageStagingBuffer);
+    void Vulkan::CreateSyncObjects()
+    {
+        const vk::SemaphoreCreateInfo semaphoreCreateInfo;
+        const vk::FenceCreateInfo fenceCreateInfo(vk::FenceCreateFlagBits::eSignaled);
+        for (auto& frame : m_frames)
+        {
+            frame.imageAvailableSemaphore = m_logicalDevice->createSemaphore(semaphoreCreateInfo);
+            frame.renderFinishedSemaphore = m_logicalDevice->createSemaphore(semaphoreCreateInfo);
+            frame.inFlightFence = m_logicalDevice->createFence(fenceCreateInfo);
+            frame.submissionNumber = 0;
+        }
     }
 
-    void Vulkan::CreateTextureImageView()
+    void Vulkan::CreateTextureImage()
     {
-        m_textureImageView = CreateImageView(m_textureImage, vk::Format::eR8G8B8A8Srgb, vk::ImageAspectFlagBits::eColor);
+        // Frames sample the placeholder until the texture is decoded and uploaded in the background
+        m_textureId = m_textureCache->Acquire(TEXTURE_PATH);
     }
 
     void Vulkan::CreateTextureSampler()
@@ -580,22 +776,53 @@ namespace vr
         samplerInfo.setAnisotropyEnable(VK_TRUE);
         samplerInfo.setMaxAnisotropy(16.0f);
         samplerInfo.setUnnormalizedCoordinates(VK_FALSE);
+        samplerInfo.setMipmapMode(vk::SamplerMipmapMode::eLinear);
+        samplerInfo.setMipLodBias(0.0f);
+        samplerInfo.setMinLod(0.0f);
+        // Streamed textures come with any number of levels
+        samplerInfo.setMaxLod(VK_LOD_CLAMP_NONE);
 
         m_textureSampler = m_logicalDevice->createSampler(samplerInfo);
+
+        if (m_bindlessTextureTable)
+        {
+            m_bindlessTextureTable->SetSampler(m_textureSampler);
+        }
     }
 
     void Vulkan::LoadModel()
     {
+        const MeshCache meshCache(MODEL_PATH);
+        if (auto cachedMesh = meshCache.Load())
+        {
+            m_mesh = std::move(*cachedMesh);
+            spdlog::info("Model loaded from '{}': {} vertices, {} indices", meshCache.GetCachePath(), m_mesh.GetVertexCount(), m_mesh.GetIndexCount());
+
+            return;
+        }
+
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn, err;
 
-        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, MODEL_PATH.c_str()))
+        const ObjLoader objLoader;
+        objLoader.Load(MODEL_PATH, attrib, shapes);
+
+        size_t indicesCount = 0;
+        for (const auto& shape : shapes)
         {
-            throw std::runtime_error(warn + err);
+            indicesCount += shape.mesh.indices.size();
         }
 
+        // OBJ faces reference positions and UVs separately, so identical corners shared by neighbouring faces
+        // are welded back together here. Each unique vertex is stored once and referenced by the index buffer
+        std::unordered_map<Vertex, uint32_t> uniqueVertices;
+        uniqueVertices.reserve(indicesCount);
+
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        vertices.reserve(indicesCount);
+        indices.reserve(indicesCount);
+
         for (const auto& shape : shapes)
         {
             for (const auto& index : shape.mesh.indices)
@@ -610,82 +837,180 @@ namespace vr
                     attrib.texcoords[2 * index.texcoord_index + 0],
                     attrib.texcoords[2 * index.texcoord_index + 1]};
 
-                vertex.color = {1.0f, 1.0f, 1.0f};
+                vertex.color = {
+                    attrib.colors[3 * index.vertex_index + 0],
+                    attrib.colors[3 * index.vertex_index + 1],
+                    attrib.colors[3 * index.vertex_index + 2]};
+
+                // Normals are not loaded until a shader shades with them: as a part of the vertex identity they only
+                // keep vertices from being welded, and the constant normal takes no space in the packed vertices
+
+                const auto [vertexIt, isNew] = uniqueVertices.try_emplace(vertex, static_cast<uint32_t>(vertices.size()));
+                if (isNew)
+                {
+                    vertices.push_back(vertex);
+                }
 
-                m_vertices.push_back(vertex);
-                m_indices.push_back(m_indices.size());
+                indices.push_back(vertexIt->second);
             }
         }
+
+        m_mesh = Mesh(vertices, indices);
+
+        spdlog::info(
+            "Model loaded: {} unique vertices out of {} indices, {}-bit indices, {}-byte vertices",
+            m_mesh.GetVertexCount(),
+            m_mesh.GetIndexCount(),
+            m_mesh.GetIndexType() == vk::IndexType::eUint16 ? 16 : 32,
+            m_mesh.GetVertexFormat().GetStride());
+
+        meshCache.Store(m_mesh);
+    }
+
+    UploadToken Vulkan::FlushUploads()
+    {
+        return m_uploadBatcher->Submit();
+    }
+
+    void Vulkan::WaitForUploads()
+    {
+        m_textureStreamer->WaitIdle();
+        m_uploadBatcher->WaitAll();
     }
 
     void Vulkan::DrawFrame()
     {
-        VK_CHECK_FENCES_WAIT_RESULT(m_logicalDevice->waitForFences(m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX));
+        const auto frameStartTime = std::chrono::high_resolution_clock::now();
+        std::chrono::high_resolution_clock::duration waitDuration(0);
+
+        // Anything recorded since the last frame is submitted ahead of the frame, so the queue order makes it visible to it
+        m_textureStreamer->Update();
+        FlushUploads();
+        m_uploadBatcher->Collect();
+
+        auto& frame = m_frames[m_currentFrame];
+
+        const auto waitStartTime = std::chrono::high_resolution_clock::now();
+        VK_CHECK_FENCES_WAIT_RESULT(m_logicalDevice->waitForFences(frame.inFlightFence, VK_TRUE, UINT64_MAX));
+        waitDuration += std::chrono::high_resolution_clock::now() - waitStartTime;
 
-        auto& imageAvailableSemaphore = m_imageAvailableSemaphores[m_currentFrame];
-        auto& renderFinishedSemaphore = m_renderFinishedSemaphores[m_currentFrame];
+        // A signaled fence means every earlier submission to the queue has completed as well
+        m_completedFrameCount = std::max(m_completedFrameCount, frame.submissionNumber);
+        ReleaseRetiredSwapChains();
+        m_textureCache->Collect(m_completedFrameCount);
 
-        uint32_t imageIndex;
-        try
+        // The frame's descriptor set is not in use anymore, so it can pick up the textures streamed in since its last submission
+        if (!m_bindlessTextureTable && frame.boundTextureView != GetTextureView())
         {
-            imageIndex = m_logicalDevice->acquireNextImageKHR(m_swapChain, UINT64_MAX, imageAvailableSemaphore, {});
+            WriteTextureDescriptor(frame);
         }
-        catch (const std::exception& ex)
+
+        // The previous submission of this frame has completed, so its timestamps are available
+        m_gpuProfiler->Resolve(frame.profilerSlot);
+
+        // Every resource the frame writes belongs to its context, so only the image itself is shared with other frames.
+        // Offscreen images are cycled the way a presentation engine would, and the queue order keeps frames from overlapping in them
+        auto imageIndex = static_cast<uint32_t>(m_submittedFrameCount % OFFSCREEN_IMAGE_COUNT);
+        if (!m_isHeadless)
         {
-            RecreateSwapChain();
-            return;
+            try
+            {
+                imageIndex = m_logicalDevice->acquireNextImageKHR(m_swapChain, UINT64_MAX, frame.imageAvailableSemaphore, {});
+            }
+            catch (const std::exception& ex)
+            {
+                RecreateSwapChain();
+                return;
+            }
         }
 
-        if (m_imagesInFlight[imageIndex])
+        UpdateUniformBuffer(static_cast<uint32_t>(m_currentFrame));
+        if (IsCpuCullingActive())
         {
-            VK_CHECK_FENCES_WAIT_RESULT(m_logicalDevice->waitForFences(m_imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX));
+            CullInstances();
         }
-        m_imagesInFlight[imageIndex] = m_inFlightFences[m_currentFrame];
 
-        UpdateUniformBuffer(imageIndex);
+        // Resetting the pool recycles the memory of all of its command buffers at once
+        m_logicalDevice->resetCommandPool(frame.commandPool, {});
+        const auto commandBuffer = frame.commandBuffer;
+        RecordCommandBuffer(commandBuffer, imageIndex, frame.profilerSlot);
 
         const std::vector<vk::PipelineStageFlags> waitStages = {vk::PipelineStageFlagBits::eColorAttachmentOutput};
         vk::SubmitInfo submitInfo;
-        submitInfo
-            .setWaitSemaphores(imageAvailableSemaphore)
-            .setWaitDstStageMask(waitStages)
-            .setCommandBuffers(m_commandBuffers[imageIndex])
-            .setSignalSemaphores(renderFinishedSemaphore);
+        submitInfo.setCommandBuffers(commandBuffer);
+        if (!m_isHeadless)
+        {
+            submitInfo
+                .setWaitSemaphores(frame.imageAvailableSemaphore)
+                .setWaitDstStageMask(waitStages)
+                .setSignalSemaphores(frame.renderFinishedSemaphore);
+        }
 
-        m_logicalDevice->resetFences(m_inFlightFences[m_currentFrame]);
-        m_graphicsQueue.submit(submitInfo, m_inFlightFences[m_currentFrame]);
+        m_logicalDevice->resetFences(frame.inFlightFence);
+        m_graphicsQueue.submit(submitInfo, frame.inFlightFence);
+        frame.submissionNumber = ++m_submittedFrameCount;
+        m_textureCache->Touch(m_textureId, frame.submissionNumber);
 
-        try
+        if (!m_isHeadless)
         {
-            const vk::PresentInfoKHR presentInfo(renderFinishedSemaphore, m_swapChain, imageIndex);
-            if (m_presentationQueue.presentKHR(presentInfo) == vk::Result::eSuboptimalKHR || m_shouldResizeFramebuffer)
+            try
+            {
+                const vk::PresentInfoKHR presentInfo(frame.renderFinishedSemaphore, m_swapChain, imageIndex);
+                if (m_presentationQueue.presentKHR(presentInfo) == vk::Result::eSuboptimalKHR || m_shouldResizeFramebuffer)
+                {
+                    m_shouldResizeFramebuffer = false;
+                    RecreateSwapChain();
+                }
+            }
+            catch (const std::exception& ex)
             {
-                m_shouldResizeFramebuffer = false;
                 RecreateSwapChain();
             }
         }
-        catch (const std::exception& ex)
+
+        m_currentFrame = (m_currentFrame + 1) % m_frames.size();
+
+        const auto frameDuration = std::chrono::high_resolution_clock::now() - frameStartTime;
+        m_gpuProfiler->AddCpuSample(DRAW_FRAME_SCOPE, std::chrono::duration<double, std::milli>(frameDuration).count());
+        m_gpuProfiler->AddCpuSample(DRAW_FRAME_WAIT_SCOPE, std::chrono::duration<double, std::milli>(waitDuration).count());
+
+        if (m_profilerReportInterval != 0 && ++m_profiledFramesCount >= m_profilerReportInterval)
         {
-            RecreateSwapChain();
+            LogProfilerStatistics();
+            m_gpuProfiler->ResetStatistics();
+            m_profiledFramesCount = 0;
         }
-
-        m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
     }
 
-    void Vulkan::UpdateUniformBuffer(uint32_t currentImage)
+    void Vulkan::UpdateUniformBuffer(uint32_t frameIndex)
     {
         static auto startTime = std::chrono::high_resolution_clock::now();
 
-        const auto currentTime = std::chrono::high_resolution_clock::now();
-        const auto time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+        float time = m_animationTime;
+        if (m_fixedTimeStep > 0.0f)
+        {
+            m_animationTime += m_fixedTimeStep;
+        }
+        else
+        {
+            const auto currentTime = std::chrono::high_resolution_clock::now();
+            time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+        }
 
         m_mvpUBO.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        m_mvpUBO.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        m_mvpUBO.proj = glm::perspective(glm::radians(45.0f), m_swapChainImagesExtent.width / (float)m_swapChainImagesExtent.height, 0.1f, 10.0f);
-
-        void* data = m_logicalDevice->mapMemory(m_uniformBuffersMemory[currentImage], 0, sizeof(m_mvpUBO));
-        memcpy(data, &m_mvpUBO, sizeof(m_mvpUBO));
-        m_logicalDevice->unmapMemory(m_uniformBuffersMemory[currentImage]);
+        m_mvpUBO.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f) * m_cameraDistanceScale, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        m_mvpUBO.proj = glm::perspective(
+            glm::radians(45.0f),
+            m_swapChainImagesExtent.width / (float)m_swapChainImagesExtent.height,
+            0.1f * m_cameraDistanceScale,
+            10.0f * m_cameraDistanceScale);
+
+        const auto& bounds = m_mesh.GetBounds();
+        m_mvpUBO.positionOffset = glm::vec4(bounds.min, 0.0f);
+        m_mvpUBO.positionScale = glm::vec4(bounds.max - bounds.min, 0.0f);
+
+        m_uniformRingBuffer->BeginFrame(frameIndex);
+        m_mvpUBOOffset = m_uniformRingBuffer->Push(m_mvpUBO).offset;
     }
 
     void Vulkan::WaitForDevice()
@@ -693,8 +1018,20 @@ namespace vr
         m_logicalDevice->waitIdle();
     }
 
+    void Vulkan::SetFixedTimeStep(float seconds)
+    {
+        m_fixedTimeStep = seconds;
+        m_animationTime = 0.0f;
+    }
+
     void Vulkan::RecreateSwapChain()
     {
+        if (m_isHeadless)
+        {
+            // Offscreen images never go out of date
+            return;
+        }
+
         int width = 0, height = 0;
         glfwGetFramebufferSize(m_window, &width, &height);
         while (width == 0 || height == 0)
@@ -703,20 +1040,51 @@ namespace vr
             glfwWaitEvents();
         }
 
-        WaitForDevice();
-        CleanupSwapChain();
+        // Frames in flight may still use the replaced resources, so they are retired instead of waiting for the device to idle
+        RetiredSwapChain retiredSwapChain;
+        retiredSwapChain.lastSubmission = m_submittedFrameCount;
+        retiredSwapChain.swapChain = m_swapChain;
+        retiredSwapChain.imageViews = std::move(m_swapChainImageViews);
+        retiredSwapChain.framebuffers = std::move(m_swapChainFramebuffers);
+        m_swapChainImageViews.clear();
+        m_swapChainFramebuffers.clear();
+
+        const auto previousImagesFormat = m_swapChainImagesFormat;
+        const auto previousImagesExtent = m_swapChainImagesExtent;
 
         CreateSwapChain();
         CreateImageViews();
-        CreateRenderPass();
-        CreateGraphicsPipeline();
-        CreateColorResources();
-        CreateDepthResources();
+
+        // The viewport and the scissors are dynamic, so the render pass and the pipeline only depend on the images format
+        const bool hasFormatChanged = m_swapChainImagesFormat != previousImagesFormat;
+        if (hasFormatChanged)
+        {
+            retiredSwapChain.pipeline = m_pipeline;
+            retiredSwapChain.pipelineLayout = m_pipelineLayout;
+            retiredSwapChain.renderPass = m_renderPass;
+
+            CreateRenderPass();
+            CreateGraphicsPipeline();
+        }
+
+        if (hasFormatChanged || m_swapChainImagesExtent != previousImagesExtent)
+        {
+            retiredSwapChain.colorImage = m_colorImage;
+            retiredSwapChain.colorImageAllocation = m_colorImageAllocation;
+            retiredSwapChain.colorImageView = m_colorImageView;
+            retiredSwapChain.depthImage = m_depthImage;
+            retiredSwapChain.depthImageAllocation = m_depthImageAllocation;
+            retiredSwapChain.depthImageView = m_depthImageView;
+
+            CreateColorResources();
+            CreateDepthResources();
+        }
+
+        // Framebuffers refer to the new image views, so they are always recreated.
+        // Frame contexts do not depend on the swap chain at all, so they are kept as they are
         CreateFramebuffers();
-        CreateUniformBuffers();
-        CreateDescriptorPool();
-        CreateDescriptorSets();
-        CreateCommandBuffers();
+
+        m_retiredSwapChains.push_back(std::move(retiredSwapChain));
     }
 
     void Vulkan::ResizeFramebuffers()
@@ -724,120 +1092,464 @@ namespace vr
         m_shouldResizeFramebuffer = true;
     }
 
+    AllocatorStatistics Vulkan::GetMemoryStatistics() const
+    {
+        return m_allocator->GetStatistics();
+    }
+
+    void Vulkan::LogMemoryStatistics() const
+    {
+        m_allocator->LogStatistics();
+    }
+
+    std::string Vulkan::GetDeviceName() const
+    {
+        return m_physicalDevice.getProperties().deviceName;
+    }
+
+    GpuProfiler& Vulkan::GetProfiler()
+    {
+        return *m_gpuProfiler;
+    }
+
+    void Vulkan::SetProfilerReportInterval(uint32_t framesCount)
+    {
+        m_profilerReportInterval = framesCount;
+        m_profiledFramesCount = 0;
+    }
+
+    void Vulkan::SetTextureBudget(vk::DeviceSize budget)
+    {
+        m_textureCache->SetBudget(budget);
+    }
+
+    TextureCacheStatistics Vulkan::GetTextureCacheStatistics() const
+    {
+        return m_textureCache->GetStatistics();
+    }
+
+    void Vulkan::LogProfilerStatistics() const
+    {
+        m_gpuProfiler->LogStatistics();
+
+        const auto* drawFrame = m_gpuProfiler->FindStatistics(DRAW_FRAME_SCOPE, false);
+        const auto* drawFrameWait = m_gpuProfiler->FindStatistics(DRAW_FRAME_WAIT_SCOPE, false);
+        const auto* renderPass = m_gpuProfiler->FindStatistics(RENDER_PASS_SCOPE, true);
+        if (drawFrame == nullptr || drawFrameWait == nullptr || renderPass == nullptr)
+        {
+            return;
+        }
+
+        // Time spent blocked on fences is the time the CPU waited for the GPU, so it does not count as CPU work
+        const double cpuMilliseconds = drawFrame->GetAverageMilliseconds() - drawFrameWait->GetAverageMilliseconds();
+        const double gpuMilliseconds = renderPass->GetAverageMilliseconds();
+        spdlog::info(
+            "Frames are {}: {:.3f} ms of CPU work and {:.3f} ms of GPU work per frame",
+            gpuMilliseconds > cpuMilliseconds ? "GPU-bound" : "CPU-bound",
+            cpuMilliseconds,
+            gpuMilliseconds);
+    }
+
     void Vulkan::CreateVertexBuffer()
     {
-        const vk::DeviceSize bufferSize = sizeof(Vertex) * m_vertices.size();
+        const vk::DeviceSize bufferSize = m_mesh.GetVertexDataSize();
 
-        vk::Buffer stagingBuffer;
-        vk::DeviceMemory stagingBufferMemory;
-        CreateBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer, stagingBufferMemory);
+        const auto stagingBuffer = m_uploadBatcher->Stage(m_mesh.GetVertexData(), bufferSize);
 
-        void* bufferData = m_logicalDevice->mapMemory(stagingBufferMemory, 0, bufferSize);
-        memcpy(bufferData, m_vertices.data(), static_cast<std::size_t>(bufferSize));
-        m_logicalDevice->unmapMemory(stagingBufferMemory);
+        CreateBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, m_vertexBuffer, m_vertexBufferAllocation);
+        m_uploadBatcher->CopyBuffer(stagingBuffer, m_vertexBuffer, bufferSize);
 
-        CreateBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, m_vertexBuffer, m_vertexBufferMemory);
-        CopyBuffer(stagingBuffer, m_vertexBuffer, bufferSize);
+        const auto& constants = m_mesh.GetVertexFormat().constants;
+        const vk::DeviceSize constantsSize = sizeof(constants);
+        const auto constantsStagingBuffer = m_uploadBatcher->Stage(&constants, constantsSize);
 
-        m_logicalDevice->freeMemory(stagingBufferMemory);
-        m_logicalDevice->destroyBuffer(stagingBuffer);
+        CreateBuffer(
+            constantsSize,
+            vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
+            vk::MemoryPropertyFlagBits::eDeviceLocal,
+            m_constantVertexAttributesBuffer,
+            m_constantVertexAttributesBufferAllocation);
+        m_uploadBatcher->CopyBuffer(constantsStagingBuffer, m_constantVertexAttributesBuffer, constantsSize);
     }
 
     void Vulkan::CreateIndexBuffer()
     {
-        const vk::DeviceSize bufferSize = sizeof(m_indices[0]) * m_indices.size();
+        const vk::DeviceSize bufferSize = m_mesh.GetIndexDataSize();
+
+        const auto stagingBuffer = m_uploadBatcher->Stage(m_mesh.GetIndexData(), bufferSize);
+
+        CreateBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, m_indexBuffer, m_indexBufferAllocation);
+        m_uploadBatcher->CopyBuffer(stagingBuffer, m_indexBuffer, bufferSize);
+
+        SetDrawCount(1);
+    }
+
+    void Vulkan::CreateInstanceBuffer()
+    {
+        // Instances are laid out on a square grid in the XY plane, centered at the origin
+        const auto gridSide = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(m_instanceCount))));
+        const auto& bounds = m_mesh.GetBounds();
+        const float spacing = INSTANCE_GRID_SPACING * std::max(bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y);
+        const float gridOrigin = -0.5f * spacing * static_cast<float>(gridSide - 1);
+
+        std::vector<InstanceData> instances(m_instanceCount);
+        for (uint32_t instance = 0; instance < m_instanceCount; ++instance)
+        {
+            const glm::vec3 position(gridOrigin + spacing * static_cast<float>(instance % gridSide), gridOrigin + spacing * static_cast<float>(instance / gridSide), 0.0f);
+            instances[instance].model = glm::translate(glm::mat4(1.0f), position);
+        }
+        m_cameraDistanceScale = gridSide > 1 ? INSTANCE_GRID_SPACING * static_cast<float>(gridSide) : 1.0f;
+
+        const vk::DeviceSize bufferSize = instances.size() * sizeof(InstanceData);
+
+        const auto stagingBuffer = m_uploadBatcher->Stage(instances.data(), bufferSize);
+
+        // Instances are read as a storage buffer by the GPU culling as well
+        const auto instanceBufferUsage = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer;
+        CreateBuffer(bufferSize, instanceBufferUsage, vk::MemoryPropertyFlagBits::eDeviceLocal, m_instanceBuffer, m_instanceBufferAllocation);
+        m_uploadBatcher->CopyBuffer(stagingBuffer, m_instanceBuffer, bufferSize);
+
+        // The sphere is centered at the model's origin, so it keeps bounding the model while it spins around the origin
+        const auto& boundingSphere = m_mesh.GetBoundingSphere();
+        const float boundingRadius = glm::length(boundingSphere.center) + boundingSphere.radius;
+        const std::vector<glm::vec4> objectBounds(m_instanceCount, glm::vec4(0.0f, 0.0f, 0.0f, boundingRadius));
+        const vk::DeviceSize boundsBufferSize = objectBounds.size() * sizeof(glm::vec4);
+
+        const auto boundsStagingBuffer = m_uploadBatcher->Stage(objectBounds.data(), boundsBufferSize);
+
+        CreateBuffer(boundsBufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, m_objectBoundsBuffer, m_objectBoundsBufferAllocation);
+        m_uploadBatcher->CopyBuffer(boundsStagingBuffer, m_objectBoundsBuffer, boundsBufferSize);
+
+        if (m_gpuCuller)
+        {
+            m_gpuCuller->SetObjects(m_instanceBuffer, m_objectBoundsBuffer, m_instanceCount);
+        }
+
+        // The instances are only translated, so their world space spheres are centered at their positions
+        m_frustumCuller.Clear();
+        m_frustumCuller.Reserve(instances.size());
+        for (const auto& instance : instances)
+        {
+            m_frustumCuller.AddSphere(glm::vec3(instance.model[3]), boundingRadius);
+        }
+        m_instances = std::move(instances);
+
+        if (m_isCpuCullingEnabled)
+        {
+            CreateVisibleInstanceBuffers();
+        }
+
+        for (auto& drawCommand : m_drawCommands)
+        {
+            drawCommand.instanceCount = m_instanceCount;
+        }
+
+        spdlog::info("Model will be drawn {} times, on a {}x{} grid", m_instanceCount, gridSide, gridSide);
+    }
+
+    void Vulkan::SetInstanceCount(uint32_t instanceCount)
+    {
+        instanceCount = std::max(instanceCount, 1u);
+        if (instanceCount == m_instanceCount)
+        {
+            return;
+        }
+        m_instanceCount = instanceCount;
 
-        vk::Buffer stagingBuffer;
-        vk::DeviceMemory stagingBufferMemory;
-        CreateBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer, stagingBufferMemory);
+        if (m_instanceBuffer)
+        {
+            // Frames in flight might still read the instances
+            WaitForDevice();
+            DestroyBuffer(m_instanceBuffer, m_instanceBufferAllocation);
+            DestroyBuffer(m_objectBoundsBuffer, m_objectBoundsBufferAllocation);
+            DestroyVisibleInstanceBuffers();
+            CreateInstanceBuffer();
+        }
+    }
 
-        void* bufferData = m_logicalDevice->mapMemory(stagingBufferMemory, 0, bufferSize);
-        memcpy(bufferData, m_indices.data(), static_cast<std::size_t>(bufferSize));
-        m_logicalDevice->unmapMemory(stagingBufferMemory);
+    void Vulkan::SetGpuDrivenRenderingEnabled(bool isEnabled)
+    {
+        m_isGpuDrivenRenderingEnabled = isEnabled;
+        if (isEnabled && !m_gpuCuller)
+        {
+            m_gpuCuller = std::make_unique<GpuCuller>(
+                m_physicalDevice,
+                m_logicalDevice,
+                *m_allocator,
+                m_pipelineCache->Get(),
+                m_framesInFlight,
+                m_isDrawIndirectCountSupported,
+                m_isMultiDrawIndirectSupported,
+                m_isDrawIndirectFirstInstanceSupported);
+
+            if (m_instanceBuffer)
+            {
+                m_gpuCuller->SetObjects(m_instanceBuffer, m_objectBoundsBuffer, m_instanceCount);
+            }
+        }
 
-        CreateBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, m_indexBuffer, m_indexBufferMemory);
-        CopyBuffer(stagingBuffer, m_indexBuffer, bufferSize);
+        if (isEnabled && !m_gpuCuller->CanDraw(m_instanceCount))
+        {
+            spdlog::warn("{} objects cannot be drawn indirectly by this device, draws will be recorded by the CPU", m_instanceCount);
+        }
+    }
 
-        m_logicalDevice->freeMemory(stagingBufferMemory);
-        m_logicalDevice->destroyBuffer(stagingBuffer);
+    bool Vulkan::IsGpuDrivenRenderingActive() const
+    {
+        return m_isGpuDrivenRenderingEnabled && m_gpuCuller && m_gpuCuller->CanDraw(m_instanceCount);
     }
 
-    void Vulkan::CreateUniformBuffers()
+    void Vulkan::SetCpuCullingEnabled(bool isEnabled)
+    {
+        m_isCpuCullingEnabled = isEnabled;
+        if (isEnabled && !m_frames.front().visibleInstanceBuffer && m_instanceBuffer)
+        {
+            CreateVisibleInstanceBuffers();
+        }
+
+        if (isEnabled)
+        {
+            spdlog::info("Instances will be culled on the CPU with the {} backend", FrustumCuller::GetBackendName(m_frustumCuller.GetBackend()));
+        }
+    }
+
+    bool Vulkan::IsCpuCullingActive() const
+    {
+        // GPU culling takes precedence, as it does not need the CPU at all
+        return m_isCpuCullingEnabled && m_frames[m_currentFrame].visibleInstanceBuffer && !IsGpuDrivenRenderingActive();
+    }
+
+    void Vulkan::CullInstances()
     {
-        const vk::DeviceSize bufferSize = sizeof(m_mvpUBO);
-        const auto numberOfUBOs = m_swapChainImages.size();
+        const auto cullingStartTime = std::chrono::high_resolution_clock::now();
 
-        m_uniformBuffers.resize(numberOfUBOs);
-        m_uniformBuffersMemory.resize(numberOfUBOs);
+        const auto frustum = Frustum::FromViewProjection(m_mvpUBO.proj * m_mvpUBO.view);
+        m_frustumCuller.Cull(frustum, m_visibleInstances);
 
-        for (std::size_t i = 0; i < numberOfUBOs; ++i)
+        // The frame's buffer is not used by the GPU anymore, as the frame's fence has been waited for
+        auto* visibleInstances = static_cast<InstanceData*>(m_frames[m_currentFrame].visibleInstanceAllocation.mappedData);
+        for (std::size_t i = 0; i < m_visibleInstances.size(); ++i)
+        {
+            visibleInstances[i] = m_instances[m_visibleInstances[i]];
+        }
+        m_visibleInstanceCount = static_cast<uint32_t>(m_visibleInstances.size());
+
+        const auto cullingDuration = std::chrono::high_resolution_clock::now() - cullingStartTime;
+        m_gpuProfiler->AddCpuSample(CULLING_SCOPE, std::chrono::duration<double, std::milli>(cullingDuration).count());
+    }
+
+    void Vulkan::CreateVisibleInstanceBuffers()
+    {
+        const vk::DeviceSize bufferSize = m_instances.size() * sizeof(InstanceData);
+
+        for (auto& frame : m_frames)
         {
             CreateBuffer(
                 bufferSize,
-                vk::BufferUsageFlagBits::eUniformBuffer,
+                vk::BufferUsageFlagBits::eVertexBuffer,
                 vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-                m_uniformBuffers[i],
-                m_uniformBuffersMemory[i]);
+                frame.visibleInstanceBuffer,
+                frame.visibleInstanceAllocation);
+        }
+    }
+
+    void Vulkan::DestroyVisibleInstanceBuffers()
+    {
+        for (auto& frame : m_frames)
+        {
+            if (frame.visibleInstanceBuffer)
+            {
+                DestroyBuffer(frame.visibleInstanceBuffer, frame.visibleInstanceAllocation);
+            }
+        }
+    }
+
+    void Vulkan::SetFramesInFlight(uint32_t framesCount)
+    {
+        if (framesCount < MIN_FRAMES_IN_FLIGHT || framesCount > MAX_FRAMES_IN_FLIGHT)
+        {
+            throw std::runtime_error(fmt::format("{} frames in flight requested, but only {} to {} are supported!", framesCount, MIN_FRAMES_IN_FLIGHT, MAX_FRAMES_IN_FLIGHT));
+        }
+
+        if (framesCount == m_framesInFlight)
+        {
+            return;
+        }
+
+        // Contexts are only recreated on request, so waiting for the device is fine here
+        WaitForDevice();
+        m_completedFrameCount = m_submittedFrameCount;
+        ReleaseRetiredSwapChains();
+
+        const bool hasVisibleInstanceBuffers = static_cast<bool>(m_frames.front().visibleInstanceBuffer);
+        DestroyFrameContexts();
+
+        m_framesInFlight = framesCount;
+        m_currentFrame = 0;
+
+        CreateFrameCommandPools();
+        CreateUniformBuffers();
+        CreateDescriptorPool();
+        CreateDescriptorSets();
+        CreateCommandBuffers();
+        CreateSyncObjects();
+
+        if (hasVisibleInstanceBuffers)
+        {
+            CreateVisibleInstanceBuffers();
+        }
+
+        if (m_isGpuDrivenRenderingEnabled)
+        {
+            SetGpuDrivenRenderingEnabled(true);
+        }
+
+        spdlog::info("Rendering with {} frames in flight", m_framesInFlight);
+    }
+
+    uint32_t Vulkan::GetFramesInFlight() const
+    {
+        return m_framesInFlight;
+    }
+
+    void Vulkan::DestroyFrameContexts()
+    {
+        DestroyVisibleInstanceBuffers();
+
+        // Both of them keep resources per frame in flight
+        m_secondaryCommandRecorder.reset();
+        m_gpuCuller.reset();
+
+        for (const auto& frame : m_frames)
+        {
+            m_logicalDevice->destroySemaphore(frame.imageAvailableSemaphore);
+            m_logicalDevice->destroySemaphore(frame.renderFinishedSemaphore);
+            m_logicalDevice->destroyFence(frame.inFlightFence);
+
+            // Destroying the pool frees the command buffer allocated from it
+            m_logicalDevice->destroyCommandPool(frame.commandPool);
+            m_gpuProfiler->ReleaseSlot(frame.profilerSlot);
+        }
+        m_frames.clear();
+
+        m_uniformRingBuffer.reset();
+        m_logicalDevice->destroyDescriptorPool(m_descriptorPool);
+        m_descriptorPool = vk::DescriptorPool();
+    }
+
+    void Vulkan::SetDrawCount(uint32_t drawCount)
+    {
+        const uint32_t trianglesCount = m_mesh.GetIndexCount() / 3;
+        drawCount = std::clamp(drawCount, 1u, std::max(trianglesCount, 1u));
+
+        m_drawCommands.clear();
+        m_drawCommands.reserve(drawCount);
+        for (uint32_t draw = 0; draw < drawCount; ++draw)
+        {
+            const auto firstTriangle = static_cast<uint32_t>(static_cast<uint64_t>(trianglesCount) * draw / drawCount);
+            const auto lastTriangle = static_cast<uint32_t>(static_cast<uint64_t>(trianglesCount) * (draw + 1) / drawCount);
+
+            vk::DrawIndexedIndirectCommand drawCommand;
+            drawCommand.indexCount = (lastTriangle - firstTriangle) * 3;
+            drawCommand.instanceCount = m_instanceCount;
+            drawCommand.firstIndex = firstTriangle * 3;
+            drawCommand.vertexOffset = 0;
+            drawCommand.firstInstance = 0;
+            m_drawCommands.push_back(drawCommand);
         }
     }
 
+    void Vulkan::SetParallelRecordingEnabled(bool isEnabled)
+    {
+        m_isParallelRecordingEnabled = isEnabled;
+    }
+
+    void Vulkan::CreateUniformBuffers()
+    {
+        const auto minOffsetAlignment = m_physicalDevice.getProperties().limits.minUniformBufferOffsetAlignment;
+        const auto numberOfFrames = static_cast<uint32_t>(m_frames.size());
+
+        m_uniformRingBuffer = std::make_unique<UniformRingBuffer>(m_logicalDevice, *m_allocator, minOffsetAlignment, numberOfFrames, UNIFORM_RING_FRAME_SIZE);
+    }
+
     void Vulkan::CreateDescriptorPool()
     {
-        vk::DescriptorPoolSize uboSize(vk::DescriptorType::eUniformBuffer, m_swapChainImages.size());
-        vk::DescriptorPoolSize samplerSize(vk::DescriptorType::eCombinedImageSampler, m_swapChainImages.size());
-        const std::array<vk::DescriptorPoolSize, 2> poolSizes = {uboSize, samplerSize};
+        vk::DescriptorPoolSize uboSize(vk::DescriptorType::eUniformBufferDynamic, m_frames.size());
+        vk::DescriptorPoolSize samplerSize(vk::DescriptorType::eCombinedImageSampler, m_frames.size());
+        std::vector<vk::DescriptorPoolSize> poolSizes = {uboSize};
+        if (!m_bindlessTextureTable)
+        {
+            poolSizes.push_back(samplerSize);
+        }
 
         vk::DescriptorPoolCreateInfo dpCreateInfo;
         dpCreateInfo.setPoolSizes(poolSizes);
-        dpCreateInfo.setMaxSets(m_swapChainImages.size());
+        dpCreateInfo.setMaxSets(m_frames.size());
 
         m_descriptorPool = m_logicalDevice->createDescriptorPool(dpCreateInfo);
     }
 
     void Vulkan::CreateDescriptorSets()
     {
-        std::vector<vk::DescriptorSetLayout> descriptorSetLayouts(m_swapChainImages.size(), m_descriptorSetLayout);
+        std::vector<vk::DescriptorSetLayout> descriptorSetLayouts(m_frames.size(), m_descriptorSetLayout);
         vk::DescriptorSetAllocateInfo allocInfo;
         allocInfo.setDescriptorPool(m_descriptorPool);
-        allocInfo.setDescriptorSetCount(static_cast<uint32_t>(m_swapChainImages.size()));
+        allocInfo.setDescriptorSetCount(static_cast<uint32_t>(m_frames.size()));
         allocInfo.setSetLayouts(descriptorSetLayouts);
 
-        m_descriptorSets = m_logicalDevice->allocateDescriptorSets(allocInfo);
+        const auto descriptorSets = m_logicalDevice->allocateDescriptorSets(allocInfo);
 
-        for (std::size_t i = 0; i < m_swapChainImages.size(); ++i)
+        for (std::size_t i = 0; i < m_frames.size(); ++i)
         {
+            m_frames[i].descriptorSet = descriptorSets[i];
+
             vk::DescriptorBufferInfo bufferInfo;
-            bufferInfo.setBuffer(m_uniformBuffers[i]);
+            bufferInfo.setBuffer(m_uniformRingBuffer->GetBuffer());
             bufferInfo.setOffset(0);
             bufferInfo.setRange(sizeof(m_mvpUBO));
 
-            vk::DescriptorImageInfo imageInfo;
-            imageInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
-            imageInfo.setImageView(m_textureImageView);
-            imageInfo.setSampler(m_textureSampler);
-
             vk::WriteDescriptorSet bufferDescriptorWrite;
-            bufferDescriptorWrite.setDstSet(m_descriptorSets[i]);
+            bufferDescriptorWrite.setDstSet(m_frames[i].descriptorSet);
             bufferDescriptorWrite.setDstBinding(0);
             bufferDescriptorWrite.setDstArrayElement(0);
-            bufferDescriptorWrite.setDescriptorType(vk::DescriptorType::eUniformBuffer);
+            bufferDescriptorWrite.setDescriptorType(vk::DescriptorType::eUniformBufferDynamic);
             bufferDescriptorWrite.setDescriptorCount(1);
             bufferDescriptorWrite.setBufferInfo(bufferInfo);
 
-            vk::WriteDescriptorSet imageSamplerDescriptorWrite;
-            imageSamplerDescriptorWrite.setDstSet(m_descriptorSets[i]);
-            imageSamplerDescriptorWrite.setDstBinding(1);
-            imageSamplerDescriptorWrite.setDstArrayElement(0);
-            imageSamplerDescriptorWrite.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-            imageSamplerDescriptorWrite.setDescriptorCount(1);
-            imageSamplerDescriptorWrite.setImageInfo(imageInfo);
-
-            const std::array<vk::WriteDescriptorSet, 2> descriptorWrites = {bufferDescriptorWrite, imageSamplerDescriptorWrite};
-            m_logicalDevice->updateDescriptorSets(descriptorWrites, {});
+            m_logicalDevice->updateDescriptorSets(bufferDescriptorWrite, {});
+            if (!m_bindlessTextureTable)
+            {
+                WriteTextureDescriptor(m_frames[i]);
+            }
         }
     }
 
-    void Vulkan::CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Buffer& buffer, vk::DeviceMemory& bufferMemory)
+    void Vulkan::WriteTextureDescriptor(FrameContext& frame)
+    {
+        frame.boundTextureView = GetTextureView();
+
+        vk::DescriptorImageInfo imageInfo;
+        imageInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        imageInfo.setImageView(frame.boundTextureView);
+        imageInfo.setSampler(m_textureSampler);
+
+        vk::WriteDescriptorSet imageSamplerDescriptorWrite;
+        imageSamplerDescriptorWrite.setDstSet(frame.descriptorSet);
+        imageSamplerDescriptorWrite.setDstBinding(1);
+        imageSamplerDescriptorWrite.setDstArrayElement(0);
+        imageSamplerDescriptorWrite.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+        imageSamplerDescriptorWrite.setDescriptorCount(1);
+        imageSamplerDescriptorWrite.setImageInfo(imageInfo);
+
+        m_logicalDevice->updateDescriptorSets(imageSamplerDescriptorWrite, {});
+    }
+
+    vk::ImageView Vulkan::GetTextureView() const
+    {
+        return m_textureCache->GetView(m_textureId);
+    }
+
+    void Vulkan::CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Buffer& buffer, Allocation& bufferAllocation, AllocationStrategy strategy)
     {
         vk::BufferCreateInfo bufferCreateInfo;
         bufferCreateInfo.setSize(size);
@@ -845,38 +1557,25 @@ namespace vr
         bufferCreateInfo.setSharingMode(vk::SharingMode::eExclusive);
 
         buffer = m_logicalDevice->createBuffer(bufferCreateInfo);
-
-        const auto bufferMemoryRequirements = m_logicalDevice->getBufferMemoryRequirements(buffer);
-        vk::MemoryAllocateInfo memoryAllocateInfo;
-        memoryAllocateInfo.setAllocationSize(bufferMemoryRequirements.size);
-        memoryAllocateInfo.setMemoryTypeIndex(
-            FindMemoryType(bufferMemoryRequirements.memoryTypeBits, properties));
-
-        bufferMemory = m_logicalDevice->allocateMemory(memoryAllocateInfo);
-        m_logicalDevice->bindBufferMemory(buffer, bufferMemory, 0);
+        bufferAllocation = m_allocator->AllocateForBuffer(buffer, properties, strategy);
     }
 
-    void Vulkan::CopyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size)
+    void Vulkan::DestroyBuffer(vk::Buffer& buffer, Allocation& bufferAllocation)
     {
-        auto transferCommandBuffer = BeginSingleTimeCommands();
-        {
-            vk::BufferCopy copyInfo;
-            copyInfo.setSrcOffset(0);
-            copyInfo.setDstOffset(0);
-            copyInfo.setSize(size);
-            transferCommandBuffer.copyBuffer(srcBuffer, dstBuffer, copyInfo);
-        }
-        EndSingleTimeCommands(std::move(transferCommandBuffer));
+        m_logicalDevice->destroyBuffer(buffer);
+        m_allocator->Free(bufferAllocation);
+        buffer = vk::Buffer();
     }
 
-    void Vulkan::CreateImage(uint32_t width, uint32_t height, vk::SampleCountFlagBits numSamples, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Image& image, vk::DeviceMemory& imageMemory)
+    void Vulkan::CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels, vk::SampleCountFlagBits numSamples, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Image& image, Allocation& imageAllocation, vk::ImageCreateFlags flags)
     {
         vk::Extent3D imageExtent(width, height, 1);
 
         vk::ImageCreateInfo imageInfo;
         imageInfo.setImageType(vk::ImageType::e2D);
         imageInfo.setExtent(imageExtent);
-        imageInfo.setMipLevels(1);
+        imageInfo.setFlags(flags);
+        imageInfo.setMipLevels(mipLevels);
         imageInfo.setArrayLayers(1);
         imageInfo.setFormat(format);
         imageInfo.setTiling(tiling);
@@ -886,120 +1585,24 @@ namespace vr
         imageInfo.setSamples(numSamples);
 
         image = m_logicalDevice->createImage(imageInfo);
-        const auto memRequirements = m_logicalDevice->getImageMemoryRequirements(image);
-        vk::MemoryAllocateInfo allocInfo;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-        imageMemory = m_logicalDevice->allocateMemory(allocInfo);
-        m_logicalDevice->bindImageMemory(image, imageMemory, 0);
-    }
-
-    void Vulkan::TransitionImageLayout(vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout)
-    {
-        auto commandBuffer = BeginSingleTimeCommands();
-        {
-            vk::ImageSubresourceRange subresourceRange;
-            subresourceRange.setAspectMask(vk::ImageAspectFlagBits::eColor);
-            subresourceRange.setBaseMipLevel(0);
-            subresourceRange.setLevelCount(1);
-            subresourceRange.setBaseArrayLayer(0);
-            subresourceRange.setLayerCount(1);
-
-            vk::ImageMemoryBarrier memoryBarrier;
-            memoryBarrier.setOldLayout(oldLayout);
-            memoryBarrier.setNewLayout(newLayout);
-            memoryBarrier.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
-            memoryBarrier.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
-            memoryBarrier.setImage(image);
-            memoryBarrier.setSubresourceRange(subresourceRange);
-
-            vk::PipelineStageFlags sourceStage;
-            vk::PipelineStageFlags destinationStage;
-
-            if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eTransferDstOptimal)
-            {
-                memoryBarrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-
-                sourceStage = vk::PipelineStageFlagBits::eTopOfPipe;
-                destinationStage = vk::PipelineStageFlagBits::eTransfer;
-            }
-            else if (oldLayout == vk::ImageLayout::eTransferDstOptimal && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal)
-            {
-                memoryBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-                memoryBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-
-                sourceStage = vk::PipelineStageFlagBits::eTransfer;
-                destinationStage = vk::PipelineStageFlagBits::eFragmentShader;
-            }
-            else
-            {
-                throw std::invalid_argument("Unsupported layout transition!");
-            }
-
-            commandBuffer.pipelineBarrier(sourceStage, destinationStage, {}, {}, {}, memoryBarrier);
-        }
-        EndSingleTimeCommands(std::move(commandBuffer));
-    }
-
-    void Vulkan::CopyBufferToImage(vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height)
-    {
-        auto commandBuffer = BeginSingleTimeCommands();
-        {
-            vk::BufferImageCopy region;
-            region.bufferOffset = 0;
-            region.bufferRowLength = 0;
-            region.bufferImageHeight = 0;
-
-            region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-            region.imageSubresource.mipLevel = 0;
-            region.imageSubresource.baseArrayLayer = 0;
-            region.imageSubresource.layerCount = 1;
-
-            region.imageOffset = vk::Offset3D(0, 0, 0);
-            region.imageExtent = vk::Extent3D(width, height, 1);
-
-            commandBuffer.copyBufferToImage(buffer, image, vk::ImageLayout::eTransferDstOptimal, region);
-        }
-        EndSingleTimeCommands(std::move(commandBuffer));
-    }
-
-    vk::CommandBuffer Vulkan::BeginSingleTimeCommands()
-    {
-        vk::CommandBufferAllocateInfo allocInfo;
-        allocInfo.setLevel(vk::CommandBufferLevel::ePrimary);
-        allocInfo.setCommandPool(m_commandPool);
-        allocInfo.setCommandBufferCount(1);
-
-        const auto commandBuffer = m_logicalDevice->allocateCommandBuffers(allocInfo)[0];
-
-        const vk::CommandBufferBeginInfo beginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-        commandBuffer.begin(beginInfo);
-
-        return commandBuffer;
+        imageAllocation = m_allocator->AllocateForImage(image, properties);
     }
 
-    void Vulkan::EndSingleTimeCommands(vk::CommandBuffer commandBuffer)
+    void Vulkan::DestroyImage(vk::Image& image, Allocation& imageAllocation)
     {
-        commandBuffer.end();
-
-        vk::SubmitInfo submitInfo;
-        submitInfo.setCommandBuffers(commandBuffer);
-
-        m_graphicsQueue.submit(submitInfo, vk::Fence());
-        m_graphicsQueue.waitIdle();
-
-        m_logicalDevice->freeCommandBuffers(m_commandPool, commandBuffer);
+        m_logicalDevice->destroyImage(image);
+        m_allocator->Free(imageAllocation);
+        image = vk::Image();
     }
 
-    vk::ImageView Vulkan::CreateImageView(vk::Image image, vk::Format format, vk::ImageAspectFlags aspectFlags)
+    vk::ImageView Vulkan::CreateImageView(vk::Image image, vk::Format format, vk::ImageAspectFlags aspectFlags, uint32_t mipLevels)
     {
         const vk::ComponentMapping componentMapping;
         vk::ImageSubresourceRange subresourceRange(vk::ImageAspectFlagBits::eColor);
         subresourceRange
             .setAspectMask(aspectFlags)
             .setBaseMipLevel(0)
-            .setLevelCount(1)
+            .setLevelCount(mipLevels)
             .setBaseArrayLayer(0)
             .setLayerCount(1);
 
@@ -1026,12 +1629,7 @@ namespace vr
     {
         for (const auto format : candidates)
         {
-            const auto props = m_physicalDevice.getFormatProperties(format);
-            if (tiling == vk::ImageTiling::eLinear && (props.linearTilingFeatures & features) == features)
-            {
-                return format;
-            }
-            else if (tiling == vk::ImageTiling::eOptimal && (props.optimalTilingFeatures & features) == features)
+            if (IsFormatSupported(format, tiling, features))
             {
                 return format;
             }
@@ -1040,6 +1638,17 @@ namespace vr
         throw std::runtime_error("Failed to find supported format!");
     }
 
+    bool Vulkan::IsFormatSupported(vk::Format format, vk::ImageTiling tiling, vk::FormatFeatureFlags features)
+    {
+        const auto props = m_physicalDevice.getFormatProperties(format);
+        if (tiling == vk::ImageTiling::eLinear)
+        {
+            return (props.linearTilingFeatures & features) == features;
+        }
+
+        return (props.optimalTilingFeatures & features) == features;
+    }
+
     bool Vulkan::HasStencilComponent(vk::Format format)
     {
         return format == vk::Format::eD32SfloatS8Uint || format == vk::Format::eD24UnormS8Uint;
@@ -1047,12 +1656,15 @@ namespace vr
 
     std::vector<const char*> Vulkan::GetRequiredInstanceExtensions()
     {
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
+        std::vector<const char*> extensions;
 
-        // These are the extensions required by glfw
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        // These are the extensions required by glfw. The headless mode needs neither glfw nor the surface extensions
+        if (!m_isHeadless)
+        {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         // Additional Debug extensions
         if (VR_ENABLE_VALIDATION_LAYERS)
@@ -1063,6 +1675,17 @@ namespace vr
         return extensions;
     }
 
+    std::vector<const char*> Vulkan::GetRequiredDeviceExtensions() const
+    {
+        auto extensions = VR_REQUIRED_DEVICE_EXTENSIONS;
+        if (!m_isHeadless)
+        {
+            extensions.insert(extensions.end(), VR_PRESENTATION_DEVICE_EXTENSIONS.begin(), VR_PRESENTATION_DEVICE_EXTENSIONS.end());
+        }
+
+        return extensions;
+    }
+
     void Vulkan::CheckIfValidationLayersAreAvailable()
     {
         const auto availableLayers = vk::enumerateInstanceLayerProperties();
@@ -1126,6 +1749,9 @@ namespace vr
     QueueFamilies Vulkan::GetDeviceQueueFamilies(const vk::PhysicalDevice& device)
     {
         QueueFamilies deviceFamilies;
+        std::optional<uint32_t> transferOnlyFamily;
+        std::optional<uint32_t> asyncComputeFamily;
+
         const auto availableFamilies = device.getQueueFamilyProperties();
         for (uint32_t index = 0; index < availableFamilies.size(); ++index)
         {
@@ -1134,26 +1760,54 @@ namespace vr
                 continue;
             }
 
+            const auto queueFlags = availableFamilies[index].queueFlags;
+
             // Check support for graphics queue
-            if (availableFamilies[index].queueFlags & vk::QueueFlagBits::eGraphics)
+            if (queueFlags & vk::QueueFlagBits::eGraphics)
             {
                 deviceFamilies.graphicsFamily = index;
             }
 
             // Check support for presentation queue
-            if (device.getSurfaceSupportKHR(index, m_surface))
+            if (!m_isHeadless && device.getSurfaceSupportKHR(index, m_surface))
             {
                 deviceFamilies.presentationFamily = index;
             }
+
+            // Families without graphics capabilities map to the DMA engines or async compute, so they do not compete with rendering.
+            // Graphics and compute families support transfers implicitly
+            if (!(queueFlags & vk::QueueFlagBits::eGraphics))
+            {
+                if (queueFlags & vk::QueueFlagBits::eCompute)
+                {
+                    asyncComputeFamily = index;
+                }
+                else if (queueFlags & vk::QueueFlagBits::eTransfer)
+                {
+                    transferOnlyFamily = index;
+                }
+            }
         }
 
+        // Nothing is presented in the headless mode, so the graphics family stands in for the presentation one
+        if (m_isHeadless)
+        {
+            deviceFamilies.presentationFamily = deviceFamilies.graphicsFamily;
+        }
+
+        deviceFamilies.transferFamily = transferOnlyFamily ? transferOnlyFamily : asyncComputeFamily ? asyncComputeFamily : deviceFamilies.graphicsFamily;
+
         return deviceFamilies;
     }
 
     bool Vulkan::IsDeviceSuitable(const vk::PhysicalDevice& device, const QueueFamilies& deviceQueueFamilies)
     {
-        const auto swapChainSupport = GetSwapChainSupportDetails(device);
-        bool isSwapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
+        bool isSwapChainAdequate = true;
+        if (!m_isHeadless)
+        {
+            const auto swapChainSupport = GetSwapChainSupportDetails(device);
+            isSwapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
+        }
 
         return AreDeviceQueueFamiliesSupported(deviceQueueFamilies) && DoesDeviceSupportRequiredExtensions(device) && isSwapChainAdequate;
     }
@@ -1176,7 +1830,7 @@ namespace vr
     bool Vulkan::DoesDeviceSupportRequiredExtensions(const vk::PhysicalDevice& device)
     {
         const auto availableExtensions = device.enumerateDeviceExtensionProperties();
-        for (const auto* requiredExtension : VR_REQUIRED_DEVICE_EXTENSIONS)
+        for (const auto* requiredExtension : GetRequiredDeviceExtensions())
         {
             const auto foundIt =
                 std::find_if(availableExtensions.begin(), availableExtensions.end(), [&](const vk::ExtensionProperties& extension) {
@@ -1192,21 +1846,6 @@ namespace vr
         return true;
     }
 
-    uint32_t Vulkan::FindMemoryType(uint32_t requiredType, vk::MemoryPropertyFlags requiredProperties)
-    {
-        const auto memoryProperties = m_physicalDevice.getMemoryProperties();
-        for (uint32_t memoryIndex = 0; memoryIndex < memoryProperties.memoryTypeCount; ++memoryIndex)
-        {
-            const auto memoryTypeBit = (1 << memoryIndex);
-            if ((requiredType & memoryTypeBit) && (memoryProperties.memoryTypes[memoryIndex].propertyFlags & requiredProperties) == requiredProperties)
-            {
-                return memoryIndex;
-            }
-        }
-
-        return -1;
-    }
-
     vk::SampleCountFlagBits Vulkan::GetMaxUsableSampleCount()
     {
         const auto physicalDeviceProperties = m_physicalDevice.getProperties();
@@ -1277,14 +1916,10 @@ namespace vr
     void Vulkan::CleanupSwapChain()
     {
         m_logicalDevice->destroyImageView(m_colorImageView);
-        m_logicalDevice->freeMemory(m_colorImageMemory);
-        m_logicalDevice->destroyImage(m_colorImage);
+        DestroyImage(m_colorImage, m_colorImageAllocation);
 
         m_logicalDevice->destroyImageView(m_depthImageView);
-        m_logicalDevice->freeMemory(m_depthImageMemory);
-        m_logicalDevice->destroyImage(m_depthImage);
-
-        m_logicalDevice->freeCommandBuffers(m_commandPool, m_commandBuffers);
+        DestroyImage(m_depthImage, m_depthImageAllocation);
 
         for (auto framebuffer : m_swapChainFramebuffers)
         {
@@ -1293,10 +1928,6 @@ namespace vr
         m_swapChainFramebuffers.clear();
         m_swapChainFramebuffers.resize(0);
 
-        m_logicalDevice->destroyPipeline(m_pipeline);
-        m_logicalDevice->destroyPipelineLayout(m_pipelineLayout);
-        m_logicalDevice->destroyRenderPass(m_renderPass);
-
         for (auto imageView : m_swapChainImageViews)
         {
             m_logicalDevice->destroyImageView(std::move(imageView));
@@ -1309,51 +1940,99 @@ namespace vr
             m_logicalDevice->destroySwapchainKHR(m_swapChain);
         }
 
-        for (std::size_t i = 0; i < m_swapChainImages.size(); ++i)
+        for (std::size_t i = 0; i < m_offscreenImageAllocations.size(); ++i)
         {
-            m_logicalDevice->freeMemory(m_uniformBuffersMemory[i]);
-            m_logicalDevice->destroyBuffer(m_uniformBuffers[i]);
+            DestroyImage(m_swapChainImages[i], m_offscreenImageAllocations[i]);
         }
-
-        m_logicalDevice->destroyDescriptorPool(m_descriptorPool);
+        m_offscreenImageAllocations.clear();
+        m_swapChainImages.clear();
     }
 
-    Vulkan::~Vulkan()
+    void Vulkan::DestroyRetiredSwapChain(RetiredSwapChain& retiredSwapChain)
     {
-        WaitForDevice();
-
-        for (const auto& semaphore : m_imageAvailableSemaphores)
+        for (auto framebuffer : retiredSwapChain.framebuffers)
         {
-            m_logicalDevice->destroySemaphore(semaphore);
+            m_logicalDevice->destroyFramebuffer(framebuffer);
         }
 
-        for (const auto& semaphore : m_renderFinishedSemaphores)
+        for (auto imageView : retiredSwapChain.imageViews)
         {
-            m_logicalDevice->destroySemaphore(semaphore);
+            m_logicalDevice->destroyImageView(imageView);
         }
 
-        for (const auto& fence : m_inFlightFences)
+        m_logicalDevice->destroyImageView(retiredSwapChain.colorImageView);
+        DestroyImage(retiredSwapChain.colorImage, retiredSwapChain.colorImageAllocation);
+        m_logicalDevice->destroyImageView(retiredSwapChain.depthImageView);
+        DestroyImage(retiredSwapChain.depthImage, retiredSwapChain.depthImageAllocation);
+
+        m_logicalDevice->destroyPipeline(retiredSwapChain.pipeline);
+        m_logicalDevice->destroyPipelineLayout(retiredSwapChain.pipelineLayout);
+        m_logicalDevice->destroyRenderPass(retiredSwapChain.renderPass);
+
+        m_logicalDevice->destroySwapchainKHR(retiredSwapChain.swapChain);
+    }
+
+    void Vulkan::ReleaseRetiredSwapChains()
+    {
+        // Resources are retired in the submission order, so the completed ones are always at the front
+        std::size_t releasedCount = 0;
+        while (releasedCount < m_retiredSwapChains.size() && m_retiredSwapChains[releasedCount].lastSubmission <= m_completedFrameCount)
         {
-            m_logicalDevice->destroyFence(fence);
+            DestroyRetiredSwapChain(m_retiredSwapChains[releasedCount++]);
         }
 
+        m_retiredSwapChains.erase(m_retiredSwapChains.begin(), m_retiredSwapChains.begin() + releasedCount);
+    }
+
+    void Vulkan::DestroyGraphicsPipeline()
+    {
+        m_logicalDevice->destroyPipeline(m_pipeline);
+        m_logicalDevice->destroyPipelineLayout(m_pipelineLayout);
+        m_logicalDevice->destroyRenderPass(m_renderPass);
+    }
+
+    Vulkan::~Vulkan()
+    {
+        WaitForDevice();
+
+        // The device is idle, so every submitted frame has completed
+        m_completedFrameCount = m_submittedFrameCount;
+        ReleaseRetiredSwapChains();
+
         CleanupSwapChain();
+        DestroyGraphicsPipeline();
 
         m_logicalDevice->destroySampler(m_textureSampler);
-        m_logicalDevice->destroyImageView(m_textureImageView);
-        m_logicalDevice->destroyImage(m_textureImage);
-        m_logicalDevice->freeMemory(m_textureImageMemory);
+        // The texture is not acquired if the initialization failed before it
+        if (m_textureCache && m_textureId != TextureCache::INVALID_ID)
+        {
+            m_textureCache->Release(m_textureId);
+        }
 
         m_logicalDevice->destroyDescriptorSetLayout(m_descriptorSetLayout);
 
-        m_logicalDevice->freeMemory(m_vertexBufferMemory);
-        m_logicalDevice->destroyBuffer(m_vertexBuffer);
-        m_logicalDevice->freeMemory(m_indexBufferMemory);
-        m_logicalDevice->destroyBuffer(m_indexBuffer);
+        DestroyBuffer(m_vertexBuffer, m_vertexBufferAllocation);
+        DestroyBuffer(m_constantVertexAttributesBuffer, m_constantVertexAttributesBufferAllocation);
+        DestroyBuffer(m_indexBuffer, m_indexBufferAllocation);
+        DestroyBuffer(m_instanceBuffer, m_instanceBufferAllocation);
+        DestroyBuffer(m_objectBoundsBuffer, m_objectBoundsBufferAllocation);
+        DestroyFrameContexts();
 
-        m_logicalDevice->destroyCommandPool(m_commandPool);
+        m_textureCache.reset();
+        m_bindlessTextureTable.reset();
+        m_textureStreamer.reset();
+        m_uploadBatcher.reset();
+        m_mipmapGenerator.reset();
+
+        m_gpuProfiler.reset();
+        m_pipelineCache.reset();
+        m_allocator.reset();
 
         m_instance->destroyDebugUtilsMessengerEXT(m_debugMessenger, nullptr, m_dldi);
-        m_instance->destroySurfaceKHR(m_surface);
+        // The headless mode has no surface, and its instance lacks the surface extension
+        if (!m_isHeadless)
+        {
+            m_instance->destroySurfaceKHR(m_surface);
+        }
     }
 } // namespace vr
\ No newline at end of file
@@ -7,16 +7,76 @@
 // STL includes
 #include <stdexcept>
 #include <cstdlib>
+#include <string>
 
-int main(int, char**)
+int main(int argc, char** argv)
 {
     const int WIDTH = 800;
     const int HEIGHT = 600;
 
+    /** Number of frames rendered in the headless mode if not given with --frames */
+    const uint32_t DEFAULT_HEADLESS_FRAME_COUNT = 1000;
+
     try
     {
-        vr::Application app(WIDTH, HEIGHT);
-        app.Run();
+        bool isHeadless = false;
+        uint32_t frameCount = 0;
+        bool isFrameCountGiven = false;
+        uint32_t instanceCount = 1;
+        bool isGpuDriven = false;
+        bool isCpuCulling = false;
+        uint32_t framesInFlight = vr::Vulkan::DEFAULT_FRAMES_IN_FLIGHT;
+        vk::DeviceSize textureBudget = vr::TextureCache::DEFAULT_BUDGET;
+        for (int argument = 1; argument < argc; ++argument)
+        {
+            const std::string value = argv[argument];
+            if (value == "--headless")
+            {
+                isHeadless = true;
+            }
+            else if (value == "--frames" && argument + 1 < argc)
+            {
+                frameCount = static_cast<uint32_t>(std::stoul(argv[++argument]));
+                isFrameCountGiven = true;
+            }
+            else if (value == "--instances" && argument + 1 < argc)
+            {
+                instanceCount = static_cast<uint32_t>(std::stoul(argv[++argument]));
+            }
+            else if (value == "--gpu-driven")
+            {
+                isGpuDriven = true;
+            }
+            else if (value == "--cpu-culling")
+            {
+                isCpuCulling = true;
+            }
+            else if (value == "--frames-in-flight" && argument + 1 < argc)
+            {
+                framesInFlight = static_cast<uint32_t>(std::stoul(argv[++argument]));
+            }
+            else if (value == "--texture-budget" && argument + 1 < argc)
+            {
+                textureBudget = static_cast<vk::DeviceSize>(std::stoull(argv[++argument])) * 1024 * 1024;
+            }
+            else
+            {
+                spdlog::warn("Unknown argument '{}'. Usage: VulkanRenderer [--headless] [--frames <count>] [--instances <count>] [--gpu-driven] [--cpu-culling] [--frames-in-flight <1-4>] [--texture-budget <MiB>]", value);
+            }
+        }
+
+        if (isHeadless && !isFrameCountGiven)
+        {
+            frameCount = DEFAULT_HEADLESS_FRAME_COUNT;
+        }
+
+        vr::Application app(WIDTH, HEIGHT, isHeadless);
+        app.GetVulkan().SetInstanceCount(instanceCount);
+        app.GetVulkan().SetGpuDrivenRenderingEnabled(isGpuDriven);
+        app.GetVulkan().SetCpuCullingEnabled(isCpuCulling);
+        app.GetVulkan().SetFramesInFlight(framesInFlight);
+        app.GetVulkan().SetTextureBudget(textureBudget);
+        app.Run(frameCount);
     }
     catch (const std::exception& e)
     {
@@ -26,4 +86,4 @@ int main(int, char**)
     spdlog::info("Application terminated successfully");
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}